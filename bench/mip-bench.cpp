@@ -0,0 +1,332 @@
+#include "texture-cache.hpp"
+#include "texture-image.hpp"
+
+#include <sys/resource.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// The size of the textures the scene ships with.
+#define DEFAULT_IMAGE_WIDTH 1500
+#define DEFAULT_IMAGE_HEIGHT 2000
+#define DEFAULT_REPEAT_COUNT 3
+#define GENERATOR_SEED 1234
+
+struct BenchOptions
+{
+    int width = DEFAULT_IMAGE_WIDTH;
+    int height = DEFAULT_IMAGE_HEIGHT;
+    unsigned int repeatCount = DEFAULT_REPEAT_COUNT;
+    std::string inputPath;
+    bool csv = false;
+};
+
+struct BenchMethod
+{
+    std::string name;
+    std::function<size_t ()> run;
+};
+
+static void printUsage ()
+{
+    std::cout
+        << "usage: mip-bench [options]\n"
+        << "  --width N       width of the generated image (" << DEFAULT_IMAGE_WIDTH << ")\n"
+        << "  --height N      height of the generated image (" << DEFAULT_IMAGE_HEIGHT << ")\n"
+        << "  --input FILE    benchmark an existing image instead, including its decode\n"
+        << "  --repeat N      timed runs per method (" << DEFAULT_REPEAT_COUNT << ")\n"
+        << "  --csv           print comma separated results\n"
+        << "glGenerateMipmap needs a context and is not timed here; 'decode' is what\n"
+        << "that path paid on the CPU every launch, 'cache' what a cached chain costs.\n";
+}
+
+[[noreturn]] static void reportArgumentError (const std::string& message)
+{
+    std::cerr << "Bench Argument Error: " << message << std::endl;
+    printUsage();
+    exit(-1);
+}
+
+static BenchOptions parseArguments (int argc, char** argv)
+{
+    BenchOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc)
+            {
+                reportArgumentError("missing value for " + argument);
+            }
+
+            return argv[++i];
+        };
+
+        if (argument == "--width")
+        {
+            options.width = std::stoi(value());
+        }
+        else if (argument == "--height")
+        {
+            options.height = std::stoi(value());
+        }
+        else if (argument == "--input")
+        {
+            options.inputPath = value();
+        }
+        else if (argument == "--repeat")
+        {
+            options.repeatCount = std::max(1ul, std::stoul(value()));
+        }
+        else if (argument == "--csv")
+        {
+            options.csv = true;
+        }
+        else if (argument == "--help" || argument == "-h")
+        {
+            printUsage();
+            exit(0);
+        }
+        else
+        {
+            reportArgumentError("unknown option '" + argument + "'");
+        }
+    }
+
+    if (options.width < 1 || options.height < 1)
+    {
+        reportArgumentError("the image needs at least one pixel");
+    }
+
+    return options;
+}
+
+/* Smooth gradients with noise on top and a soft alpha edge across the middle,
+ * so both the colour and the alpha handling have something to do. */
+static std::vector<unsigned char> generateImage (int width, int height)
+{
+    std::vector<unsigned char> pixels ((size_t) width * height * TEXTURE_IMAGE_CHANNELS);
+    std::mt19937 generator (GENERATOR_SEED);
+    std::uniform_int_distribution<int> noise (-24, 24);
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            unsigned char* pixel = pixels.data() + ((size_t) y * width + x) * TEXTURE_IMAGE_CHANNELS;
+            float u = (float) x / width;
+            float v = (float) y / height;
+
+            pixel[0] = (unsigned char) std::clamp((int)(255.0f * u) + noise(generator), 0, 255);
+            pixel[1] = (unsigned char) std::clamp((int)(255.0f * v) + noise(generator), 0, 255);
+            pixel[2] = (unsigned char) std::clamp((int)(127.5f + 127.5f * std::sin(20.0f * u) * std::cos(20.0f * v)) + noise(generator), 0, 255);
+            pixel[3] = (unsigned char) std::clamp((int)(255.0f * (0.5f + 4.0f * (u - 0.5f))), 0, 255);
+        }
+    }
+
+    return pixels;
+}
+
+/* The chain as it was built before the SIMD paths, one channel at a time. */
+static std::vector<ImageLevel> generateScalarBoxChain (const unsigned char* pixels, int width, int height)
+{
+    std::vector<ImageLevel> levels (getMipLevelCount(width, height));
+
+    levels[0] = { width, height, std::vector<unsigned char>(pixels, pixels + (size_t) width * height * TEXTURE_IMAGE_CHANNELS) };
+
+    for (size_t i = 1; i < levels.size(); ++i)
+    {
+        const ImageLevel& previous = levels[i - 1];
+        ImageLevel& level = levels[i];
+
+        level.width = std::max(previous.width / 2, 1);
+        level.height = std::max(previous.height / 2, 1);
+        level.data.resize((size_t) level.width * level.height * TEXTURE_IMAGE_CHANNELS);
+
+        for (int y = 0; y < level.height; ++y)
+        {
+            const unsigned char* row0 = previous.data.data() + (size_t) std::min(2 * y, previous.height - 1) * previous.width * TEXTURE_IMAGE_CHANNELS;
+            const unsigned char* row1 = previous.data.data() + (size_t) std::min(2 * y + 1, previous.height - 1) * previous.width * TEXTURE_IMAGE_CHANNELS;
+
+            for (int x = 0; x < level.width; ++x)
+            {
+                int x0 = std::min(2 * x, previous.width - 1) * TEXTURE_IMAGE_CHANNELS;
+                int x1 = std::min(2 * x + 1, previous.width - 1) * TEXTURE_IMAGE_CHANNELS;
+                unsigned char* target = level.data.data() + ((size_t) y * level.width + x) * TEXTURE_IMAGE_CHANNELS;
+
+                for (int c = 0; c < TEXTURE_IMAGE_CHANNELS; ++c)
+                {
+                    target[c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4;
+                }
+            }
+        }
+    }
+
+    return levels;
+}
+
+static size_t getChainSize (const std::vector<ImageLevel>& levels)
+{
+    size_t size = 0;
+
+    for (const ImageLevel& level : levels)
+    {
+        size += level.data.size();
+    }
+
+    return size;
+}
+
+static double getPeakResidentMegabytes ()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+}
+
+int main (int argc, char** argv)
+{
+    BenchOptions options = parseArguments(argc, argv);
+    std::vector<unsigned char> pixels;
+    int width = options.width;
+    int height = options.height;
+
+    // The cache is validated against a source file, so a generated image gets
+    // its pixels written out to stand in for one.
+    std::string sourcePath = options.inputPath;
+    bool generated = sourcePath.empty();
+
+    if (generated)
+    {
+        pixels = generateImage(width, height);
+        sourcePath = "/tmp/mip-bench-" + std::to_string(getpid()) + ".rgba";
+        std::ofstream(sourcePath, std::ios::binary).write((const char*) pixels.data(), pixels.size());
+    }
+    else
+    {
+        TextureImage image;
+
+        if (!decodeTextureImage(sourcePath.c_str(), image))
+        {
+            std::cerr << "Bench Read Error for '" << sourcePath << "': could not decode image" << std::endl;
+            return -1;
+        }
+
+        width = image.width;
+        height = image.height;
+        pixels.assign(image.pixels.get(), image.pixels.get() + (size_t) width * height * TEXTURE_IMAGE_CHANNELS);
+    }
+
+    std::string cachePath = "/tmp/mip-bench-" + std::to_string(getpid()) + TEXTURE_CACHE_EXTENSION;
+    TextureCache::write(cachePath.c_str(), sourcePath.c_str(), COMPRESSED_FORMAT_RGBA8, getMipChainFlags(MipChainOptions()), generateMipChain(pixels.data(), width, height));
+
+    auto chain = [&](MipFilter filter, bool srgb, bool premultiplyAlpha) {
+        MipChainOptions mipOptions;
+        mipOptions.filter = filter;
+        mipOptions.srgb = srgb;
+        mipOptions.premultiplyAlpha = premultiplyAlpha;
+
+        return [&pixels, width, height, mipOptions]() {
+            return getChainSize(generateMipChain(pixels.data(), width, height, mipOptions));
+        };
+    };
+
+    std::vector<BenchMethod> methods = {
+        { "scalar-box", [&]() { return getChainSize(generateScalarBoxChain(pixels.data(), width, height)); } },
+        { "box", chain(MIP_FILTER_BOX, false, false) },
+        { "box-srgb", chain(MIP_FILTER_BOX, true, true) },
+        { "kaiser-srgb", chain(MIP_FILTER_KAISER, true, true) },
+        { "cache", [&]() {
+            TextureCache cache (cachePath.c_str());
+            size_t checksum = cache.isValidFor(sourcePath.c_str(), getMipChainFlags(MipChainOptions())) ? 0 : 1;
+
+            // Touches one byte per page, which is what an upload would fault in.
+            for (unsigned int i = 0; i < cache.getLevelCount(); ++i)
+            {
+                for (size_t offset = 0; offset < cache.getLevel(i).dataSize; offset += 4096)
+                {
+                    checksum += cache.getLevelData(i)[offset];
+                }
+            }
+
+            return checksum;
+        } }
+    };
+
+    if (!generated)
+    {
+        methods.insert(methods.begin(), { "decode", [&]() {
+            TextureImage image;
+            decodeTextureImage(sourcePath.c_str(), image);
+            return (size_t) image.width * image.height;
+        } });
+    }
+
+    double megapixels = (double) width * height / 1e6;
+
+    if (options.csv)
+    {
+        std::cout << "method,width,height,best_seconds,mean_seconds,megapixels_per_second" << std::endl;
+    }
+    else
+    {
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "image: " << (generated ? "generated" : sourcePath) << " (" << width << "x" << height << ", "
+            << getMipLevelCount(width, height) << " levels)" << std::endl;
+    }
+
+    for (const BenchMethod& method : methods)
+    {
+        double best = INFINITY;
+        double total = 0.0;
+
+        for (unsigned int i = 0; i < options.repeatCount; ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            volatile size_t result = method.run();
+            (void) result;
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            best = std::min(best, seconds);
+            total += seconds;
+        }
+
+        double mean = total / options.repeatCount;
+
+        if (options.csv)
+        {
+            std::cout << method.name << "," << width << "," << height << "," << best << "," << mean << "," << megapixels / best << std::endl;
+        }
+        else
+        {
+            std::cout << std::left << std::setw(12) << method.name << std::right
+                << " best " << std::setw(8) << best * 1000.0 << " ms, mean " << std::setw(8) << mean * 1000.0 << " ms, "
+                << std::setw(8) << megapixels / best << " Mpixel/s" << std::endl;
+        }
+    }
+
+    if (!options.csv)
+    {
+        std::cout << "peak rss: " << getPeakResidentMegabytes() << " MB" << std::endl;
+    }
+
+    std::remove(cachePath.c_str());
+
+    if (generated)
+    {
+        std::remove(sourcePath.c_str());
+    }
+
+    return 0;
+}
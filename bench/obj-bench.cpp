@@ -0,0 +1,485 @@
+#include "model-data.hpp"
+#include "obj-parser.hpp"
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define DEFAULT_GRID_SIZE 1000
+#define DEFAULT_REPEAT_COUNT 3
+#define DEFAULT_BENCH_STREAM_MEMORY_LIMIT (64 << 20)
+#define GENERATOR_SEED 1234
+
+struct BenchOptions
+{
+    unsigned int gridSize = DEFAULT_GRID_SIZE;
+    std::string layout = "grid";
+    bool uvCoordinates = true;
+    bool surfaceNormals = true;
+    bool negativeIndices = false;
+    bool quads = false;
+
+    std::string stage = "parse";
+    unsigned int threadCount = 0;
+    unsigned int repeatCount = DEFAULT_REPEAT_COUNT;
+    size_t streamMemoryLimit = DEFAULT_BENCH_STREAM_MEMORY_LIMIT;
+    bool useMeshCache = false;
+
+    std::string inputPath;
+    std::string outputPath;
+    bool keepOutput = false;
+    bool csv = false;
+};
+
+struct BenchRun
+{
+    double seconds;
+    size_t triangleCount;
+    size_t vertexCount;
+};
+
+static void printUsage ()
+{
+    std::cout
+        << "usage: obj-bench [options]\n"
+        << "  --grid N              vertices per side of the generated grid (" << DEFAULT_GRID_SIZE << ")\n"
+        << "  --layout L            grid, shuffled (random face order) or soup (no shared vertices)\n"
+        << "  --attributes A        v, vt, vn or vtvn (vtvn)\n"
+        << "  --negative            write relative (negative) indices\n"
+        << "  --quads               write quads instead of triangles\n"
+        << "  --stage S             parse (parseObjFile), model (ModelData::load) or stream (streamObjFile)\n"
+        << "  --threads N           parser threads, 0 for one per core (0)\n"
+        << "  --repeat N            timed runs (" << DEFAULT_REPEAT_COUNT << ")\n"
+        << "  --stream-limit MB     memory limit for the stream stage (" << (DEFAULT_BENCH_STREAM_MEMORY_LIMIT >> 20) << ")\n"
+        << "  --cache               let the model stage use the mesh cache\n"
+        << "  --input FILE          benchmark an existing OBJ instead of generating one\n"
+        << "  --output FILE         where to write the generated OBJ\n"
+        << "  --keep                keep the generated OBJ\n"
+        << "  --csv                 print one comma separated summary line\n";
+}
+
+[[noreturn]] static void reportArgumentError (const std::string& message)
+{
+    std::cerr << "Bench Argument Error: " << message << std::endl;
+    printUsage();
+    exit(-1);
+}
+
+static BenchOptions parseArguments (int argc, char** argv)
+{
+    BenchOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc)
+            {
+                reportArgumentError("missing value for " + argument);
+            }
+
+            return argv[++i];
+        };
+
+        if (argument == "--grid")
+        {
+            options.gridSize = std::stoul(value());
+        }
+        else if (argument == "--layout")
+        {
+            options.layout = value();
+        }
+        else if (argument == "--attributes")
+        {
+            std::string attributes = value();
+            options.uvCoordinates = attributes == "vt" || attributes == "vtvn";
+            options.surfaceNormals = attributes == "vn" || attributes == "vtvn";
+
+            if (attributes != "v" && !options.uvCoordinates && !options.surfaceNormals)
+            {
+                reportArgumentError("unknown attributes '" + attributes + "'");
+            }
+        }
+        else if (argument == "--negative")
+        {
+            options.negativeIndices = true;
+        }
+        else if (argument == "--quads")
+        {
+            options.quads = true;
+        }
+        else if (argument == "--stage")
+        {
+            options.stage = value();
+        }
+        else if (argument == "--threads")
+        {
+            options.threadCount = std::stoul(value());
+        }
+        else if (argument == "--repeat")
+        {
+            options.repeatCount = std::max(1ul, std::stoul(value()));
+        }
+        else if (argument == "--stream-limit")
+        {
+            options.streamMemoryLimit = std::stoull(value()) << 20;
+        }
+        else if (argument == "--cache")
+        {
+            options.useMeshCache = true;
+        }
+        else if (argument == "--input")
+        {
+            options.inputPath = value();
+        }
+        else if (argument == "--output")
+        {
+            options.outputPath = value();
+        }
+        else if (argument == "--keep")
+        {
+            options.keepOutput = true;
+        }
+        else if (argument == "--csv")
+        {
+            options.csv = true;
+        }
+        else if (argument == "--help" || argument == "-h")
+        {
+            printUsage();
+            exit(0);
+        }
+        else
+        {
+            reportArgumentError("unknown option '" + argument + "'");
+        }
+    }
+
+    if (options.layout != "grid" && options.layout != "shuffled" && options.layout != "soup")
+    {
+        reportArgumentError("unknown layout '" + options.layout + "'");
+    }
+
+    if (options.stage != "parse" && options.stage != "model" && options.stage != "stream")
+    {
+        reportArgumentError("unknown stage '" + options.stage + "'");
+    }
+
+    if (options.gridSize < 2)
+    {
+        reportArgumentError("the grid needs at least 2 vertices per side");
+    }
+
+    return options;
+}
+
+static void writeCorner (FILE* file, const BenchOptions& options, long index, long count)
+{
+    long written = options.negativeIndices ? index - count : index + 1;
+
+    if (options.uvCoordinates && options.surfaceNormals)
+    {
+        fprintf(file, " %ld/%ld/%ld", written, written, written);
+    }
+    else if (options.uvCoordinates)
+    {
+        fprintf(file, " %ld/%ld", written, written);
+    }
+    else if (options.surfaceNormals)
+    {
+        fprintf(file, " %ld//%ld", written, written);
+    }
+    else
+    {
+        fprintf(file, " %ld", written);
+    }
+}
+
+static void writeVertex (FILE* file, const BenchOptions& options, unsigned int column, unsigned int row)
+{
+    float u = (float) column / (options.gridSize - 1);
+    float v = (float) row / (options.gridSize - 1);
+    float height = 0.05f * std::sin(u * 12.0f) * std::cos(v * 9.0f);
+
+    fprintf(file, "v %.6f %.6f %.6f\n", u, height, v);
+
+    if (options.uvCoordinates)
+    {
+        fprintf(file, "vt %.6f %.6f\n", u, v);
+    }
+
+    if (options.surfaceNormals)
+    {
+        float nx = -0.6f * std::cos(u * 12.0f) * std::cos(v * 9.0f);
+        float nz = 0.45f * std::sin(u * 12.0f) * std::sin(v * 9.0f);
+        float length = std::sqrt(nx * nx + 1.0f + nz * nz);
+        fprintf(file, "vn %.6f %.6f %.6f\n", nx / length, 1.0f / length, nz / length);
+    }
+}
+
+/* Writes a height field grid as an OBJ. Every vertex has matching v, vt and vn
+ * lines so one index addresses all three. The soup layout writes fresh
+ * vertices for every face so nothing can be deduplicated, and the shuffled
+ * layout writes the faces of the grid in random order. Returns the number of
+ * triangles once the faces are triangulated. */
+static size_t generateObj (const std::string& path, const BenchOptions& options)
+{
+    FILE* file = fopen(path.c_str(), "w");
+
+    if (!file)
+    {
+        std::cerr << "Bench Write Error for '" << path << "': " << std::strerror(errno) << std::endl;
+        exit(-1);
+    }
+
+    std::vector<char> buffer (1 << 20);
+    setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+
+    unsigned int size = options.gridSize;
+    size_t cellCount = (size_t)(size - 1) * (size - 1);
+    size_t triangleCount = cellCount * 2;
+
+    std::vector<uint32_t> cells (cellCount);
+
+    for (size_t i = 0; i < cellCount; ++i)
+    {
+        cells[i] = i;
+    }
+
+    if (options.layout == "shuffled")
+    {
+        std::shuffle(cells.begin(), cells.end(), std::mt19937(GENERATOR_SEED));
+    }
+
+    fprintf(file, "# obj-bench %s grid %u\n", options.layout.c_str(), size);
+
+    if (options.layout == "soup")
+    {
+        long count = 0;
+
+        for (uint32_t cell : cells)
+        {
+            unsigned int column = cell % (size - 1);
+            unsigned int row = cell / (size - 1);
+
+            writeVertex(file, options, column, row);
+            writeVertex(file, options, column + 1, row);
+            writeVertex(file, options, column + 1, row + 1);
+            writeVertex(file, options, column, row + 1);
+            count += 4;
+
+            if (options.quads)
+            {
+                fputc('f', file);
+                for (long k = 4; k >= 1; --k) writeCorner(file, options, count - k, count);
+                fputc('\n', file);
+            }
+            else
+            {
+                fputc('f', file);
+                writeCorner(file, options, count - 4, count);
+                writeCorner(file, options, count - 2, count);
+                writeCorner(file, options, count - 3, count);
+                fputs("\nf", file);
+                writeCorner(file, options, count - 4, count);
+                writeCorner(file, options, count - 1, count);
+                writeCorner(file, options, count - 2, count);
+                fputc('\n', file);
+            }
+        }
+    }
+    else
+    {
+        long count = (long) size * size;
+
+        for (unsigned int row = 0; row < size; ++row)
+        {
+            for (unsigned int column = 0; column < size; ++column)
+            {
+                writeVertex(file, options, column, row);
+            }
+        }
+
+        for (uint32_t cell : cells)
+        {
+            long a = (long)(cell / (size - 1)) * size + cell % (size - 1);
+            long b = a + 1;
+            long c = a + size + 1;
+            long d = a + size;
+
+            fputc('f', file);
+
+            if (options.quads)
+            {
+                writeCorner(file, options, a, count);
+                writeCorner(file, options, d, count);
+                writeCorner(file, options, c, count);
+                writeCorner(file, options, b, count);
+            }
+            else
+            {
+                writeCorner(file, options, a, count);
+                writeCorner(file, options, c, count);
+                writeCorner(file, options, b, count);
+                fputs("\nf", file);
+                writeCorner(file, options, a, count);
+                writeCorner(file, options, d, count);
+                writeCorner(file, options, c, count);
+            }
+
+            fputc('\n', file);
+        }
+    }
+
+    if (fclose(file) != 0)
+    {
+        std::cerr << "Bench Write Error for '" << path << "': " << std::strerror(errno) << std::endl;
+        exit(-1);
+    }
+
+    return triangleCount;
+}
+
+static BenchRun runStage (const std::string& path, const BenchOptions& options)
+{
+    BenchRun run {};
+    auto start = std::chrono::steady_clock::now();
+
+    if (options.stage == "parse")
+    {
+        Mesh mesh;
+
+        if (!parseObjFile(path.c_str(), mesh, options.threadCount))
+        {
+            exit(-1);
+        }
+
+        run.triangleCount = mesh.indices.size() / VERTICES_PER_FACE;
+        run.vertexCount = mesh.vertexData.size() / VERTEX_DATA_STRIDE;
+    }
+    else if (options.stage == "model")
+    {
+        ModelOptions modelOptions;
+        modelOptions.parseThreadCount = options.threadCount;
+        modelOptions.useMeshCache = options.useMeshCache;
+
+        ModelData data (path.c_str(), modelOptions);
+        run.triangleCount = data.getLod(0).indexCount / VERTICES_PER_FACE;
+        run.vertexCount = data.getVertexDataCount();
+    }
+    else
+    {
+        bool streamed = streamObjFile(path.c_str(), options.streamMemoryLimit, [&](const Mesh& batch) {
+            run.triangleCount += batch.indices.size() / VERTICES_PER_FACE;
+            run.vertexCount += batch.vertexData.size() / VERTEX_DATA_STRIDE;
+        });
+
+        if (!streamed)
+        {
+            exit(-1);
+        }
+    }
+
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return run;
+}
+
+static double getPeakResidentMegabytes ()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+}
+
+int main (int argc, char** argv)
+{
+    BenchOptions options = parseArguments(argc, argv);
+    std::string path = options.inputPath;
+    bool generated = path.empty();
+
+    if (generated)
+    {
+        path = options.outputPath.empty() ? "/tmp/obj-bench-" + std::to_string(getpid()) + ".obj" : options.outputPath;
+        generateObj(path, options);
+    }
+
+    struct stat fileStat;
+
+    if (stat(path.c_str(), &fileStat) != 0)
+    {
+        std::cerr << "Bench Read Error for '" << path << "': " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+
+    double megabytes = fileStat.st_size / (1024.0 * 1024.0);
+    unsigned int threadCount = options.threadCount ? options.threadCount : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<BenchRun> runs;
+
+    if (!options.csv)
+    {
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "file: " << path << " (" << megabytes << " MB)" << std::endl;
+        std::cout << "stage: " << options.stage << ", threads: " << threadCount << std::endl;
+    }
+
+    for (unsigned int i = 0; i < options.repeatCount; ++i)
+    {
+        runs.push_back(runStage(path, options));
+
+        if (!options.csv)
+        {
+            const BenchRun& run = runs.back();
+            std::cout << "run " << i + 1 << ": " << run.seconds << " s, "
+                << megabytes / run.seconds << " MB/s, "
+                << run.triangleCount / run.seconds / 1e6 << " M triangles/s, "
+                << run.vertexCount << " vertices" << std::endl;
+        }
+    }
+
+    double best = runs[0].seconds;
+    double total = 0.0;
+
+    for (const BenchRun& run : runs)
+    {
+        best = std::min(best, run.seconds);
+        total += run.seconds;
+    }
+
+    double mean = total / runs.size();
+    size_t triangleCount = runs[0].triangleCount;
+    double peakResident = getPeakResidentMegabytes();
+
+    if (options.csv)
+    {
+        std::cout << "stage,layout,threads,megabytes,triangles,best_seconds,mean_seconds,megabytes_per_second,triangles_per_second,peak_rss_megabytes" << std::endl;
+        std::cout << options.stage << "," << (generated ? options.layout : "input") << "," << threadCount << ","
+            << megabytes << "," << triangleCount << "," << best << "," << mean << ","
+            << megabytes / best << "," << triangleCount / best << "," << peakResident << std::endl;
+    }
+    else
+    {
+        std::cout << "best: " << best << " s, " << megabytes / best << " MB/s, " << triangleCount / best / 1e6 << " M triangles/s" << std::endl;
+        std::cout << "mean: " << mean << " s" << std::endl;
+        std::cout << "peak rss: " << peakResident << " MB" << std::endl;
+    }
+
+    if (generated && !options.keepOutput)
+    {
+        std::remove(path.c_str());
+        std::remove(MeshCache::getCachePath(path.c_str(), getModelProcessingFlags(ModelOptions())).c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,232 @@
+#include "texture-image.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define DEFAULT_CORPUS_PATH "textures"
+#define DEFAULT_REPEAT_COUNT 5
+
+struct BenchOptions
+{
+    std::vector<std::string> inputPaths;
+    unsigned int repeatCount = DEFAULT_REPEAT_COUNT;
+    bool csv = false;
+};
+
+struct BenchDecoder
+{
+    std::string name;
+    ImageDecoder decoder;
+};
+
+static void printUsage ()
+{
+    std::cout
+        << "usage: png-bench [options] [file or directory ...]\n"
+        << "  --repeat N      timed decodes per image and decoder (" << DEFAULT_REPEAT_COUNT << ")\n"
+        << "  --csv           print comma separated results\n"
+        << "Decodes every PNG given, or those in '" << DEFAULT_CORPUS_PATH << "', with stb_image and the\n"
+        << "built-in decoder, and fails if the two disagree on any pixel.\n";
+}
+
+[[noreturn]] static void reportArgumentError (const std::string& message)
+{
+    std::cerr << "Bench Argument Error: " << message << std::endl;
+    printUsage();
+    exit(-1);
+}
+
+static BenchOptions parseArguments (int argc, char** argv)
+{
+    BenchOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc)
+            {
+                reportArgumentError("missing value for " + argument);
+            }
+
+            return argv[++i];
+        };
+
+        if (argument == "--repeat")
+        {
+            options.repeatCount = std::max(1ul, std::stoul(value()));
+        }
+        else if (argument == "--csv")
+        {
+            options.csv = true;
+        }
+        else if (argument == "--help" || argument == "-h")
+        {
+            printUsage();
+            exit(0);
+        }
+        else if (argument.rfind("--", 0) == 0)
+        {
+            reportArgumentError("unknown option '" + argument + "'");
+        }
+        else
+        {
+            options.inputPaths.push_back(argument);
+        }
+    }
+
+    if (options.inputPaths.empty())
+    {
+        options.inputPaths.push_back(DEFAULT_CORPUS_PATH);
+    }
+
+    return options;
+}
+
+/* Directories contribute the PNGs directly inside them, in name order. */
+static std::vector<std::string> findImages (const std::vector<std::string>& inputPaths)
+{
+    std::vector<std::string> images;
+
+    for (const std::string& inputPath : inputPaths)
+    {
+        if (!std::filesystem::is_directory(inputPath))
+        {
+            images.push_back(inputPath);
+            continue;
+        }
+
+        std::vector<std::string> found;
+
+        for (const auto& entry : std::filesystem::directory_iterator(inputPath))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == ".png")
+            {
+                found.push_back(entry.path().string());
+            }
+        }
+
+        std::sort(found.begin(), found.end());
+        images.insert(images.end(), found.begin(), found.end());
+    }
+
+    return images;
+}
+
+int main (int argc, char** argv)
+{
+    BenchOptions options = parseArguments(argc, argv);
+    std::vector<std::string> images = findImages(options.inputPaths);
+    std::vector<BenchDecoder> decoders = {
+        { "stb", IMAGE_DECODER_STB },
+        { "png", IMAGE_DECODER_PNG }
+    };
+    std::vector<double> totalBest (decoders.size(), 0.0);
+    double totalMegapixels = 0.0;
+    double totalMegabytes = 0.0;
+    bool matched = true;
+
+    if (images.empty())
+    {
+        std::cerr << "Bench Read Error: no images found" << std::endl;
+        return -1;
+    }
+
+    if (options.csv)
+    {
+        std::cout << "image,decoder,width,height,best_seconds,mean_seconds,megabytes_per_second,megapixels_per_second" << std::endl;
+    }
+    else
+    {
+        std::cout << std::fixed << std::setprecision(2);
+    }
+
+    for (const std::string& imagePath : images)
+    {
+        TextureImage reference;
+
+        if (!decodeTextureImage(imagePath.c_str(), reference, IMAGE_DECODER_STB))
+        {
+            std::cerr << "Bench Read Error for '" << imagePath << "': could not decode image" << std::endl;
+            return -1;
+        }
+
+        size_t pixelsSize = (size_t) reference.width * reference.height * TEXTURE_IMAGE_CHANNELS;
+        double megapixels = (double) reference.width * reference.height / 1e6;
+        double megabytes = std::filesystem::file_size(imagePath) / 1e6;
+
+        totalMegapixels += megapixels;
+        totalMegabytes += megabytes;
+
+        if (!options.csv)
+        {
+            std::cout << imagePath << " (" << reference.width << "x" << reference.height << ", " << megabytes << " MB)" << std::endl;
+        }
+
+        for (size_t d = 0; d < decoders.size(); ++d)
+        {
+            double best = INFINITY;
+            double total = 0.0;
+            bool identical = true;
+
+            for (unsigned int i = 0; i < options.repeatCount; ++i)
+            {
+                TextureImage image;
+                auto start = std::chrono::steady_clock::now();
+                bool decoded = decodeTextureImage(imagePath.c_str(), image, decoders[d].decoder);
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                identical = identical && decoded && image.width == reference.width && image.height == reference.height
+                    && std::memcmp(image.pixels.get(), reference.pixels.get(), pixelsSize) == 0;
+                best = std::min(best, seconds);
+                total += seconds;
+            }
+
+            double mean = total / options.repeatCount;
+            totalBest[d] += best;
+            matched = matched && identical;
+
+            if (options.csv)
+            {
+                std::cout << imagePath << "," << decoders[d].name << "," << reference.width << "," << reference.height << ","
+                    << best << "," << mean << "," << megabytes / best << "," << megapixels / best << std::endl;
+            }
+            else
+            {
+                std::cout << "  " << std::left << std::setw(6) << decoders[d].name << std::right
+                    << " best " << std::setw(8) << best * 1000.0 << " ms, mean " << std::setw(8) << mean * 1000.0 << " ms, "
+                    << std::setw(8) << megabytes / best << " MB/s, " << std::setw(8) << megapixels / best << " Mpixel/s"
+                    << (identical ? "" : "  PIXELS DIFFER") << std::endl;
+            }
+        }
+    }
+
+    if (!options.csv)
+    {
+        std::cout << "corpus: " << images.size() << " images, " << totalMegabytes << " MB" << std::endl;
+
+        for (size_t d = 0; d < decoders.size(); ++d)
+        {
+            std::cout << "  " << std::left << std::setw(6) << decoders[d].name << std::right
+                << " " << std::setw(8) << totalMegabytes / totalBest[d] << " MB/s, "
+                << std::setw(8) << totalMegapixels / totalBest[d] << " Mpixel/s, "
+                << std::setw(5) << totalBest[0] / totalBest[d] << "x stb" << std::endl;
+        }
+    }
+
+    if (!matched)
+    {
+        std::cerr << "Bench Error: the decoders gave different pixels" << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
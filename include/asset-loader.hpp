@@ -0,0 +1,84 @@
+#ifndef ASSET_LOADER_HPP
+#define ASSET_LOADER_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "material.hpp"
+#include "model.hpp"
+#include "shader.hpp"
+#include "texture-atlas.hpp"
+#include "texture-pack.hpp"
+#include "texture.hpp"
+#include "texture-upload-ring.hpp"
+#include "worker-pool.hpp"
+
+#define DEFAULT_LOADER_THREAD_COUNT 0
+#define DEFAULT_DECODE_THREAD_COUNT 0
+#define DEFAULT_UPLOAD_BUDGET 0.002
+
+class AssetLoader
+{
+    private:
+
+        std::deque<std::function<void ()>> uploads;
+        std::mutex uploadMutex;
+        std::condition_variable uploadCondition;
+        size_t pendingCount;
+
+        size_t uploadRingSize;
+        std::unique_ptr<TextureUploadRing> uploadRing;
+
+        std::vector<std::unique_ptr<TexturePack>> texturePacks;
+
+        // Declared last so the workers are joined before the queues they feed go away.
+        WorkerPool taskPool;
+        WorkerPool decodePool;
+
+        void enqueueTask (WorkerPool& pool, std::function<void ()> task);
+        void enqueueUpload (std::function<void ()> upload);
+        bool runNextUpload ();
+        TextureUploadRing* getUploadRing ();
+        std::shared_ptr<TextureCache> findPackedTexture (const char* textureFilePath) const;
+
+    public:
+
+        AssetLoader (
+            unsigned int threadCount = DEFAULT_LOADER_THREAD_COUNT,
+            unsigned int decodeThreadCount = DEFAULT_DECODE_THREAD_COUNT,
+            size_t uploadRingSize = DEFAULT_UPLOAD_RING_SIZE
+        );
+
+        AssetLoader (const AssetLoader&) = delete;
+        AssetLoader& operator= (const AssetLoader&) = delete;
+
+        bool addTexturePack (const char* packPath);
+
+        std::shared_ptr<Model> loadModel (const char* objFilePath, const ModelOptions& options = ModelOptions());
+        std::shared_ptr<Texture> loadTexture (const char* textureFilePath, uint32_t placeholderColor = PLACEHOLDER_TEXTURE_COLOR, const TextureOptions& options = TextureOptions());
+        void streamTexture (const std::shared_ptr<Texture>& texture, const char* textureFilePath, const TextureOptions& options, int residentSize);
+        std::shared_ptr<TextureAtlas> loadTextureAtlas (const std::vector<std::string>& imagePaths, const AtlasOptions& options = AtlasOptions());
+        std::shared_ptr<Material> loadArrayMaterial (
+            const std::shared_ptr<MaterialArray>& array,
+            const char* diffusePath,
+            const char* specularPath,
+            const char* emissivePath,
+            float shine
+        );
+        std::shared_ptr<Shader> loadShader (const char* vertexShaderPath, const char* fragmentShaderPath);
+
+        unsigned int processUploads (double budgetSeconds = DEFAULT_UPLOAD_BUDGET);
+        unsigned int finishLoading ();
+
+        const size_t getPendingCount ();
+        const TextureUploadStatistics getFrameUploadStatistics () const;
+        const TextureUploadStatistics getTotalUploadStatistics () const;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef ASSET_REGISTRY_HPP
+#define ASSET_REGISTRY_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include "asset-loader.hpp"
+#include "model.hpp"
+#include "texture.hpp"
+#include "texture-manager.hpp"
+
+struct AssetRegistryStatistics
+{
+    size_t modelCount;
+    size_t textureCount;
+    size_t pathHits;
+    size_t fileHits;
+    size_t loads;
+};
+
+class AssetRegistry
+{
+    private:
+
+        template <typename Asset>
+        struct Entries
+        {
+            std::unordered_map<std::string, std::weak_ptr<Asset>> byPath;
+            std::unordered_map<std::string, std::weak_ptr<Asset>> byFile;
+        };
+
+        AssetLoader& loader;
+        TextureManager* textureManager;
+        Entries<Model> models;
+        Entries<Texture> textures;
+        AssetRegistryStatistics statistics;
+
+        template <typename Asset, typename Load>
+        std::shared_ptr<Asset> find (Entries<Asset>& entries, const char* filePath, const std::string& variant, Load load);
+
+    public:
+
+        AssetRegistry (AssetLoader& loader, TextureManager* textureManager = nullptr);
+
+        AssetRegistry (const AssetRegistry&) = delete;
+        AssetRegistry& operator= (const AssetRegistry&) = delete;
+
+        std::shared_ptr<Model> getModel (const char* objFilePath, const ModelOptions& options = ModelOptions());
+        std::shared_ptr<Texture> getTexture (const char* textureFilePath, uint32_t placeholderColor = PLACEHOLDER_TEXTURE_COLOR, const TextureOptions& options = TextureOptions());
+
+        void collectGarbage ();
+
+        const AssetRegistryStatistics getStatistics ();
+};
+
+std::ostream& operator<<(std::ostream& os, const AssetRegistryStatistics& statistics);
+
+#endif
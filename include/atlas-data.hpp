@@ -0,0 +1,84 @@
+#ifndef ATLAS_DATA_HPP
+#define ATLAS_DATA_HPP
+
+#include "glm/glm.hpp"
+
+#include <stddef.h>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "texture-image.hpp"
+
+#define DEFAULT_ATLAS_PAGE_SIZE 4096
+#define DEFAULT_ATLAS_PADDING 8
+
+struct AtlasOptions
+{
+    int pageSize = DEFAULT_ATLAS_PAGE_SIZE;
+
+    // Every image is surrounded by this many copies of its edge pixels and
+    // starts on a multiple of it, so the mip levels down to one texel per
+    // padding width never mix neighbouring images. Rounded up to a power of
+    // two; the page gets no levels beyond that.
+    int padding = DEFAULT_ATLAS_PADDING;
+
+    // A box filter keeps each level's footprint inside the padding.
+    MipChainOptions mipChain = { MIP_FILTER_BOX, DEFAULT_MIP_SRGB, DEFAULT_MIP_PREMULTIPLY_ALPHA };
+};
+
+struct AtlasRegion
+{
+    unsigned int page;
+    int x;
+    int y;
+    int width;
+    int height;
+
+    // Offset in xy and scale in zw, taking the image's own 0 to 1 coordinates
+    // into the page.
+    glm::vec4 uvRect;
+};
+
+struct AtlasPage
+{
+    int width;
+    int height;
+    float occupancy;
+    std::vector<ImageLevel> levels;
+};
+
+/* The client memory half of a texture atlas: many small images decoded,
+ * packed onto a few pages with bleed around each and mipmapped, with the
+ * region every image ended up in. Regions are looked up by the path the image
+ * was loaded from. */
+class AtlasData
+{
+    protected:
+
+        std::vector<AtlasPage> pages;
+        std::unordered_map<std::string, AtlasRegion> regions;
+
+    public:
+
+        AtlasData ();
+        AtlasData (const std::vector<std::string>& imagePaths, const AtlasOptions& options = AtlasOptions());
+
+        AtlasData (AtlasData&&) = default;
+        AtlasData& operator= (AtlasData&&) = default;
+        AtlasData (const AtlasData&) = delete;
+        AtlasData& operator= (const AtlasData&) = delete;
+
+        bool build (const std::vector<std::string>& imagePaths, const AtlasOptions& options = AtlasOptions());
+
+        const unsigned int getPageCount () const;
+        const AtlasPage& getPage (unsigned int page) const;
+
+        bool hasRegion (const std::string& imagePath) const;
+        const AtlasRegion& getRegion (const std::string& imagePath) const;
+        const std::unordered_map<std::string, AtlasRegion>& getRegions () const;
+};
+
+std::ostream& operator<<(std::ostream& os, const AtlasData& atlas);
+
+#endif
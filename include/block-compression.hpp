@@ -0,0 +1,33 @@
+#ifndef BLOCK_COMPRESSION_HPP
+#define BLOCK_COMPRESSION_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <ostream>
+
+enum CompressedFormat : uint32_t
+{
+    COMPRESSED_FORMAT_AUTO = 0,
+    COMPRESSED_FORMAT_BC1 = 1,
+    COMPRESSED_FORMAT_BC3 = 3,
+    COMPRESSED_FORMAT_BC4 = 4,
+    COMPRESSED_FORMAT_BC7 = 7,
+
+    // Plain RGBA pixels, for caches that only save the mip chain.
+    COMPRESSED_FORMAT_RGBA8 = 8
+};
+
+#define COMPRESSED_BLOCK_SIZE 4
+
+const size_t getCompressedBlockBytes (CompressedFormat format);
+const size_t getCompressedSize (CompressedFormat format, int width, int height);
+const char* getCompressedFormatName (CompressedFormat format);
+
+CompressedFormat chooseCompressedFormat (const unsigned char* pixels, int width, int height, bool highQuality);
+
+void compressImage (CompressedFormat format, const unsigned char* pixels, int width, int height, unsigned char* blocks);
+void decompressImage (CompressedFormat format, const unsigned char* blocks, int width, int height, unsigned char* pixels);
+
+std::ostream& operator<<(std::ostream& os, CompressedFormat format);
+
+#endif
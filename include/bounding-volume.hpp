@@ -0,0 +1,48 @@
+#ifndef BOUNDING_VOLUME_HPP
+#define BOUNDING_VOLUME_HPP
+
+#include "glm/glm.hpp"
+
+#include <stddef.h>
+#include <ostream>
+
+#define JACOBI_MAX_SWEEPS 16
+
+struct BoundingBox
+{
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+struct BoundingSphere
+{
+    glm::vec3 center;
+    float radius;
+};
+
+struct OrientedBoundingBox
+{
+    glm::vec3 center;
+    glm::vec3 halfExtents;
+    glm::vec3 axes [3];
+};
+
+struct BoundingVolumes
+{
+    BoundingBox box;
+    BoundingSphere sphere;
+    OrientedBoundingBox orientedBox;
+};
+
+BoundingBox computeBoundingBox (const float* positions, size_t count, size_t stride);
+BoundingVolumes computeBoundingVolumes (const float* positions, size_t count, size_t stride, bool oriented);
+OrientedBoundingBox makeOrientedBoundingBox (const BoundingBox& box);
+
+BoundingBox transformBoundingBox (const BoundingBox& box, glm::vec3 position, glm::vec3 scale);
+BoundingSphere transformBoundingSphere (const BoundingSphere& sphere, glm::vec3 position, glm::vec3 scale);
+OrientedBoundingBox transformOrientedBoundingBox (const OrientedBoundingBox& orientedBox, glm::vec3 position, glm::vec3 scale);
+
+std::ostream& operator<<(std::ostream& os, const BoundingSphere& sphere);
+std::ostream& operator<<(std::ostream& os, const OrientedBoundingBox& orientedBox);
+
+#endif
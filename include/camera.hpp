@@ -37,6 +37,7 @@ class Camera
         Camera (glm::vec3 position, glm::vec3 up, float yaw, float pitch);
 
         glm::mat4 getLookAt ();
+        float getProjectedRadius (glm::vec3 center, float radius, float viewportHeight) const;
 
         void processKeyInput (GLFWwindow* window, float deltaTime);
         void processMouseInput (glm::vec2 offset);
@@ -0,0 +1,8 @@
+#ifndef INFLATE_HPP
+#define INFLATE_HPP
+
+#include <stddef.h>
+
+bool inflateZlib (const unsigned char* input, size_t inputSize, unsigned char* output, size_t outputSize);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <stddef.h>
+
+class MappedFile
+{
+    private:
+
+        void* data;
+        size_t size;
+
+    public:
+
+        MappedFile (const char* filePath);
+        MappedFile (MappedFile&& other);
+        ~MappedFile ();
+
+        MappedFile (const MappedFile&) = delete;
+        MappedFile& operator= (const MappedFile&) = delete;
+
+        const char* getData () const;
+        const size_t getSize () const;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef MATERIAL_ARRAY_HPP
+#define MATERIAL_ARRAY_HPP
+
+#include <vector>
+#include "texture-array.hpp"
+#include "texture-upload-ring.hpp"
+
+class Shader;
+
+// Units the arrays are bound to. They stay clear of the plain material
+// samplers, since samplers of different types may not share a unit.
+#define MATERIAL_ARRAY_TEXTURE_UNIT 3
+
+// Must match MAX_MATERIAL_LAYERS in the lighting shader.
+#define MAX_MATERIAL_ARRAY_LAYERS 64
+
+/* Diffuse, specular and emissive maps of many materials, each kind in a
+ * texture array of its own with one layer per material. Binding it once
+ * lets objects with any of its materials be drawn by changing only the
+ * materialLayer uniform. */
+class MaterialArray
+{
+    private:
+
+        // Levels of the full size images the arrays leave out, which is the
+        // quality tier they were made at.
+        unsigned int firstLevel;
+
+        TextureArray diffuse;
+        TextureArray specular;
+        TextureArray emissive;
+        std::vector<float> shines;
+        std::vector<bool> readyLayers;
+
+    public:
+
+        MaterialArray (int width, int height, unsigned int layerCapacity);
+
+        MaterialArray (const MaterialArray&) = delete;
+        MaterialArray& operator= (const MaterialArray&) = delete;
+
+        unsigned int reserveLayer (float shine);
+        bool upload (
+            unsigned int layer,
+            const std::vector<ImageLevel>& diffuseLevels,
+            const std::vector<ImageLevel>& specularLevels,
+            const std::vector<ImageLevel>& emissiveLevels,
+            TextureUploadRing* ring = nullptr
+        );
+
+        bool isLayerReady (unsigned int layer) const;
+        const unsigned int getLayerCount () const;
+        const int getWidth () const;
+        const int getHeight () const;
+        const unsigned int getFirstLevel () const;
+
+        void bind (const Shader& shader) const;
+        static void setSamplerUnits (const Shader& shader);
+        static void setLayer (const Shader& shader, unsigned int layer);
+};
+
+#endif
@@ -2,12 +2,21 @@
 #define MATERIAL_HPP
 
 #include "glad/glad.h"
+#include "material-array.hpp"
+#include "texture.hpp"
+
+#include <memory>
 
 struct Material {
-    GLuint diffuse;
-    GLuint specular;
-    GLuint emissive;
+    std::shared_ptr<Texture> diffuse;
+    std::shared_ptr<Texture> specular;
+    std::shared_ptr<Texture> emissive;
     float shine;
+
+    // Set for materials whose maps live in a layer of a MaterialArray, which
+    // then replaces the three textures above.
+    std::shared_ptr<MaterialArray> array;
+    unsigned int arrayLayer = 0;
 };
 
-#endif
\ No newline at end of file
+#endif
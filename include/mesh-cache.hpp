@@ -0,0 +1,126 @@
+#ifndef MESH_CACHE_HPP
+#define MESH_CACHE_HPP
+
+#include "bounding-volume.hpp"
+#include "mapped-file.hpp"
+#include "mesh.hpp"
+#include "mesh-optimizer.hpp"
+#include "meshlet.hpp"
+#include "vertex-format.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#define MESH_CACHE_MAGIC 0x4853454D
+#define MESH_CACHE_VERSION 6
+#define MESH_CACHE_EXTENSION ".meshcache"
+#define MESH_CACHE_ALIGNMENT 16
+
+struct SourceFileInfo
+{
+    uint64_t size;
+    int64_t modifiedTime;
+};
+
+struct MeshCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t processingFlags;
+    uint32_t indexType;
+    uint32_t vertexFormat;
+    uint32_t reserved;
+
+    uint64_t sourceSize;
+    int64_t sourceModifiedTime;
+    uint64_t sourceHash;
+
+    VertexLayout vertexLayout;
+
+    uint64_t vertexCount;
+    uint64_t sourceVertexCount;
+    uint64_t vertexDataOffset;
+    uint64_t vertexDataSize;
+
+    uint64_t indexCount;
+    uint64_t indexDataOffset;
+    uint64_t indexDataSize;
+
+    uint64_t meshletCount;
+    uint64_t meshletDataOffset;
+    uint64_t meshletDataSize;
+
+    float boundsMin [3];
+    float boundsMax [3];
+    BoundingSphere boundingSphere;
+    OrientedBoundingBox orientedBoundingBox;
+
+    MeshOptimizationReport optimizationReport;
+    QuantizationReport quantizationReport;
+
+    uint32_t lodCount;
+    uint32_t lodReserved;
+    MeshLod lods [MAX_LOD_COUNT];
+};
+
+struct MeshCacheContents
+{
+    uint32_t processingFlags;
+    uint32_t vertexFormat;
+    VertexLayout vertexLayout;
+
+    const void* vertexData;
+    size_t vertexDataSize;
+    size_t vertexCount;
+    size_t sourceVertexCount;
+
+    const void* indexData;
+    size_t indexDataSize;
+    size_t indexCount;
+    uint32_t indexType;
+
+    const Meshlet* meshlets;
+    size_t meshletCount;
+
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    BoundingSphere boundingSphere;
+    OrientedBoundingBox orientedBoundingBox;
+
+    MeshOptimizationReport optimizationReport;
+    QuantizationReport quantizationReport;
+
+    const MeshLod* lods;
+    size_t lodCount;
+};
+
+class MeshCache
+{
+    private:
+
+        MappedFile file;
+        const MeshCacheHeader* header;
+
+    public:
+
+        MeshCache (const char* cachePath);
+
+        bool isValidFor (const char* sourcePath, uint32_t processingFlags) const;
+
+        const MeshCacheHeader& getHeader () const;
+        const void* getVertexData () const;
+        const void* getIndexData () const;
+        const Meshlet* getMeshletData () const;
+
+        static std::string getCachePath (const char* sourcePath, uint32_t processingFlags);
+        static bool exists (const char* cachePath);
+        static void write (const char* cachePath, const char* sourcePath, const MeshCacheContents& contents);
+};
+
+uint64_t hashBytes (const void* data, size_t size);
+bool statSourceFile (const char* sourcePath, SourceFileInfo& info);
+uint64_t hashSourceFile (const char* sourcePath);
+std::string makeTemporaryPath (const char* path);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef MESH_OPTIMIZER_HPP
+#define MESH_OPTIMIZER_HPP
+
+#include "mesh.hpp"
+
+#include <stddef.h>
+#include <ostream>
+#include <vector>
+
+#define ANALYSIS_CACHE_SIZE 16
+#define OPTIMIZER_CACHE_SIZE 32
+#define OVERDRAW_ACMR_THRESHOLD 1.05f
+
+struct VertexCacheStatistics
+{
+    float acmr;
+    float atvr;
+};
+
+struct MeshOptimizationReport
+{
+    VertexCacheStatistics before;
+    VertexCacheStatistics after;
+};
+
+VertexCacheStatistics analyzeVertexCache (const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = ANALYSIS_CACHE_SIZE);
+
+void optimizeVertexCache (std::vector<unsigned int>& indices, size_t vertexCount);
+void optimizeOverdraw (std::vector<unsigned int>& indices, const std::vector<float>& vertexData, float acmrThreshold = OVERDRAW_ACMR_THRESHOLD);
+void optimizeVertexFetch (Mesh& mesh);
+
+MeshOptimizationReport optimizeMesh (Mesh& mesh);
+
+std::ostream& operator<<(std::ostream& os, const MeshOptimizationReport& report);
+
+#endif
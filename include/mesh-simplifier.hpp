@@ -0,0 +1,16 @@
+#ifndef MESH_SIMPLIFIER_HPP
+#define MESH_SIMPLIFIER_HPP
+
+#include "mesh.hpp"
+
+#include <stddef.h>
+#include <vector>
+
+#define DEFAULT_LOD_REDUCTION 0.5f
+#define MIN_LOD_REDUCTION_GAIN 0.9f
+
+std::vector<unsigned int> simplifyMesh (const Mesh& mesh, const std::vector<unsigned int>& indices, size_t targetIndexCount, float& error);
+
+void generateLods (Mesh& mesh, unsigned int lodCount, float reduction = DEFAULT_LOD_REDUCTION, bool optimize = true);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef MESH_HPP
+#define MESH_HPP
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#define VERTICES_PER_FACE 3
+#define VERTEX_SIZE sizeof(float) * 3
+#define SURFACE_NORMAL_SIZE sizeof(float) * 3
+#define UV_COORDINATE_SIZE sizeof(float) * 2
+
+#define VERTEX_DATA_STRIDE 8
+
+#define MAX_VERTEX_ATTRIBUTES 4
+#define MAX_LOD_COUNT 8
+
+struct VertexAttribute
+{
+    uint32_t location;
+    uint32_t componentCount;
+    uint32_t type;
+    uint32_t normalized;
+    uint32_t offset;
+};
+
+struct VertexLayout
+{
+    uint32_t stride;
+    uint32_t attributeCount;
+    VertexAttribute attributes [MAX_VERTEX_ATTRIBUTES];
+};
+
+struct MeshLod
+{
+    uint64_t indexOffset;
+    uint64_t indexCount;
+    float error;
+    float reserved;
+};
+
+struct Mesh
+{
+    std::vector<float> vertexData;
+    std::vector<unsigned int> indices;
+    std::vector<MeshLod> lods;
+
+    size_t sourceVertexCount;
+
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+};
+
+const VertexLayout makeFloatVertexLayout ();
+void computeMeshBounds (Mesh& mesh);
+
+#endif
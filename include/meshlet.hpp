@@ -0,0 +1,48 @@
+#ifndef MESHLET_HPP
+#define MESHLET_HPP
+
+#include "glm/glm.hpp"
+#include "mesh.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <ostream>
+#include <vector>
+
+#define MAX_MESHLET_VERTICES 64
+#define MAX_MESHLET_TRIANGLES 124
+#define FRUSTUM_PLANE_COUNT 6
+
+struct Meshlet
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+
+    glm::vec3 center;
+    float radius;
+
+    glm::vec3 coneAxis;
+    float coneCutoff;
+};
+
+struct MeshletRange
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+};
+
+struct MeshletCullingStatistics
+{
+    size_t meshletCount;
+    size_t frustumCulledCount;
+    size_t backfaceCulledCount;
+    size_t rangeCount;
+};
+
+std::vector<Meshlet> buildMeshlets (const Mesh& mesh, size_t indexOffset, size_t indexCount);
+
+void cullMeshlets (const std::vector<Meshlet>& meshlets, const glm::mat4& modelViewProjection, glm::vec3 cameraPosition, std::vector<MeshletRange>& visibleRanges, MeshletCullingStatistics& statistics);
+
+std::ostream& operator<<(std::ostream& os, const MeshletCullingStatistics& statistics);
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef MODEL_DATA_HPP
+#define MODEL_DATA_HPP
+
+#include "glm/glm.hpp"
+#include "glad/glad.h"
+
+#include <stddef.h>
+#include <memory>
+#include <ostream>
+#include <vector>
+#include "bounding-volume.hpp"
+#include "mesh.hpp"
+#include "mesh-cache.hpp"
+#include "mesh-optimizer.hpp"
+#include "mesh-simplifier.hpp"
+#include "meshlet.hpp"
+#include "vertex-format.hpp"
+
+#define DEFAULT_PARSE_THREAD_COUNT 0
+#define DEFAULT_USE_MESH_CACHE true
+#define DEFAULT_OPTIMIZE_MESH true
+#define DEFAULT_LOD_COUNT 4
+#define DEFAULT_LOD_ERROR_PIXELS 1.0f
+#define DEFAULT_STREAM_MEMORY_LIMIT 0
+#define DEFAULT_COMPUTE_ORIENTED_BOUNDS true
+#define DEFAULT_BUILD_MESHLETS true
+
+#define MESH_PROCESSING_OPTIMIZED (1 << 0)
+#define MESH_PROCESSING_ORIENTED_BOUNDS (1 << 1)
+#define MESH_PROCESSING_MESHLETS (1 << 2)
+#define MESH_PROCESSING_VERTEX_FORMAT_SHIFT 8
+#define MESH_PROCESSING_LOD_COUNT_SHIFT 16
+#define MESH_PROCESSING_LOD_REDUCTION_SHIFT 24
+
+struct ModelOptions
+{
+    unsigned int parseThreadCount = DEFAULT_PARSE_THREAD_COUNT;
+    bool useMeshCache = DEFAULT_USE_MESH_CACHE;
+    bool optimizeMesh = DEFAULT_OPTIMIZE_MESH;
+    VertexFormat vertexFormat = DEFAULT_VERTEX_FORMAT;
+    unsigned int lodCount = DEFAULT_LOD_COUNT;
+    float lodReduction = DEFAULT_LOD_REDUCTION;
+    bool computeOrientedBounds = DEFAULT_COMPUTE_ORIENTED_BOUNDS;
+    bool buildMeshlets = DEFAULT_BUILD_MESHLETS;
+
+    // Non-zero streams the file straight into GPU buffers within this many bytes,
+    // skipping the cache, optimization, LODs and quantization. A streamed model
+    // always has float vertices, 32-bit indices, one LOD, no meshlets and an
+    // oriented box taken from its bounds; setting vertexFormat, optimizeMesh,
+    // lodCount, buildMeshlets or computeOrientedBounds with it logs a warning.
+    size_t streamMemoryLimit = DEFAULT_STREAM_MEMORY_LIMIT;
+};
+
+uint32_t getModelProcessingFlags (const ModelOptions& options);
+
+/* The client memory half of a model: parsing, processing and the mesh cache.
+ * Nothing here calls into GL, so it can be built on any thread or in a tool
+ * without a context and handed to a Model for upload later. */
+class ModelData
+{
+    protected:
+
+        Mesh mesh;
+        std::vector<unsigned char> packedVertices;
+        std::vector<uint16_t> shortIndices;
+        std::unique_ptr<MeshCache> meshCache;
+
+        VertexFormat vertexFormat;
+        VertexLayout vertexLayout;
+        PositionDequantization positionDequantization;
+
+        const void* vertexData;
+        size_t vertexDataSize;
+        unsigned int vertexDataCount;
+
+        const void* indexData;
+        size_t indexDataSize;
+        unsigned int indexCount;
+        GLenum indexType;
+        std::vector<MeshLod> lods;
+        std::vector<Meshlet> meshlets;
+
+        size_t sourceVertexCount;
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        BoundingSphere boundingSphere;
+        OrientedBoundingBox orientedBoundingBox;
+        MeshOptimizationReport optimizationReport;
+        QuantizationReport quantizationReport;
+
+        bool constructFromObj (const char* filePath, const ModelOptions& options);
+        bool constructFromCache (const char* filePath, const ModelOptions& options);
+
+    public:
+
+        ModelData ();
+        ModelData (const char* objFilePath, const ModelOptions& options = ModelOptions());
+
+        // vertexData and indexData point into the members, which keep their
+        // storage when moved but not when copied.
+        ModelData (ModelData&&) = default;
+        ModelData& operator= (ModelData&&) = default;
+        ModelData (const ModelData&) = delete;
+        ModelData& operator= (const ModelData&) = delete;
+
+        bool load (const char* objFilePath, const ModelOptions& options = ModelOptions());
+        void writeCache (const char* objFilePath, const ModelOptions& options) const;
+
+        const size_t getVertexDataSize () const;
+        const void* const getVertexData () const;
+        const unsigned int getVertexDataCount () const;
+        const VertexLayout& getVertexLayout () const;
+        const VertexFormat getVertexFormat () const;
+        const PositionDequantization& getPositionDequantization () const;
+        void getVertex (unsigned int index, float* vertex) const;
+
+        const void* const getIndexData () const;
+        const size_t getIndexDataSize () const;
+        const unsigned int getIndexCount () const;
+        const GLenum getIndexType () const;
+
+        const unsigned int getLodCount () const;
+        const MeshLod& getLod (unsigned int lod) const;
+        unsigned int selectLod (float projectedRadius, float maxErrorPixels = DEFAULT_LOD_ERROR_PIXELS) const;
+
+        const std::vector<Meshlet>& getMeshlets () const;
+
+        const size_t getSourceVertexCount () const;
+        const glm::vec3 getBoundsMin () const;
+        const glm::vec3 getBoundsMax () const;
+        const BoundingBox getBoundingBox () const;
+        const BoundingSphere& getBoundingSphere () const;
+        const OrientedBoundingBox& getOrientedBoundingBox () const;
+        const MeshOptimizationReport& getOptimizationReport () const;
+        const QuantizationReport& getQuantizationReport () const;
+};
+
+std::ostream& operator<<(std::ostream& os, const ModelData& data);
+
+#endif
@@ -2,45 +2,59 @@
 #define MODEL_HPP
 
 #include "glm/glm.hpp"
+#include "glad/glad.h"
 
-#include <stddef.h>
-#include <ostream>
+#include <vector>
 #include "material.hpp"
+#include "meshlet.hpp"
+#include "model-data.hpp"
 
-#define VERTICES_PER_FACE 3
-#define VERTEX_SIZE sizeof(float) * 3
-#define SURFACE_NORMAL_SIZE sizeof(float) * 3
-#define UV_COORDINATE_SIZE sizeof(float) * 2
+class Shader;
 
-#define VERTEX_DATA_STRIDE 8
-
-class Model
+/* A ModelData with its buffers on the GPU. Everything but the streaming
+ * constructor, upload and drawing is inherited and free of GL. */
+class Model : public ModelData
 {
     private:
 
-        float* vertexData;
-        size_t vertexDataSize;
-        unsigned int vertexDataCount;
+        mutable std::vector<MeshletRange> visibleRanges;
+        mutable std::vector<GLsizei> drawCounts;
+        mutable std::vector<const void*> drawOffsets;
+        mutable MeshletCullingStatistics cullingStatistics;
 
         unsigned int vertexArray;
         unsigned int vertexBuffer;
+        unsigned int indexBuffer;
+        bool ready;
+        bool failed;
 
-        void constructFromObj (const char* filePath);
+        bool constructFromStream (const char* filePath, const ModelOptions& options);
+        void setVertexAttributes () const;
 
     public:
 
-        Model (const char* objFilePath);
+        Model ();
+        Model (const char* objFilePath, const ModelOptions& options = ModelOptions());
+        explicit Model (ModelData&& data);
         ~Model ();
 
-        const size_t getVertexDataSize () const;
-        const float* const getVertexData () const;
-        const unsigned int getVertexDataCount () const;
+        Model (const Model&) = delete;
+        Model& operator= (const Model&) = delete;
+
+        void upload ();
+        void markFailed ();
+        bool isReady () const;
+        bool hasFailed () const;
+
+        const MeshletCullingStatistics& getCullingStatistics () const;
+
+        void setDequantizationUniforms (const Shader& shader) const;
 
         void bindVertexArray () const;
         void bindVertexBuffer () const;
         void drawVertexArray () const;
+        void drawLod (unsigned int lod) const;
+        void drawMeshlets (const glm::mat4& modelViewProjection, glm::vec3 cameraPosition) const;
 };
 
-std::ostream& operator<<(std::ostream& os, const Model& data);
-
 #endif
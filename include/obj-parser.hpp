@@ -0,0 +1,18 @@
+#ifndef OBJ_PARSER_HPP
+#define OBJ_PARSER_HPP
+
+#include "mesh.hpp"
+
+#include <stddef.h>
+#include <functional>
+
+typedef std::function<void (const Mesh& batch)> MeshBatchHandler;
+
+// Each returns false once it has reported a malformed or unreadable file.
+
+bool parseObj (const char* data, size_t size, const char* sourceName, Mesh& mesh);
+bool parseObjParallel (const char* data, size_t size, const char* sourceName, unsigned int threadCount, Mesh& mesh);
+bool parseObjFile (const char* filePath, Mesh& mesh, unsigned int threadCount = 1);
+bool streamObjFile (const char* filePath, size_t memoryLimit, const MeshBatchHandler& handleBatch);
+
+#endif
@@ -5,13 +5,19 @@
 #include "material.hpp"
 #include "model.hpp"
 
+#include <memory>
+
 struct Object {
 
     glm::vec3 position;
     glm::vec3 scale;
-    Model* model;
+    std::shared_ptr<Model> model;
+
+    std::shared_ptr<Material> material;
 
-    Material* material;
+    // Where the object's image sits in its material's textures, as an AtlasRegion
+    // uvRect. The default covers the whole texture.
+    glm::vec4 uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
 };
 
 #endif
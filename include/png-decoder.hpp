@@ -0,0 +1,13 @@
+#ifndef PNG_DECODER_HPP
+#define PNG_DECODER_HPP
+
+#include <stddef.h>
+#include "texture-image.hpp"
+
+#define PNG_SIGNATURE_SIZE 8
+#define PNG_MAX_DIMENSION (1 << 24)
+
+bool isPngData (const unsigned char* data, size_t size);
+bool decodePng (const unsigned char* data, size_t size, TextureImage& image);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef SCRATCH_BUFFER_HPP
+#define SCRATCH_BUFFER_HPP
+
+#include <stddef.h>
+
+class ScratchBuffer
+{
+    private:
+
+        void* data;
+        size_t size;
+        bool fileBacked;
+
+    public:
+
+        ScratchBuffer (size_t size, bool fileBacked);
+        ~ScratchBuffer ();
+
+        ScratchBuffer (const ScratchBuffer&) = delete;
+        ScratchBuffer& operator= (const ScratchBuffer&) = delete;
+
+        char* getData () const;
+        const size_t getSize () const;
+        const bool isFileBacked () const;
+};
+
+#endif
@@ -8,20 +8,32 @@ class Shader
 {
     private:
 
+        bool failed;
+
         void checkCompilerErrors (unsigned int shader, std::string type);
 
     public:
 
         unsigned int programID;
 
+        Shader ();
         Shader (const char* vertexShaderPath, const char* fragmentShaderPath);
 
+        void compile (const std::string& vertexShaderSource, const std::string& fragmentShaderSource);
+        void markFailed ();
+        bool isReady () const;
+        bool hasFailed () const;
+
         void use ();
 
         void setInt (const std::string &name, const int &num) const;
         void setFloat (const std::string &name, const float &num) const;
         void setMat4 (const std::string &name, const glm::mat4 &mat) const;
         void setVec3 (const std::string &name, const glm::vec3 &vec) const;
+        void setVec4 (const std::string &name, const glm::vec4 &vec) const;
+
+        static std::string readSourceFile (const char* shaderPath);
+        static bool readSourceFile (const char* shaderPath, std::string& source);
 };
 
 #endif
@@ -0,0 +1,38 @@
+#ifndef SKYLINE_PACKER_HPP
+#define SKYLINE_PACKER_HPP
+
+#include <stddef.h>
+#include <vector>
+
+/* Packs rectangles into a fixed area bottom-left first. The free space is
+ * tracked as the top edge of everything placed so far, which keeps inserts
+ * cheap and works well for many images of similar size. */
+class SkylinePacker
+{
+    private:
+
+        struct Segment
+        {
+            int x;
+            int y;
+            int width;
+        };
+
+        int width;
+        int height;
+        size_t usedArea;
+        std::vector<Segment> skyline;
+
+        bool fitSegment (size_t segment, int rectangleWidth, int rectangleHeight, int& y) const;
+
+    public:
+
+        SkylinePacker (int width, int height);
+
+        bool insert (int rectangleWidth, int rectangleHeight, int& x, int& y);
+
+        const int getUsedHeight () const;
+        const float getOccupancy () const;
+};
+
+#endif
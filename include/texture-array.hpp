@@ -0,0 +1,42 @@
+#ifndef TEXTURE_ARRAY_HPP
+#define TEXTURE_ARRAY_HPP
+
+#include "glad/glad.h"
+
+#include <vector>
+#include "texture-image.hpp"
+#include "texture-upload-ring.hpp"
+
+/* A GL_TEXTURE_2D_ARRAY of same-sized RGBA images with their full mip chains.
+ * Storage for every layer is made up front, so layers can be filled in any
+ * order and one bind covers them all. */
+class TextureArray
+{
+    private:
+
+        GLuint texture;
+        int width;
+        int height;
+        unsigned int levelCount;
+        unsigned int layerCapacity;
+
+        void fillLayer (unsigned int layer, const unsigned char* color, TextureUploadRing* ring);
+
+    public:
+
+        TextureArray (int width, int height, unsigned int layerCapacity);
+        ~TextureArray ();
+
+        TextureArray (const TextureArray&) = delete;
+        TextureArray& operator= (const TextureArray&) = delete;
+
+        bool upload (unsigned int layer, const std::vector<ImageLevel>& levels, TextureUploadRing* ring = nullptr);
+
+        const int getWidth () const;
+        const int getHeight () const;
+        const unsigned int getLevelCount () const;
+        const unsigned int getLayerCapacity () const;
+        GLuint getID () const;
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef TEXTURE_ATLAS_HPP
+#define TEXTURE_ATLAS_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "atlas-data.hpp"
+#include "texture.hpp"
+#include "texture-upload-ring.hpp"
+
+/* An AtlasData with every page uploaded as a texture. Objects drawn from the
+ * same page share one texture, so they need one bind between them and pick
+ * their image through the region's uvRect. */
+class TextureAtlas : public AtlasData
+{
+    private:
+
+        std::vector<std::shared_ptr<Texture>> pageTextures;
+        bool ready;
+        bool failed;
+
+    public:
+
+        TextureAtlas ();
+        TextureAtlas (const std::vector<std::string>& imagePaths, const AtlasOptions& options = AtlasOptions());
+        explicit TextureAtlas (AtlasData&& data);
+
+        TextureAtlas (const TextureAtlas&) = delete;
+        TextureAtlas& operator= (const TextureAtlas&) = delete;
+
+        void upload (TextureUploadRing* ring = nullptr);
+        void markFailed ();
+        bool isReady () const;
+        bool hasFailed () const;
+
+        std::shared_ptr<Texture> getPageTexture (unsigned int page) const;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef TEXTURE_CACHE_HPP
+#define TEXTURE_CACHE_HPP
+
+#include "block-compression.hpp"
+#include "mapped-file.hpp"
+#include "texture-image.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define TEXTURE_CACHE_MAGIC 0x58455443
+#define TEXTURE_CACHE_VERSION 2
+#define TEXTURE_CACHE_EXTENSION ".texcache"
+#define TEXTURE_CACHE_ALIGNMENT 16
+#define MAX_TEXTURE_LEVELS 16
+
+struct TextureCacheLevel
+{
+    uint32_t width;
+    uint32_t height;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+};
+
+struct TextureCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;
+    uint32_t levelCount;
+    uint32_t processingFlags;
+    uint32_t reserved;
+
+    uint64_t sourceSize;
+    int64_t sourceModifiedTime;
+    uint64_t sourceHash;
+
+    TextureCacheLevel levels [MAX_TEXTURE_LEVELS];
+};
+
+/* A texture with its whole mip chain, block-compressed or as plain RGBA, laid
+ * out so each level can be handed to GL straight from the mapped file. The
+ * file is either a cache of its own or a texture pack, where the header sits
+ * in the pack's table and level offsets count from the start of the pack. */
+class TextureCache
+{
+    private:
+
+        std::shared_ptr<const MappedFile> file;
+        const TextureCacheHeader* header;
+
+    public:
+
+        TextureCache (const char* cachePath);
+        TextureCache (std::shared_ptr<const MappedFile> file, size_t headerOffset);
+
+        bool isWellFormed () const;
+        bool isValidFor (const char* sourcePath, uint32_t processingFlags, bool allowMissingSource = false) const;
+
+        const TextureCacheHeader& getHeader () const;
+        const CompressedFormat getFormat () const;
+        const unsigned int getLevelCount () const;
+        const TextureCacheLevel& getLevel (unsigned int level) const;
+        const unsigned char* getLevelData (unsigned int level) const;
+
+        static std::string getCachePath (const char* sourcePath);
+        static std::string getCachePath (const char* sourcePath, uint32_t processingFlags);
+        static bool exists (const char* cachePath);
+        static bool write (const char* cachePath, const char* sourcePath, CompressedFormat format, uint32_t processingFlags, const std::vector<ImageLevel>& levels);
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef TEXTURE_COOKER_HPP
+#define TEXTURE_COOKER_HPP
+
+#include "block-compression.hpp"
+#include "texture-cache.hpp"
+#include "texture-image.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#define DEFAULT_COOK_FORMAT COMPRESSED_FORMAT_AUTO
+#define DEFAULT_COOK_HIGH_QUALITY false
+
+struct TextureCookOptions
+{
+    CompressedFormat format = DEFAULT_COOK_FORMAT;
+    bool highQuality = DEFAULT_COOK_HIGH_QUALITY;
+    MipChainOptions mipChain;
+};
+
+struct TextureCookReport
+{
+    CompressedFormat format;
+    int width;
+    int height;
+    unsigned int levelCount;
+    size_t uncompressedSize;
+    size_t compressedSize;
+    double peakSignalToNoise;
+    double seconds;
+
+    // Channels that hold one value throughout, as a mask over RGBA. An image
+    // constant in all of them is cooked as a single texel, saving savedSize
+    // bytes over the chain it would have had.
+    uint32_t constantChannels;
+    size_t savedSize;
+};
+
+bool cookTexture (const char* sourcePath, const TextureCookOptions& options, TextureCookReport& report);
+std::shared_ptr<TextureCache> findTextureCache (const char* sourcePath, uint32_t processingFlags);
+bool buildMipChain (const char* sourcePath, const MipChainOptions& options, bool writeCache, std::vector<ImageLevel>& levels, unsigned int firstLevel = 0);
+bool loadMipChain (const char* sourcePath, const MipChainOptions& options, bool useTextureCache, std::vector<ImageLevel>& levels, unsigned int firstLevel = 0);
+
+std::ostream& operator<<(std::ostream& os, const TextureCookReport& report);
+
+#endif
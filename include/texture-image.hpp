@@ -0,0 +1,94 @@
+#ifndef TEXTURE_IMAGE_HPP
+#define TEXTURE_IMAGE_HPP
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#define TEXTURE_IMAGE_CHANNELS 4
+#define ALL_IMAGE_CHANNELS 0xF
+
+enum MipFilter : uint32_t
+{
+    MIP_FILTER_BOX = 0,
+    MIP_FILTER_KAISER = 1
+};
+
+#define DEFAULT_MIP_FILTER MIP_FILTER_KAISER
+#define DEFAULT_MIP_SRGB true
+#define DEFAULT_MIP_PREMULTIPLY_ALPHA true
+
+// Which decoder turns image files into pixels. The built-in one reads PNGs and
+// hands anything else, or any PNG it does not support, to stb_image.
+enum ImageDecoder : uint32_t
+{
+    IMAGE_DECODER_STB = 0,
+    IMAGE_DECODER_PNG = 1
+};
+
+#define DEFAULT_IMAGE_DECODER IMAGE_DECODER_PNG
+
+// How much of every texture's resolution is loaded, as the number of top mip
+// levels left out. Half resolution takes a quarter of the memory and quarter
+// resolution a sixteenth. The tier is read from TEXTURE_QUALITY_VARIABLE,
+// "full", "half" or "quarter", unless it is set before the first load.
+enum TextureQuality : uint32_t
+{
+    TEXTURE_QUALITY_FULL = 0,
+    TEXTURE_QUALITY_HALF = 1,
+    TEXTURE_QUALITY_QUARTER = 2
+};
+
+#define DEFAULT_TEXTURE_QUALITY TEXTURE_QUALITY_FULL
+#define TEXTURE_QUALITY_VARIABLE "SOLITAIRE_TEXTURE_QUALITY"
+
+#define MIP_KAISER_WIDTH 3.0f
+#define MIP_KAISER_ALPHA 4.0f
+
+struct MipChainOptions
+{
+    MipFilter filter = DEFAULT_MIP_FILTER;
+
+    // Colour channels hold sRGB encoded values and are averaged in linear light.
+    // Turn off for data such as specular or normal maps.
+    bool srgb = DEFAULT_MIP_SRGB;
+
+    // Colour is weighted by alpha so transparent texels do not bleed their
+    // colour into the opaque ones next to them.
+    bool premultiplyAlpha = DEFAULT_MIP_PREMULTIPLY_ALPHA;
+};
+
+uint32_t getMipChainFlags (const MipChainOptions& options);
+void setTextureQuality (TextureQuality quality);
+const TextureQuality getTextureQuality ();
+
+struct TextureImage
+{
+    int width;
+    int height;
+    std::unique_ptr<unsigned char, void (*)(void*)> pixels { nullptr, nullptr };
+};
+
+/* One level of a mip chain, either RGBA pixels or compressed blocks. */
+struct ImageLevel
+{
+    int width;
+    int height;
+    std::vector<unsigned char> data;
+};
+
+bool decodeTextureImage (const char* textureFilePath, TextureImage& image, ImageDecoder decoder = DEFAULT_IMAGE_DECODER);
+uint32_t findConstantChannels (const unsigned char* pixels, int width, int height, unsigned char values [TEXTURE_IMAGE_CHANNELS]);
+
+const unsigned int getMipLevelCount (int width, int height);
+const unsigned int getMipLevelForSize (int width, int height, int size);
+void downsampleImage (const unsigned char* source, int width, int height, unsigned char* destination);
+std::vector<ImageLevel> generateMipChain (
+    const unsigned char* pixels,
+    int width,
+    int height,
+    const MipChainOptions& options = MipChainOptions(),
+    unsigned int firstLevel = 0
+);
+
+#endif
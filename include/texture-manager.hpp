@@ -0,0 +1,86 @@
+#ifndef TEXTURE_MANAGER_HPP
+#define TEXTURE_MANAGER_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "asset-loader.hpp"
+#include "texture.hpp"
+
+#define DEFAULT_TEXTURE_BUDGET ((size_t) 128 << 20)
+#define DEFAULT_TEXTURE_TAIL_SIZE 64
+
+struct TextureManagerStatistics
+{
+    size_t textureCount;
+    size_t residentBytes;
+    size_t budgetBytes;
+    size_t pendingLoads;
+    size_t streamedLevels;
+    size_t evictedLevels;
+    size_t evictedBytes;
+};
+
+/* Keeps the textures it loads within a budget of GPU memory. Each starts with
+ * only its tail, the levels up to the tail size, and streams in finer levels
+ * once something drawn with it covers enough of the screen to show them. When
+ * the budget runs short the finest levels of the least recently used textures
+ * are evicted, down to their tails. All of it must be used on the GL thread. */
+class TextureManager
+{
+    private:
+
+        struct Entry
+        {
+            std::weak_ptr<Texture> texture;
+            std::string path;
+            TextureOptions options;
+
+            size_t lastUsedFrame;
+            float screenSize;
+            unsigned int wantedLevel;
+
+            bool pending;
+            unsigned int pendingLevel;
+        };
+
+        struct LiveEntry
+        {
+            Entry* entry;
+            std::shared_ptr<Texture> texture;
+        };
+
+        AssetLoader& loader;
+        size_t budget;
+        int tailSize;
+        size_t frame;
+
+        std::unordered_map<const Texture*, Entry> entries;
+        TextureManagerStatistics statistics;
+
+        unsigned int getTailLevel (const Texture& texture) const;
+        bool evictLevel (std::vector<LiveEntry>& live, const Entry* keep, size_t& residentSize);
+
+    public:
+
+        TextureManager (AssetLoader& loader, size_t budget = DEFAULT_TEXTURE_BUDGET, int tailSize = DEFAULT_TEXTURE_TAIL_SIZE);
+
+        TextureManager (const TextureManager&) = delete;
+        TextureManager& operator= (const TextureManager&) = delete;
+
+        std::shared_ptr<Texture> loadTexture (const char* textureFilePath, uint32_t placeholderColor = PLACEHOLDER_TEXTURE_COLOR, const TextureOptions& options = TextureOptions());
+
+        void request (const Texture& texture, float screenSize);
+        void update ();
+
+        void setBudget (size_t budget);
+        const TextureManagerStatistics getStatistics () const;
+};
+
+std::ostream& operator<<(std::ostream& os, const TextureManagerStatistics& statistics);
+
+#endif
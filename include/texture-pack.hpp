@@ -0,0 +1,102 @@
+#ifndef TEXTURE_PACK_HPP
+#define TEXTURE_PACK_HPP
+
+#include "block-compression.hpp"
+#include "mapped-file.hpp"
+#include "texture-cache.hpp"
+#include "texture-image.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define TEXTURE_PACK_MAGIC 0x4B505854
+#define TEXTURE_PACK_VERSION 2
+#define TEXTURE_PACK_EXTENSION ".texpack"
+#define TEXTURE_PACK_ALIGNMENT 4096
+
+struct TexturePackHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+
+    uint64_t entriesOffset;
+    uint64_t pathsOffset;
+    uint64_t pathsSize;
+};
+
+/* One texture in the pack, found by the path of the image it was built from.
+ * The header is a texture cache's, with level offsets counting from the start
+ * of the pack. */
+struct TexturePackEntry
+{
+    uint64_t pathOffset;
+    uint32_t pathSize;
+    uint32_t reserved;
+
+    TextureCacheHeader texture;
+};
+
+/* Many texture caches in one file: every mip chain lies whole and page
+ * aligned, followed by a table of the textures and their paths. The file is
+ * mapped once and each texture is read straight out of the mapping, so
+ * loading a packed texture opens no file and copies nothing before GL. */
+class TexturePack
+{
+    private:
+
+        std::shared_ptr<const MappedFile> file;
+        std::unordered_map<std::string, size_t> headerOffsets;
+
+    public:
+
+        TexturePack (const char* packPath);
+
+        TexturePack (const TexturePack&) = delete;
+        TexturePack& operator= (const TexturePack&) = delete;
+
+        bool isValid () const;
+        const size_t getTextureCount () const;
+        std::shared_ptr<TextureCache> find (const char* sourcePath) const;
+
+        static std::string getPackKey (const char* sourcePath);
+};
+
+/* Writes a pack one texture at a time. Level data goes to the file as each
+ * texture is added and the table is written by finish(), so only one chain is
+ * ever held in memory. Nothing replaces the pack until finish() succeeds. */
+class TexturePackWriter
+{
+    private:
+
+        std::string packPath;
+        std::string temporaryPath;
+        std::ofstream file;
+        size_t offset;
+        std::vector<TexturePackEntry> entries;
+        std::string paths;
+
+        void padTo (size_t target);
+
+    public:
+
+        TexturePackWriter (const char* packPath);
+
+        TexturePackWriter (const TexturePackWriter&) = delete;
+        TexturePackWriter& operator= (const TexturePackWriter&) = delete;
+
+        bool add (const char* sourcePath, CompressedFormat format, uint32_t processingFlags, const std::vector<ImageLevel>& levels);
+        bool add (const char* sourcePath, const TextureCache& cache);
+        bool finish ();
+
+        const size_t getTextureCount () const;
+        const size_t getSize () const;
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef TEXTURE_UPLOAD_RING_HPP
+#define TEXTURE_UPLOAD_RING_HPP
+
+#include "glad/glad.h"
+
+#include <stddef.h>
+#include <deque>
+#include <ostream>
+
+#define DEFAULT_UPLOAD_RING_SIZE (32 << 20)
+#define UPLOAD_RING_ALIGNMENT 256
+#define UPLOAD_RING_WAIT_TIMEOUT 1000000000
+
+struct TextureUploadStatistics
+{
+    size_t uploadCount;
+    size_t ringUploadCount;
+    size_t bytesUploaded;
+    size_t stallCount;
+    double stallSeconds;
+};
+
+/* A pixel unpack buffer used as a ring of staging memory. Each upload copies
+ * into the next free region and hands the driver an offset instead of a
+ * client pointer, so glTexImage2D returns without copying and the transfer
+ * overlaps whatever the CPU does next. A fence per region says when the GPU
+ * has finished reading it; the ring only blocks when it wraps onto a region
+ * that is still in flight. All of it must be used on the GL thread. */
+class TextureUploadRing
+{
+    private:
+
+        struct Region
+        {
+            size_t offset;
+            size_t size;
+            GLsync fence;
+        };
+
+        GLuint buffer;
+        size_t size;
+        size_t head;
+        std::deque<Region> pending;
+
+        bool staging;
+        Region current;
+
+        TextureUploadStatistics frameStatistics;
+        TextureUploadStatistics totalStatistics;
+
+        void retireSignaledRegions ();
+        void waitForRegion (size_t offset, size_t size);
+
+    public:
+
+        TextureUploadRing (size_t size = DEFAULT_UPLOAD_RING_SIZE);
+        ~TextureUploadRing ();
+
+        TextureUploadRing (const TextureUploadRing&) = delete;
+        TextureUploadRing& operator= (const TextureUploadRing&) = delete;
+
+        const void* stage (const void* data, size_t dataSize);
+        void finish ();
+
+        void beginFrame ();
+
+        const size_t getSize () const;
+        const TextureUploadStatistics& getFrameStatistics () const;
+        const TextureUploadStatistics& getTotalStatistics () const;
+};
+
+std::ostream& operator<<(std::ostream& os, const TextureUploadStatistics& statistics);
+
+#endif
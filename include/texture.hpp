@@ -3,17 +3,70 @@
 
 #include "glad/glad.h"
 
+#include <stdint.h>
+#include <vector>
+#include "block-compression.hpp"
+#include "texture-cache.hpp"
+#include "texture-cooker.hpp"
+#include "texture-image.hpp"
+#include "texture-upload-ring.hpp"
+
+#define PLACEHOLDER_TEXTURE_COLOR 0xFF808080
+#define DEFAULT_USE_TEXTURE_CACHE true
+
+struct TextureOptions
+{
+    // Without a cooked cache the mip chain is built on the CPU and, with this
+    // set, saved next to the image as an RGBA8 cache for the next launch.
+    bool useTextureCache = DEFAULT_USE_TEXTURE_CACHE;
+    MipChainOptions mipChain;
+};
+
+uint32_t getTextureProcessingFlags (const TextureOptions& options);
+bool isCompressedFormatSupported (CompressedFormat format);
+
 class Texture
 {   
     private:
 
         GLuint texture;
+        bool ready;
+        bool failed;
+
+        // Bytes every level of the chain takes on the GPU, and the first one
+        // that is resident. The levels above it are kept empty.
+        std::vector<size_t> levelSizes;
+        unsigned int baseLevel;
+        int width;
+        int height;
+
+        unsigned int beginUpload (unsigned int levelCount);
+        void finishUpload (unsigned int baseLevel);
 
     public:
 
-        Texture (const char* textureFilePath);
+        Texture (uint32_t placeholderColor = PLACEHOLDER_TEXTURE_COLOR);
+        Texture (const char* textureFilePath, const TextureOptions& options = TextureOptions());
+        ~Texture ();
+
+        Texture (const Texture&) = delete;
+        Texture& operator= (const Texture&) = delete;
+
+        void upload (const std::vector<ImageLevel>& levels, TextureUploadRing* ring = nullptr, unsigned int baseLevel = 0);
+        void upload (const TextureCache& cache, TextureUploadRing* ring = nullptr, unsigned int baseLevel = 0, unsigned int firstLevel = 0);
+        size_t evict (unsigned int baseLevel);
+        void markFailed ();
+        bool isReady () const;
+        bool hasFailed () const;
+
+        const int getWidth () const;
+        const int getHeight () const;
+        const unsigned int getLevelCount () const;
+        const unsigned int getBaseLevel () const;
+        const size_t getLevelSize (unsigned int level) const;
+        const size_t getResidentSize () const;
 
         GLuint getID ();
 };
 
-#endif
\ No newline at end of file
+#endif
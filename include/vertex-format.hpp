@@ -0,0 +1,43 @@
+#ifndef VERTEX_FORMAT_HPP
+#define VERTEX_FORMAT_HPP
+
+#include "glm/glm.hpp"
+#include "mesh.hpp"
+
+#include <stdint.h>
+#include <ostream>
+#include <vector>
+
+enum VertexFormat : uint32_t
+{
+    VERTEX_FORMAT_FLOAT = 0,
+    VERTEX_FORMAT_COMPACT = 1,
+    VERTEX_FORMAT_COMPACT_OCTAHEDRAL = 2
+};
+
+#define DEFAULT_VERTEX_FORMAT VERTEX_FORMAT_FLOAT
+
+struct QuantizationReport
+{
+    uint32_t vertexSize;
+    float maxPositionError;
+    float meanPositionError;
+    float maxNormalErrorDegrees;
+    float maxUvCoordinateError;
+};
+
+struct PositionDequantization
+{
+    glm::vec3 offset;
+    glm::vec3 scale;
+};
+
+const VertexLayout makeVertexLayout (VertexFormat format);
+const PositionDequantization makePositionDequantization (VertexFormat format, glm::vec3 boundsMin, glm::vec3 boundsMax);
+
+void quantizeVertices (const Mesh& mesh, VertexFormat format, std::vector<unsigned char>& packedVertices, QuantizationReport& report);
+void decodeVertex (const unsigned char* packedVertex, VertexFormat format, const PositionDequantization& dequantization, float* vertex);
+
+std::ostream& operator<<(std::ostream& os, const QuantizationReport& report);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef VERTEX_INDEX_MAP_HPP
+#define VERTEX_INDEX_MAP_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+struct VertexKey
+{
+    int32_t vertex;
+    int32_t uvCoordinate;
+    int32_t surfaceNormal;
+};
+
+class VertexIndexMap
+{
+    private:
+
+        struct Slot
+        {
+            VertexKey key;
+            uint32_t value;
+        };
+
+        std::vector<Slot> slots;
+        size_t count;
+        size_t mask;
+
+        void grow ();
+
+    public:
+
+        VertexIndexMap (size_t expectedCount = 0);
+
+        uint32_t findOrInsert (const VertexKey& key, uint32_t value, bool& inserted);
+        void clear ();
+
+        const size_t getCount () const;
+};
+
+#endif
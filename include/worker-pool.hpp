@@ -0,0 +1,37 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool
+{
+    private:
+
+        std::vector<std::thread> workers;
+        std::deque<std::function<void ()>> tasks;
+
+        std::mutex taskMutex;
+        std::condition_variable taskCondition;
+        bool stopping;
+
+        void runWorker ();
+
+    public:
+
+        WorkerPool (unsigned int threadCount);
+        ~WorkerPool ();
+
+        WorkerPool (const WorkerPool&) = delete;
+        WorkerPool& operator= (const WorkerPool&) = delete;
+
+        void enqueue (std::function<void ()> task);
+
+        const unsigned int getThreadCount () const;
+};
+
+#endif
@@ -2,6 +2,7 @@
 out vec4 fragmentColor;
 
 #define POINT_LIGHT_COUNT 4
+#define MAX_MATERIAL_LAYERS 64
 
 struct Material {
     sampler2D diffuse;
@@ -59,12 +60,40 @@ uniform vec3 viewPosition;
 
 uniform Material material;
 
+// Set by MaterialArray::bind(). The maps then come from layer materialLayer
+// of the arrays instead of the material's own textures.
+uniform bool materialArrays = false;
+uniform sampler2DArray diffuseArray;
+uniform sampler2DArray specularArray;
+uniform sampler2DArray emissiveArray;
+uniform int materialLayer = 0;
+uniform float materialShines [MAX_MATERIAL_LAYERS];
+
 uniform SunLight sunLight;
 uniform PointLight pointLights [POINT_LIGHT_COUNT];
 uniform SpotLight spotLight;
 
+// Sampled once in main() and shared by every light.
+vec3 diffuseColor;
+vec3 specularColor;
+float shine;
+
 void main()
 {
+	if (materialArrays)
+	{
+		vec3 layerCoordinate = vec3(uvCoordinate, materialLayer);
+		diffuseColor = vec3(texture(diffuseArray, layerCoordinate));
+		specularColor = vec3(texture(specularArray, layerCoordinate));
+		shine = materialShines[materialLayer];
+	}
+	else
+	{
+		diffuseColor = vec3(texture(material.diffuse, uvCoordinate));
+		specularColor = vec3(texture(material.specular, uvCoordinate));
+		shine = material.shine;
+	}
+
 	vec3 viewDirection = normalize(viewPosition - fragmentPosition);
 
 	vec3 light = calcSunLight(sunLight, surfaceNormal, viewDirection);
@@ -84,11 +113,11 @@ vec3 calcSunLight (SunLight light, vec3 surfaceNormal, vec3 viewDirection)
 	vec3 lightDirection = normalize(-light.direction);
 	float diffuseStrength = max(dot(surfaceNormal, lightDirection), 0.0);
 	vec3 reflectDirection = reflect(-lightDirection, surfaceNormal);
-	float specularStrength = pow(max(dot(viewDirection, reflectDirection), 0.0), material.shine);
+	float specularStrength = pow(max(dot(viewDirection, reflectDirection), 0.0), shine);
 
-	vec3 ambient = light.ambient * vec3(texture(material.diffuse, uvCoordinate));
-	vec3 diffuse = light.diffuse * diffuseStrength * vec3(texture(material.diffuse, uvCoordinate));
-	vec3 specular = light.specular * specularStrength * vec3(texture(material.specular, uvCoordinate));
+	vec3 ambient = light.ambient * diffuseColor;
+	vec3 diffuse = light.diffuse * diffuseStrength * diffuseColor;
+	vec3 specular = light.specular * specularStrength * specularColor;
 
 	return (ambient + diffuse + specular);
 }
@@ -98,11 +127,11 @@ vec3 calcPointLight (PointLight light, vec3 surfaceNormal, vec3 fragmentPosition
 	vec3 lightDirection = normalize(light.position - fragmentPosition);
 	float diffuseStrength = max(dot(surfaceNormal, lightDirection), 0.0);
 	vec3 reflectDirection = reflect(-lightDirection, surfaceNormal);
-	float specularStrength = pow(max(dot(viewDirection, reflectDirection), 0.0), material.shine);
+	float specularStrength = pow(max(dot(viewDirection, reflectDirection), 0.0), shine);
 
-	vec3 ambient = light.ambient * vec3(texture(material.diffuse, uvCoordinate));
-	vec3 diffuse = light.diffuse * diffuseStrength * vec3(texture(material.diffuse, uvCoordinate));
-	vec3 specular = light.specular * specularStrength * vec3(texture(material.specular, uvCoordinate));
+	vec3 ambient = light.ambient * diffuseColor;
+	vec3 diffuse = light.diffuse * diffuseStrength * diffuseColor;
+	vec3 specular = light.specular * specularStrength * specularColor;
 
 	float distance = length(light.position - fragmentPosition);
 	float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
@@ -115,11 +144,11 @@ vec3 calcSpotLight (SpotLight light, vec3 surfaceNormal, vec3 fragmentPosition,
 	vec3 lightDirection = normalize(light.position - fragmentPosition);
 	float diffuseStrength = max(dot(surfaceNormal, lightDirection), 0.0);
 	vec3 reflectDirection = reflect(-lightDirection, surfaceNormal);
-	float specularStrength = pow(max(dot(viewDirection, reflectDirection), 0.0), material.shine);
+	float specularStrength = pow(max(dot(viewDirection, reflectDirection), 0.0), shine);
 
-	vec3 ambient = light.ambient * vec3(texture(material.diffuse, uvCoordinate));
-	vec3 diffuse = light.diffuse * diffuseStrength * vec3(texture(material.diffuse, uvCoordinate));
-	vec3 specular = light.specular * specularStrength * vec3(texture(material.specular, uvCoordinate));
+	vec3 ambient = light.ambient * diffuseColor;
+	vec3 diffuse = light.diffuse * diffuseStrength * diffuseColor;
+	vec3 specular = light.specular * specularStrength * specularColor;
 
 	float distance = length(light.position - fragmentPosition);
 	float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
@@ -11,10 +11,29 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+uniform vec3 positionOffset = vec3(0.0);
+uniform vec3 positionScale = vec3(1.0);
+uniform bool octahedralNormals = false;
+
+// Offset in xy and scale in zw of the object's image within an atlas page.
+uniform vec4 uvRect = vec4(0.0, 0.0, 1.0, 1.0);
+
+vec3 decodeOctahedral (vec2 encoded)
+{
+	vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float fold = max(-normal.z, 0.0);
+	normal.x += normal.x >= 0.0 ? -fold : fold;
+	normal.y += normal.y >= 0.0 ? -fold : fold;
+	return normal;
+}
+
 void main()
 {
-	fragmentPosition = vec3(model * vec4(positionAttribute, 1.0));
-	surfaceNormal = normalize(mat3(transpose(inverse(model))) * surfaceNormalAttribute);
-	uvCoordinate = uvCoordinateAttribute;
+	vec3 position = positionOffset + positionAttribute * positionScale;
+	vec3 objectNormal = octahedralNormals ? decodeOctahedral(surfaceNormalAttribute.xy) : surfaceNormalAttribute;
+
+	fragmentPosition = vec3(model * vec4(position, 1.0));
+	surfaceNormal = normalize(mat3(transpose(inverse(model))) * objectNormal);
+	uvCoordinate = uvRect.xy + uvCoordinateAttribute * uvRect.zw;
 	gl_Position = projection * view * vec4(fragmentPosition, 1.0);
 }
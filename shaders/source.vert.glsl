@@ -5,7 +5,11 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+uniform vec3 positionOffset = vec3(0.0);
+uniform vec3 positionScale = vec3(1.0);
+
 void main()
 {
-	gl_Position = projection * view * model * vec4(positionAttribute, 1.0);
+	vec3 position = positionOffset + positionAttribute * positionScale;
+	gl_Position = projection * view * model * vec4(position, 1.0);
 }
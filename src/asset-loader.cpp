@@ -0,0 +1,368 @@
+#include "asset-loader.hpp"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+static bool isReadableFile (const char* filePath)
+{
+    struct stat fileStat;
+    return stat(filePath, &fileStat) == 0 && S_ISREG(fileStat.st_mode) && access(filePath, R_OK) == 0;
+}
+
+/* File reads, OBJ parsing and image decoding run on the worker threads. Each
+ * finished job queues a follow-up that does the GL work, which only runs when
+ * the GL thread calls processUploads(). The resource handed back to the caller
+ * exists from the start and reports isReady() once its upload has run, so the
+ * load functions create placeholders and must also be called on the GL thread.
+ * Workers hand their reference on to the upload instead of keeping a copy, so
+ * the last reference to a resource is never dropped off the GL thread.
+ * Images decode on a pool of their own, so a batch of textures decodes in
+ * parallel instead of queueing behind a large model. A load that fails is
+ * reported and handed back the same way, marking the resource failed on the
+ * GL thread and leaving its placeholder in place. */
+AssetLoader::AssetLoader (unsigned int threadCount, unsigned int decodeThreadCount, size_t uploadRingSize)
+    : pendingCount(0)
+    , uploadRingSize(uploadRingSize)
+    , taskPool(threadCount)
+    , decodePool(decodeThreadCount)
+{ }
+
+void AssetLoader::enqueueTask (WorkerPool& pool, std::function<void ()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock (this->uploadMutex);
+        ++this->pendingCount;
+    }
+
+    pool.enqueue(std::move(task));
+}
+
+void AssetLoader::enqueueUpload (std::function<void ()> upload)
+{
+    {
+        std::lock_guard<std::mutex> lock (this->uploadMutex);
+        this->uploads.push_back(std::move(upload));
+    }
+
+    this->uploadCondition.notify_one();
+}
+
+/* Packs are searched in the order they were added, before any per-image
+ * cache. They are only read from the thread that loads textures, so they must
+ * all be added before the first texture is requested. Missing or malformed
+ * packs are left out. */
+bool AssetLoader::addTexturePack (const char* packPath)
+{
+    if (!TextureCache::exists(packPath))
+    {
+        return false;
+    }
+
+    std::unique_ptr<TexturePack> pack (new TexturePack(packPath));
+
+    if (!pack->isValid())
+    {
+        std::cerr << "Texture Pack Read Error for '" << packPath << "': not a valid texture pack" << std::endl;
+        return false;
+    }
+
+    this->texturePacks.push_back(std::move(pack));
+    return true;
+}
+
+std::shared_ptr<TextureCache> AssetLoader::findPackedTexture (const char* textureFilePath) const
+{
+    for (const std::unique_ptr<TexturePack>& pack : this->texturePacks)
+    {
+        std::shared_ptr<TextureCache> packed = pack->find(textureFilePath);
+
+        if (packed)
+        {
+            return packed;
+        }
+    }
+
+    return nullptr;
+}
+
+std::shared_ptr<Model> AssetLoader::loadModel (const char* objFilePath, const ModelOptions& options)
+{
+    std::shared_ptr<Model> model = std::make_shared<Model>();
+    std::string path = objFilePath;
+
+    this->enqueueTask(this->taskPool, [this, model, path, options]() mutable {
+        if (!isReadableFile(path.c_str()))
+        {
+            std::cerr << "Failed to load model at '" << path << "': Are you sure the path is correct?" << std::endl;
+            this->enqueueUpload([model = std::move(model)]() { model->markFailed(); });
+            return;
+        }
+
+        if (!model->load(path.c_str(), options))
+        {
+            this->enqueueUpload([model = std::move(model)]() { model->markFailed(); });
+            return;
+        }
+
+        this->enqueueUpload([model = std::move(model)]() { model->upload(); });
+    });
+
+    return model;
+}
+
+/* A cooked texture cache next to the image is used when it is still valid,
+ * which skips decoding and uploads block-compressed levels instead. */
+std::shared_ptr<Texture> AssetLoader::loadTexture (const char* textureFilePath, uint32_t placeholderColor, const TextureOptions& options)
+{
+    std::shared_ptr<Texture> texture = std::make_shared<Texture>(placeholderColor);
+    this->streamTexture(texture, textureFilePath, options, 0);
+    return texture;
+}
+
+/* Uploads the image's levels from the smallest one still residentSize texels
+ * across down, leaving any the texture already holds alone; zero uploads the
+ * whole chain. Reading the levels back maps the texture cache, so with caches
+ * enabled only the first load of an image has to decode it. The chain starts
+ * at the quality tier's level, and sizes are in that chain's texels. A texture
+ * pack holding the image comes before its own cache, and is used even when the
+ * image itself was not shipped. */
+void AssetLoader::streamTexture (const std::shared_ptr<Texture>& texture, const char* textureFilePath, const TextureOptions& options, int residentSize)
+{
+    std::string path = textureFilePath;
+    unsigned int firstLevel = getTextureQuality();
+    std::shared_ptr<TextureCache> packed = options.useTextureCache ? this->findPackedTexture(textureFilePath) : nullptr;
+
+    this->enqueueTask(this->decodePool, [this, texture, path, options, residentSize, firstLevel, packed]() mutable {
+        std::shared_ptr<TextureCache> cache;
+        uint32_t processingFlags = getMipChainFlags(options.mipChain);
+
+        if (packed && packed->isValidFor(path.c_str(), processingFlags, true))
+        {
+            cache = std::move(packed);
+        }
+        else if (options.useTextureCache)
+        {
+            cache = findTextureCache(path.c_str(), processingFlags);
+        }
+
+        if (cache)
+        {
+            const TextureCacheLevel& level = cache->getLevel(std::min(firstLevel, cache->getLevelCount() - 1));
+            unsigned int baseLevel = residentSize > 0 ? getMipLevelForSize(level.width, level.height, residentSize) : 0;
+
+            this->enqueueUpload([this, texture = std::move(texture), cache, baseLevel, firstLevel]() {
+                texture->upload(*cache, this->getUploadRing(), baseLevel, firstLevel);
+            });
+            return;
+        }
+
+        std::shared_ptr<std::vector<ImageLevel>> levels = std::make_shared<std::vector<ImageLevel>>();
+
+        if (!buildMipChain(path.c_str(), options.mipChain, options.useTextureCache, *levels, firstLevel))
+        {
+            std::cerr << "Failed to load texture at '" << path << "': Are you sure the path is correct?" << std::endl;
+            this->enqueueUpload([texture = std::move(texture)]() { texture->markFailed(); });
+            return;
+        }
+
+        unsigned int baseLevel = residentSize > 0 ? getMipLevelForSize((*levels)[0].width, (*levels)[0].height, residentSize) : 0;
+
+        this->enqueueUpload([this, texture = std::move(texture), levels, baseLevel]() {
+            texture->upload(*levels, this->getUploadRing(), baseLevel);
+        });
+    });
+}
+
+/* The images decode and pack on a single decode worker; the pages go up
+ * together in one upload. Regions can be looked up once the atlas is ready. */
+std::shared_ptr<TextureAtlas> AssetLoader::loadTextureAtlas (const std::vector<std::string>& imagePaths, const AtlasOptions& options)
+{
+    std::shared_ptr<TextureAtlas> atlas = std::make_shared<TextureAtlas>();
+
+    this->enqueueTask(this->decodePool, [this, atlas, imagePaths, options]() mutable {
+        if (!atlas->build(imagePaths, options))
+        {
+            this->enqueueUpload([atlas = std::move(atlas)]() { atlas->markFailed(); });
+            return;
+        }
+
+        this->enqueueUpload([this, atlas = std::move(atlas)]() { atlas->upload(this->getUploadRing()); });
+    });
+
+    return atlas;
+}
+
+/* Reserves the material's layer at once and fills it when all three maps have
+ * their mip chains, from the level the array was made at. The specular map is
+ * data rather than colour, so it is filtered without the sRGB conversion. */
+std::shared_ptr<Material> AssetLoader::loadArrayMaterial (
+    const std::shared_ptr<MaterialArray>& array,
+    const char* diffusePath,
+    const char* specularPath,
+    const char* emissivePath,
+    float shine
+)
+{
+    std::shared_ptr<Material> material = std::make_shared<Material>();
+    material->shine = shine;
+    material->array = array;
+    material->arrayLayer = array->reserveLayer(shine);
+
+    std::string paths [3] = { diffusePath, specularPath, emissivePath };
+
+    this->enqueueTask(this->decodePool, [this, array, layer = material->arrayLayer, paths, firstLevel = array->getFirstLevel()]() mutable {
+        std::shared_ptr<std::array<std::vector<ImageLevel>, 3>> levels = std::make_shared<std::array<std::vector<ImageLevel>, 3>>();
+
+        for (int i = 0; i < 3; ++i)
+        {
+            TextureOptions options;
+            options.mipChain.srgb = i != 1;
+
+            if (!loadMipChain(paths[i].c_str(), options.mipChain, options.useTextureCache, (*levels)[i], firstLevel))
+            {
+                // The layer is left unfilled; the upload only hands the array back to the GL thread.
+                std::cerr << "Failed to load texture at '" << paths[i] << "': Are you sure the path is correct?" << std::endl;
+                this->enqueueUpload([array = std::move(array)]() { });
+                return;
+            }
+        }
+
+        this->enqueueUpload([this, array = std::move(array), layer, levels]() {
+            array->upload(layer, (*levels)[0], (*levels)[1], (*levels)[2], this->getUploadRing());
+        });
+    });
+
+    return material;
+}
+
+/* The ring is made on the first texture upload rather than in the constructor,
+ * which may not run with a context current. A ring size of zero uploads
+ * straight from client memory. */
+TextureUploadRing* AssetLoader::getUploadRing ()
+{
+    if (this->uploadRingSize > 0 && !this->uploadRing)
+    {
+        this->uploadRing.reset(new TextureUploadRing(this->uploadRingSize));
+    }
+
+    return this->uploadRing.get();
+}
+
+std::shared_ptr<Shader> AssetLoader::loadShader (const char* vertexShaderPath, const char* fragmentShaderPath)
+{
+    std::shared_ptr<Shader> shader = std::make_shared<Shader>();
+    std::string vertexPath = vertexShaderPath;
+    std::string fragmentPath = fragmentShaderPath;
+
+    this->enqueueTask(this->taskPool, [this, shader, vertexPath, fragmentPath]() mutable {
+        std::shared_ptr<std::string> vertexSource = std::make_shared<std::string>();
+        std::shared_ptr<std::string> fragmentSource = std::make_shared<std::string>();
+
+        if (!Shader::readSourceFile(vertexPath.c_str(), *vertexSource) || !Shader::readSourceFile(fragmentPath.c_str(), *fragmentSource))
+        {
+            this->enqueueUpload([shader = std::move(shader)]() { shader->markFailed(); });
+            return;
+        }
+
+        this->enqueueUpload([shader = std::move(shader), vertexSource, fragmentSource]() { shader->compile(*vertexSource, *fragmentSource); });
+    });
+
+    return shader;
+}
+
+bool AssetLoader::runNextUpload ()
+{
+    std::function<void ()> upload;
+
+    {
+        std::lock_guard<std::mutex> lock (this->uploadMutex);
+
+        if (this->uploads.empty())
+        {
+            return false;
+        }
+
+        upload = std::move(this->uploads.front());
+        this->uploads.pop_front();
+    }
+
+    upload();
+
+    std::lock_guard<std::mutex> lock (this->uploadMutex);
+    --this->pendingCount;
+    return true;
+}
+
+/* Runs queued uploads on the calling thread, which must own the GL context,
+ * until the time budget is spent. At least one upload runs per call so loading
+ * always makes progress however small the budget. */
+unsigned int AssetLoader::processUploads (double budgetSeconds)
+{
+    auto start = std::chrono::steady_clock::now();
+    unsigned int processedCount = 0;
+
+    if (this->uploadRing)
+    {
+        this->uploadRing->beginFrame();
+    }
+
+    while (this->runNextUpload())
+    {
+        ++processedCount;
+
+        if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= budgetSeconds)
+        {
+            break;
+        }
+    }
+
+    return processedCount;
+}
+
+/* Blocks the GL thread until every requested asset is uploaded, running each
+ * upload as soon as its worker finishes. Loading a batch this way takes about
+ * as long as its slowest decode plus the uploads, rather than one frame's
+ * budget per asset. */
+unsigned int AssetLoader::finishLoading ()
+{
+    unsigned int processedCount = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock (this->uploadMutex);
+            this->uploadCondition.wait(lock, [this]() { return this->pendingCount == 0 || !this->uploads.empty(); });
+
+            if (this->uploads.empty())
+            {
+                return processedCount;
+            }
+        }
+
+        while (this->runNextUpload())
+        {
+            ++processedCount;
+        }
+    }
+}
+
+const size_t AssetLoader::getPendingCount ()
+{
+    std::lock_guard<std::mutex> lock (this->uploadMutex);
+    return this->pendingCount;
+}
+
+const TextureUploadStatistics AssetLoader::getFrameUploadStatistics () const
+{
+    return this->uploadRing ? this->uploadRing->getFrameStatistics() : TextureUploadStatistics {};
+}
+
+const TextureUploadStatistics AssetLoader::getTotalUploadStatistics () const
+{
+    return this->uploadRing ? this->uploadRing->getTotalStatistics() : TextureUploadStatistics {};
+}
@@ -0,0 +1,142 @@
+#include "asset-registry.hpp"
+
+#include <sys/stat.h>
+#include <filesystem>
+#include <iostream>
+
+static std::string getCanonicalPath (const char* filePath)
+{
+    std::error_code error;
+    std::filesystem::path canonicalPath = std::filesystem::weakly_canonical(filePath, error);
+    return error ? std::string(filePath) : canonicalPath.string();
+}
+
+/* Names the file itself, so hard links and other paths to the same inode
+ * share a key, from its metadata alone. A file that has changed since gets a
+ * new key. Empty if the file does not exist. */
+static std::string getFileKey (const char* filePath)
+{
+    struct stat fileStat;
+
+    if (stat(filePath, &fileStat) != 0)
+    {
+        return std::string();
+    }
+
+    int64_t modifiedTime = (int64_t) fileStat.st_mtim.tv_sec * 1000000000 + fileStat.st_mtim.tv_nsec;
+
+    return std::to_string(fileStat.st_dev) + ":" + std::to_string(fileStat.st_ino) + ":"
+        + std::to_string(fileStat.st_size) + ":" + std::to_string(modifiedTime);
+}
+
+template <typename Asset>
+static size_t pruneEntries (std::unordered_map<std::string, std::weak_ptr<Asset>>& entries)
+{
+    size_t liveCount = 0;
+
+    for (auto entry = entries.begin(); entry != entries.end();)
+    {
+        if (entry->second.expired())
+        {
+            entry = entries.erase(entry);
+        }
+        else
+        {
+            ++liveCount;
+            ++entry;
+        }
+    }
+
+    return liveCount;
+}
+
+/* With a texture manager, textures are loaded through it and stream their
+ * levels within its budget. */
+AssetRegistry::AssetRegistry (AssetLoader& loader, TextureManager* textureManager)
+    : loader(loader)
+    , textureManager(textureManager)
+    , statistics {}
+{ }
+
+/* Assets are looked up by canonical path first. On a miss the file is
+ * looked up by device, inode, size and modification time, so the same file
+ * under another name or link is still shared. Only the file's metadata is
+ * read; its contents are left to the loader's threads. A file that is not
+ * there, such as an image only shipped in a texture pack, is known by its
+ * path alone. The variant separates loads of the same file that produce
+ * different results. The registry only keeps weak references, so an asset is
+ * released, GPU objects included, as soon as its last handle goes. */
+template <typename Asset, typename Load>
+std::shared_ptr<Asset> AssetRegistry::find (Entries<Asset>& entries, const char* filePath, const std::string& variant, Load load)
+{
+    std::string pathKey = getCanonicalPath(filePath) + "|" + variant;
+    std::shared_ptr<Asset> asset = entries.byPath[pathKey].lock();
+
+    if (asset)
+    {
+        ++this->statistics.pathHits;
+        return asset;
+    }
+
+    std::string fileKey = getFileKey(filePath);
+    fileKey = fileKey.empty() ? pathKey : fileKey + "|" + variant;
+    asset = entries.byFile[fileKey].lock();
+
+    if (asset)
+    {
+        ++this->statistics.fileHits;
+    }
+    else
+    {
+        asset = load();
+        entries.byFile[fileKey] = asset;
+        ++this->statistics.loads;
+    }
+
+    entries.byPath[pathKey] = asset;
+    return asset;
+}
+
+std::shared_ptr<Model> AssetRegistry::getModel (const char* objFilePath, const ModelOptions& options)
+{
+    std::string variant = std::to_string(getModelProcessingFlags(options));
+
+    return this->find(this->models, objFilePath, variant, [&]() {
+        return this->loader.loadModel(objFilePath, options);
+    });
+}
+
+std::shared_ptr<Texture> AssetRegistry::getTexture (const char* textureFilePath, uint32_t placeholderColor, const TextureOptions& options)
+{
+    std::string variant = std::to_string(getTextureProcessingFlags(options));
+
+    return this->find(this->textures, textureFilePath, variant, [&]() {
+        if (this->textureManager)
+        {
+            return this->textureManager->loadTexture(textureFilePath, placeholderColor, options);
+        }
+
+        return this->loader.loadTexture(textureFilePath, placeholderColor, options);
+    });
+}
+
+void AssetRegistry::collectGarbage ()
+{
+    pruneEntries(this->models.byPath);
+    pruneEntries(this->textures.byPath);
+    this->statistics.modelCount = pruneEntries(this->models.byFile);
+    this->statistics.textureCount = pruneEntries(this->textures.byFile);
+}
+
+const AssetRegistryStatistics AssetRegistry::getStatistics ()
+{
+    this->collectGarbage();
+    return this->statistics;
+}
+
+std::ostream& operator<<(std::ostream& os, const AssetRegistryStatistics& statistics)
+{
+    os << statistics.modelCount << " models, " << statistics.textureCount << " textures loaded, ";
+    os << statistics.loads << " loads, " << statistics.pathHits << " path hits, " << statistics.fileHits << " file hits";
+    return os;
+}
@@ -0,0 +1,209 @@
+#include "atlas-data.hpp"
+#include "skyline-packer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+
+static int roundUpToPowerOfTwo (int value)
+{
+    int power = 1;
+
+    while (power < value)
+    {
+        power *= 2;
+    }
+
+    return power;
+}
+
+/* Copies the image into the page and repeats its outermost rows and columns
+ * over the padding, so filtering at the edge reads the image rather than
+ * whatever sits next to it. */
+static void blitWithBleed (const TextureImage& image, const AtlasRegion& region, int padding, AtlasPage& page, std::vector<unsigned char>& pixels)
+{
+    size_t pixelSize = TEXTURE_IMAGE_CHANNELS;
+    size_t rowSize = (size_t) image.width * pixelSize;
+
+    for (int y = region.y - padding; y < region.y + region.height + padding; ++y)
+    {
+        int sourceY = std::min(std::max(y - region.y, 0), image.height - 1);
+        const unsigned char* source = image.pixels.get() + sourceY * rowSize;
+        unsigned char* target = pixels.data() + ((size_t) y * page.width + region.x) * pixelSize;
+
+        std::memcpy(target, source, rowSize);
+
+        for (int x = 1; x <= padding; ++x)
+        {
+            std::memcpy(target - x * pixelSize, source, pixelSize);
+            std::memcpy(target + rowSize + (x - 1) * pixelSize, source + rowSize - pixelSize, pixelSize);
+        }
+    }
+}
+
+AtlasData::AtlasData ()
+{ }
+
+AtlasData::AtlasData (const std::vector<std::string>& imagePaths, const AtlasOptions& options)
+{
+    if (!this->build(imagePaths, options))
+    {
+        exit(-1);
+    }
+}
+
+/* Images are packed tallest first, in whole cells of the padding size, onto
+ * as many pages as they need. Each page is then trimmed to what was used.
+ * Returns false, with the error reported and the atlas left empty, if an
+ * image cannot be decoded or is too big for a page. */
+bool AtlasData::build (const std::vector<std::string>& imagePaths, const AtlasOptions& options)
+{
+    int padding = roundUpToPowerOfTwo(std::max(options.padding, 1));
+    int pageCells = options.pageSize / padding;
+    std::vector<TextureImage> images (imagePaths.size());
+
+    this->pages.clear();
+    this->regions.clear();
+
+    for (size_t i = 0; i < imagePaths.size(); ++i)
+    {
+        if (!decodeTextureImage(imagePaths[i].c_str(), images[i]))
+        {
+            std::cerr << "Failed to load texture at '" << imagePaths[i] << "': Are you sure the path is correct?" << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<size_t> order (images.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return images[a].height != images[b].height ? images[a].height > images[b].height : images[a].width > images[b].width;
+    });
+
+    std::vector<SkylinePacker> packers;
+    std::vector<AtlasRegion> placed (images.size());
+
+    for (size_t i : order)
+    {
+        int cellsX = (images[i].width + 2 * padding + padding - 1) / padding;
+        int cellsY = (images[i].height + 2 * padding + padding - 1) / padding;
+        int cellX = 0;
+        int cellY = 0;
+        size_t page = 0;
+
+        if (cellsX > pageCells || cellsY > pageCells)
+        {
+            std::cerr << "Texture Atlas Error for '" << imagePaths[i] << "': "
+                << images[i].width << "x" << images[i].height << " does not fit on a " << options.pageSize << " page" << std::endl;
+            this->pages.clear();
+            return false;
+        }
+
+        while (page < packers.size() && !packers[page].insert(cellsX, cellsY, cellX, cellY))
+        {
+            ++page;
+        }
+
+        if (page == packers.size())
+        {
+            packers.emplace_back(pageCells, pageCells);
+            packers.back().insert(cellsX, cellsY, cellX, cellY);
+            this->pages.push_back({ padding, padding, 0.0f, {} });
+        }
+
+        AtlasRegion& region = placed[i];
+        region = { (unsigned int) page, (cellX + 1) * padding, (cellY + 1) * padding, images[i].width, images[i].height, glm::vec4(0.0f) };
+
+        AtlasPage& atlasPage = this->pages[page];
+        atlasPage.width = std::max(atlasPage.width, (cellX + cellsX) * padding);
+        atlasPage.height = std::max(atlasPage.height, (cellY + cellsY) * padding);
+    }
+
+    std::vector<std::vector<unsigned char>> pixels (this->pages.size());
+
+    for (size_t page = 0; page < this->pages.size(); ++page)
+    {
+        pixels[page].assign((size_t) this->pages[page].width * this->pages[page].height * TEXTURE_IMAGE_CHANNELS, 0);
+    }
+
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        AtlasRegion& region = placed[i];
+        AtlasPage& page = this->pages[region.page];
+
+        region.uvRect = glm::vec4(
+            (float) region.x / page.width,
+            (float) region.y / page.height,
+            (float) region.width / page.width,
+            (float) region.height / page.height
+        );
+
+        blitWithBleed(images[i], region, padding, page, pixels[region.page]);
+        page.occupancy += (float) region.width * region.height / ((float) page.width * page.height);
+        this->regions[imagePaths[i]] = region;
+    }
+
+    // Level n averages 2^n texels a side, which stays inside the padding up
+    // to the level where that is the padding itself. Lower quality tiers
+    // leave out the top levels; page and region sizes stay in full texels.
+    unsigned int levelCount = getMipLevelCount(padding, padding);
+    unsigned int firstLevel = std::min((unsigned int) getTextureQuality(), levelCount - 1);
+
+    for (size_t page = 0; page < this->pages.size(); ++page)
+    {
+        AtlasPage& atlasPage = this->pages[page];
+        atlasPage.levels = generateMipChain(pixels[page].data(), atlasPage.width, atlasPage.height, options.mipChain, firstLevel);
+        atlasPage.levels.resize(std::min((size_t)(levelCount - firstLevel), atlasPage.levels.size()));
+        std::vector<unsigned char>().swap(pixels[page]);
+    }
+
+    return true;
+}
+
+const unsigned int AtlasData::getPageCount () const
+{
+    return this->pages.size();
+}
+
+const AtlasPage& AtlasData::getPage (unsigned int page) const
+{
+    return this->pages[page];
+}
+
+bool AtlasData::hasRegion (const std::string& imagePath) const
+{
+    return this->regions.count(imagePath) != 0;
+}
+
+const AtlasRegion& AtlasData::getRegion (const std::string& imagePath) const
+{
+    auto region = this->regions.find(imagePath);
+
+    if (region == this->regions.end())
+    {
+        std::cerr << "Texture Atlas Error for '" << imagePath << "': not in the atlas" << std::endl;
+        exit(-1);
+    }
+
+    return region->second;
+}
+
+const std::unordered_map<std::string, AtlasRegion>& AtlasData::getRegions () const
+{
+    return this->regions;
+}
+
+std::ostream& operator<<(std::ostream& os, const AtlasData& atlas)
+{
+    os << atlas.getRegions().size() << " images on " << atlas.getPageCount() << " pages";
+
+    for (unsigned int i = 0; i < atlas.getPageCount(); ++i)
+    {
+        const AtlasPage& page = atlas.getPage(i);
+        os << (i == 0 ? ": " : ", ") << page.width << "x" << page.height << " (" << std::fixed << std::setprecision(1) << page.occupancy * 100.0f << "% used)";
+    }
+
+    return os;
+}
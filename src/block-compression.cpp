@@ -0,0 +1,1022 @@
+#include "block-compression.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#define BLOCK_PIXEL_COUNT 16
+#define PRINCIPAL_AXIS_ITERATIONS 8
+#define ENDPOINT_REFINEMENT_PASSES 2
+
+static const int bc7Weights2 [4] = { 0, 21, 43, 64 };
+static const int bc7Weights4 [16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+/* Gathers a 4x4 block of RGBA pixels, repeating the last row and column for
+ * blocks that hang over the edge of the image. */
+static void loadBlock (const unsigned char* pixels, int width, int height, int blockX, int blockY, unsigned char* block)
+{
+    for (int y = 0; y < COMPRESSED_BLOCK_SIZE; ++y)
+    {
+        int sourceY = std::min(blockY * COMPRESSED_BLOCK_SIZE + y, height - 1);
+
+        for (int x = 0; x < COMPRESSED_BLOCK_SIZE; ++x)
+        {
+            int sourceX = std::min(blockX * COMPRESSED_BLOCK_SIZE + x, width - 1);
+            std::memcpy(block + (y * COMPRESSED_BLOCK_SIZE + x) * 4, pixels + ((size_t) sourceY * width + sourceX) * 4, 4);
+        }
+    }
+}
+
+static void storeBlock (const unsigned char* block, int width, int height, int blockX, int blockY, unsigned char* pixels)
+{
+    for (int y = 0; y < COMPRESSED_BLOCK_SIZE && blockY * COMPRESSED_BLOCK_SIZE + y < height; ++y)
+    {
+        int targetY = blockY * COMPRESSED_BLOCK_SIZE + y;
+
+        for (int x = 0; x < COMPRESSED_BLOCK_SIZE && blockX * COMPRESSED_BLOCK_SIZE + x < width; ++x)
+        {
+            int targetX = blockX * COMPRESSED_BLOCK_SIZE + x;
+            std::memcpy(pixels + ((size_t) targetY * width + targetX) * 4, block + (y * COMPRESSED_BLOCK_SIZE + x) * 4, 4);
+        }
+    }
+}
+
+static void loadBlockPoints (const unsigned char* block, float (*points)[4])
+{
+    for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            points[i][c] = block[i * 4 + c];
+        }
+    }
+}
+
+/* Finds the mean of the block and the direction it varies most along, by power
+ * iteration on the covariance matrix. A flat block leaves the axis at zero. */
+static void computePrincipalAxis (const float (*points)[4], int channelCount, float* mean, float* axis)
+{
+    for (int c = 0; c < channelCount; ++c)
+    {
+        mean[c] = 0.0f;
+
+        for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+        {
+            mean[c] += points[i][c];
+        }
+
+        mean[c] /= BLOCK_PIXEL_COUNT;
+    }
+
+    float covariance [4][4] = {};
+
+    for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+    {
+        for (int a = 0; a < channelCount; ++a)
+        {
+            for (int b = 0; b < channelCount; ++b)
+            {
+                covariance[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+            }
+        }
+    }
+
+    int largest = 0;
+
+    for (int c = 0; c < channelCount; ++c)
+    {
+        axis[c] = 0.0f;
+
+        if (covariance[c][c] > covariance[largest][largest])
+        {
+            largest = c;
+        }
+    }
+
+    if (covariance[largest][largest] <= 0.0f)
+    {
+        return;
+    }
+
+    for (int c = 0; c < channelCount; ++c)
+    {
+        axis[c] = covariance[largest][c];
+    }
+
+    for (int iteration = 0; iteration < PRINCIPAL_AXIS_ITERATIONS; ++iteration)
+    {
+        float next [4] = {};
+        float length = 0.0f;
+
+        for (int a = 0; a < channelCount; ++a)
+        {
+            for (int b = 0; b < channelCount; ++b)
+            {
+                next[a] += covariance[a][b] * axis[b];
+            }
+
+            length += next[a] * next[a];
+        }
+
+        if (length <= FLT_MIN)
+        {
+            break;
+        }
+
+        length = std::sqrt(length);
+
+        for (int c = 0; c < channelCount; ++c)
+        {
+            axis[c] = next[c] / length;
+        }
+    }
+}
+
+/* Starting endpoints: the extremes of the block projected onto its principal axis. */
+static void computeAxisEndpoints (const float (*points)[4], int channelCount, float* start, float* end)
+{
+    float mean [4];
+    float axis [4];
+    computePrincipalAxis(points, channelCount, mean, axis);
+
+    float minimum = FLT_MAX;
+    float maximum = -FLT_MAX;
+
+    for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+    {
+        float projection = 0.0f;
+
+        for (int c = 0; c < channelCount; ++c)
+        {
+            projection += (points[i][c] - mean[c]) * axis[c];
+        }
+
+        minimum = std::min(minimum, projection);
+        maximum = std::max(maximum, projection);
+    }
+
+    for (int c = 0; c < channelCount; ++c)
+    {
+        start[c] = std::min(std::max(mean[c] + axis[c] * minimum, 0.0f), 255.0f);
+        end[c] = std::min(std::max(mean[c] + axis[c] * maximum, 0.0f), 255.0f);
+    }
+}
+
+/* Least squares endpoints for fixed indices, where each weight says how far a
+ * pixel sits from start towards end. Returns false when every pixel has the
+ * same weight and the system has no unique solution. */
+static bool fitEndpoints (const float (*points)[4], const float* weights, int channelCount, float* start, float* end)
+{
+    float aa = 0.0f;
+    float ab = 0.0f;
+    float bb = 0.0f;
+    float ax [4] = {};
+    float bx [4] = {};
+
+    for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+    {
+        float a = 1.0f - weights[i];
+        float b = weights[i];
+
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+
+        for (int c = 0; c < channelCount; ++c)
+        {
+            ax[c] += a * points[i][c];
+            bx[c] += b * points[i][c];
+        }
+    }
+
+    float determinant = aa * bb - ab * ab;
+
+    if (std::fabs(determinant) < 1e-6f)
+    {
+        return false;
+    }
+
+    for (int c = 0; c < channelCount; ++c)
+    {
+        start[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) / determinant, 0.0f), 255.0f);
+        end[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) / determinant, 0.0f), 255.0f);
+    }
+
+    return true;
+}
+
+static uint16_t packColor565 (const float* color)
+{
+    int r = (int) std::lround(color[0] * 31.0f / 255.0f);
+    int g = (int) std::lround(color[1] * 63.0f / 255.0f);
+    int b = (int) std::lround(color[2] * 31.0f / 255.0f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void unpackColor565 (uint16_t color, int* rgb)
+{
+    int r = color >> 11;
+    int g = (color >> 5) & 63;
+    int b = color & 31;
+
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+static void makeColorPalette (uint16_t color0, uint16_t color1, bool fourColors, int (*palette)[4])
+{
+    unpackColor565(color0, palette[0]);
+    unpackColor565(color1, palette[1]);
+    palette[0][3] = 255;
+    palette[1][3] = 255;
+
+    for (int c = 0; c < 3; ++c)
+    {
+        if (fourColors)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+
+    palette[2][3] = 255;
+    palette[3][3] = fourColors ? 255 : 0;
+}
+
+static float chooseColorIndices (const unsigned char* block, uint16_t color0, uint16_t color1, uint32_t& indices)
+{
+    int palette [4][4];
+    makeColorPalette(color0, color1, true, palette);
+
+    float totalError = 0.0f;
+    indices = 0;
+
+    for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+    {
+        int bestIndex = 0;
+        int bestError = INT32_MAX;
+
+        for (int p = 0; p < 4; ++p)
+        {
+            int error = 0;
+
+            for (int c = 0; c < 3; ++c)
+            {
+                int difference = block[i * 4 + c] - palette[p][c];
+                error += difference * difference;
+            }
+
+            if (error < bestError)
+            {
+                bestError = error;
+                bestIndex = p;
+            }
+        }
+
+        indices |= (uint32_t) bestIndex << (2 * i);
+        totalError += bestError;
+    }
+
+    return totalError;
+}
+
+/* BC1 colour block in four colour mode: endpoints along the principal axis,
+ * refined by least squares against the indices they produce. The endpoint
+ * order is fixed up at the end since four colour mode needs color0 > color1. */
+static void encodeColorBlock (const unsigned char* block, unsigned char* output)
+{
+    static const float indexWeights [4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+    float points [BLOCK_PIXEL_COUNT][4];
+    loadBlockPoints(block, points);
+
+    float start [4];
+    float end [4];
+    computeAxisEndpoints(points, 3, end, start);
+
+    uint16_t bestColor0 = 0;
+    uint16_t bestColor1 = 0;
+    uint32_t bestIndices = 0;
+    float bestError = FLT_MAX;
+
+    for (int pass = 0; pass <= ENDPOINT_REFINEMENT_PASSES; ++pass)
+    {
+        uint16_t color0 = packColor565(start);
+        uint16_t color1 = packColor565(end);
+        uint32_t indices;
+        float error = chooseColorIndices(block, color0, color1, indices);
+
+        if (error < bestError)
+        {
+            bestError = error;
+            bestColor0 = color0;
+            bestColor1 = color1;
+            bestIndices = indices;
+        }
+
+        float weights [BLOCK_PIXEL_COUNT];
+
+        for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+        {
+            weights[i] = indexWeights[(indices >> (2 * i)) & 3];
+        }
+
+        if (pass == ENDPOINT_REFINEMENT_PASSES || !fitEndpoints(points, weights, 3, start, end))
+        {
+            break;
+        }
+    }
+
+    if (bestColor0 < bestColor1)
+    {
+        std::swap(bestColor0, bestColor1);
+        bestIndices ^= 0x55555555;
+    }
+    else if (bestColor0 == bestColor1)
+    {
+        bestIndices = 0;
+    }
+
+    output[0] = bestColor0 & 0xFF;
+    output[1] = bestColor0 >> 8;
+    output[2] = bestColor1 & 0xFF;
+    output[3] = bestColor1 >> 8;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        output[4 + i] = (bestIndices >> (8 * i)) & 0xFF;
+    }
+}
+
+static void decodeColorBlock (const unsigned char* input, bool forceFourColors, unsigned char* block)
+{
+    uint16_t color0 = input[0] | (input[1] << 8);
+    uint16_t color1 = input[2] | (input[3] << 8);
+    uint32_t indices = input[4] | (input[5] << 8) | (input[6] << 16) | ((uint32_t) input[7] << 24);
+
+    int palette [4][4];
+    makeColorPalette(color0, color1, forceFourColors || color0 > color1, palette);
+
+    for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+    {
+        const int* color = palette[(indices >> (2 * i)) & 3];
+
+        for (int c = 0; c < 4; ++c)
+        {
+            block[i * 4 + c] = color[c];
+        }
+    }
+}
+
+static void makeChannelPalette (int value0, int value1, int* palette)
+{
+    palette[0] = value0;
+    palette[1] = value1;
+
+    for (int i = 2; i < 8; ++i)
+    {
+        palette[i] = ((8 - i) * value0 + (i - 1) * value1 + 3) / 7;
+    }
+}
+
+/* BC4 block for one channel of the RGBA block, always in the eight value mode
+ * with the block's maximum and minimum as endpoints. BC3 uses the same
+ * layout for alpha. */
+static void encodeChannelBlock (const unsigned char* block, int channel, unsigned char* output)
+{
+    int minimum = 255;
+    int maximum = 0;
+
+    for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+    {
+        minimum = std::min(minimum, (int) block[i * 4 + channel]);
+        maximum = std::max(maximum, (int) block[i * 4 + channel]);
+    }
+
+    output[0] = maximum;
+    output[1] = minimum;
+    std::memset(output + 2, 0, 6);
+
+    if (maximum == minimum)
+    {
+        return;
+    }
+
+    int palette [8];
+    makeChannelPalette(maximum, minimum, palette);
+
+    uint64_t indices = 0;
+
+    for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+    {
+        int value = block[i * 4 + channel];
+        int bestIndex = 0;
+
+        for (int p = 1; p < 8; ++p)
+        {
+            if (std::abs(value - palette[p]) < std::abs(value - palette[bestIndex]))
+            {
+                bestIndex = p;
+            }
+        }
+
+        indices |= (uint64_t) bestIndex << (3 * i);
+    }
+
+    for (int i = 0; i < 6; ++i)
+    {
+        output[2 + i] = (indices >> (8 * i)) & 0xFF;
+    }
+}
+
+static void decodeChannelBlock (const unsigned char* input, unsigned char* values)
+{
+    int palette [8];
+
+    if (input[0] > input[1])
+    {
+        makeChannelPalette(input[0], input[1], palette);
+    }
+    else
+    {
+        palette[0] = input[0];
+        palette[1] = input[1];
+
+        for (int i = 2; i < 6; ++i)
+        {
+            palette[i] = ((6 - i) * input[0] + (i - 1) * input[1] + 2) / 5;
+        }
+
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t indices = 0;
+
+    for (int i = 0; i < 6; ++i)
+    {
+        indices |= (uint64_t) input[2 + i] << (8 * i);
+    }
+
+    for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+    {
+        values[i] = palette[(indices >> (3 * i)) & 7];
+    }
+}
+
+static void writeBits (unsigned char* output, int& position, uint32_t value, int count)
+{
+    for (int i = 0; i < count; ++i, ++position)
+    {
+        if ((value >> i) & 1)
+        {
+            output[position >> 3] |= 1 << (position & 7);
+        }
+    }
+}
+
+static uint32_t readBits (const unsigned char* input, int& position, int count)
+{
+    uint32_t value = 0;
+
+    for (int i = 0; i < count; ++i, ++position)
+    {
+        value |= (uint32_t)((input[position >> 3] >> (position & 7)) & 1) << i;
+    }
+
+    return value;
+}
+
+/* Picks the nearest of paletteSize entries for each pixel over the given
+ * channels. Stops early and returns FLT_MAX once the error passes limit. */
+static float chooseBc7Indices (const unsigned char* block, const int (*palette)[4], int paletteSize, int firstChannel, int channelCount, float limit, int* indices)
+{
+    float error = 0.0f;
+
+    for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+    {
+        int bestPixelError = INT32_MAX;
+
+        for (int p = 0; p < paletteSize; ++p)
+        {
+            int pixelError = 0;
+
+            for (int c = firstChannel; c < firstChannel + channelCount; ++c)
+            {
+                int difference = block[i * 4 + c] - palette[p][c];
+                pixelError += difference * difference;
+            }
+
+            if (pixelError < bestPixelError)
+            {
+                bestPixelError = pixelError;
+                indices[i] = p;
+            }
+        }
+
+        error += bestPixelError;
+
+        if (error >= limit)
+        {
+            return FLT_MAX;
+        }
+    }
+
+    return error;
+}
+
+/* Mode 6: one subset, 7 bit RGBA endpoints with a shared low bit per endpoint
+ * and 4 bit indices shared by colour and alpha. Every p-bit combination is
+ * tried for each set of endpoints. Opaque blocks only try the combination
+ * that can still store an alpha of exactly 255. */
+static float encodeBc7Mode6 (const unsigned char* block, bool opaque, unsigned char* output)
+{
+    float points [BLOCK_PIXEL_COUNT][4];
+    loadBlockPoints(block, points);
+
+    float start [4];
+    float end [4];
+    computeAxisEndpoints(points, 4, start, end);
+
+    int bestEndpoints [2][4] = {};
+    int bestPBits [2] = {};
+    int bestIndices [BLOCK_PIXEL_COUNT] = {};
+    float bestError = FLT_MAX;
+
+    for (int pass = 0; pass <= ENDPOINT_REFINEMENT_PASSES; ++pass)
+    {
+        for (int combination = opaque ? 3 : 0; combination < 4; ++combination)
+        {
+            int pBits [2] = { combination & 1, combination >> 1 };
+            int endpoints [2][4];
+            int palette [16][4];
+
+            for (int c = 0; c < 4; ++c)
+            {
+                endpoints[0][c] = std::min(std::max((int) std::lround((start[c] - pBits[0]) / 2.0f), 0), 127);
+                endpoints[1][c] = std::min(std::max((int) std::lround((end[c] - pBits[1]) / 2.0f), 0), 127);
+
+                int value0 = (endpoints[0][c] << 1) | pBits[0];
+                int value1 = (endpoints[1][c] << 1) | pBits[1];
+
+                for (int p = 0; p < 16; ++p)
+                {
+                    palette[p][c] = ((64 - bc7Weights4[p]) * value0 + bc7Weights4[p] * value1 + 32) >> 6;
+                }
+            }
+
+            int indices [BLOCK_PIXEL_COUNT];
+            float error = chooseBc7Indices(block, palette, 16, 0, 4, bestError, indices);
+
+            if (error < bestError)
+            {
+                bestError = error;
+                std::memcpy(bestEndpoints, endpoints, sizeof(endpoints));
+                std::memcpy(bestPBits, pBits, sizeof(pBits));
+                std::memcpy(bestIndices, indices, sizeof(indices));
+            }
+        }
+
+        float weights [BLOCK_PIXEL_COUNT];
+
+        for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+        {
+            weights[i] = bc7Weights4[bestIndices[i]] / 64.0f;
+        }
+
+        if (bestError == 0.0f || pass == ENDPOINT_REFINEMENT_PASSES || !fitEndpoints(points, weights, 4, start, end))
+        {
+            break;
+        }
+    }
+
+    // The first index is stored with its top bit implied to be zero.
+    if (bestIndices[0] & 8)
+    {
+        std::swap(bestEndpoints[0], bestEndpoints[1]);
+        std::swap(bestPBits[0], bestPBits[1]);
+
+        for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+        {
+            bestIndices[i] = 15 - bestIndices[i];
+        }
+    }
+
+    std::memset(output, 0, 16);
+    int position = 0;
+    writeBits(output, position, 1 << 6, 7);
+
+    for (int c = 0; c < 4; ++c)
+    {
+        writeBits(output, position, bestEndpoints[0][c], 7);
+        writeBits(output, position, bestEndpoints[1][c], 7);
+    }
+
+    writeBits(output, position, bestPBits[0], 1);
+    writeBits(output, position, bestPBits[1], 1);
+
+    for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+    {
+        writeBits(output, position, bestIndices[i], i == 0 ? 3 : 4);
+    }
+
+    return bestError;
+}
+
+/* Fits 2 bit indices and endpoints of the given precision to a run of channels,
+ * refining by least squares like the other encoders. */
+static float fitBc7Channels (const unsigned char* block, int firstChannel, int channelCount, int bits, int (*endpoints)[4], int* indices)
+{
+    float points [BLOCK_PIXEL_COUNT][4];
+
+    for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+    {
+        for (int c = 0; c < channelCount; ++c)
+        {
+            points[i][c] = block[i * 4 + firstChannel + c];
+        }
+    }
+
+    float start [4];
+    float end [4];
+    computeAxisEndpoints(points, channelCount, start, end);
+
+    int maximum = (1 << bits) - 1;
+    float bestError = FLT_MAX;
+
+    for (int pass = 0; pass <= ENDPOINT_REFINEMENT_PASSES; ++pass)
+    {
+        int candidate [2][4];
+        int palette [4][4];
+
+        for (int c = 0; c < channelCount; ++c)
+        {
+            candidate[0][c] = (int) std::lround(start[c] * maximum / 255.0f);
+            candidate[1][c] = (int) std::lround(end[c] * maximum / 255.0f);
+
+            // Endpoints are widened to 8 bits by repeating their top bits.
+            int value0 = (candidate[0][c] << (8 - bits)) | (candidate[0][c] >> (2 * bits - 8));
+            int value1 = (candidate[1][c] << (8 - bits)) | (candidate[1][c] >> (2 * bits - 8));
+
+            for (int p = 0; p < 4; ++p)
+            {
+                palette[p][firstChannel + c] = ((64 - bc7Weights2[p]) * value0 + bc7Weights2[p] * value1 + 32) >> 6;
+            }
+        }
+
+        int candidateIndices [BLOCK_PIXEL_COUNT];
+        float error = chooseBc7Indices(block, palette, 4, firstChannel, channelCount, bestError, candidateIndices);
+
+        if (error < bestError)
+        {
+            bestError = error;
+            std::memcpy(endpoints, candidate, sizeof(candidate));
+            std::memcpy(indices, candidateIndices, sizeof(candidateIndices));
+        }
+
+        float weights [BLOCK_PIXEL_COUNT];
+
+        for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+        {
+            weights[i] = bc7Weights2[indices[i]] / 64.0f;
+        }
+
+        if (bestError == 0.0f || pass == ENDPOINT_REFINEMENT_PASSES || !fitEndpoints(points, weights, channelCount, start, end))
+        {
+            break;
+        }
+    }
+
+    if (indices[0] & 2)
+    {
+        std::swap(endpoints[0], endpoints[1]);
+
+        for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+        {
+            indices[i] = 3 - indices[i];
+        }
+    }
+
+    return bestError;
+}
+
+/* Mode 5: 7 bit RGB and 8 bit alpha endpoints with separate 2 bit indices,
+ * for blocks whose alpha does not follow their colour. */
+static float encodeBc7Mode5 (const unsigned char* block, unsigned char* output)
+{
+    int colorEndpoints [2][4];
+    int alphaEndpoints [2][4];
+    int colorIndices [BLOCK_PIXEL_COUNT];
+    int alphaIndices [BLOCK_PIXEL_COUNT];
+
+    float error = fitBc7Channels(block, 0, 3, 7, colorEndpoints, colorIndices);
+    error += fitBc7Channels(block, 3, 1, 8, alphaEndpoints, alphaIndices);
+
+    std::memset(output, 0, 16);
+    int position = 0;
+    writeBits(output, position, 1 << 5, 6);
+    writeBits(output, position, 0, 2);
+
+    for (int c = 0; c < 3; ++c)
+    {
+        writeBits(output, position, colorEndpoints[0][c], 7);
+        writeBits(output, position, colorEndpoints[1][c], 7);
+    }
+
+    writeBits(output, position, alphaEndpoints[0][0], 8);
+    writeBits(output, position, alphaEndpoints[1][0], 8);
+
+    for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+    {
+        writeBits(output, position, colorIndices[i], i == 0 ? 1 : 2);
+    }
+
+    for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+    {
+        writeBits(output, position, alphaIndices[i], i == 0 ? 1 : 2);
+    }
+
+    return error;
+}
+
+/* BC7 using modes 5 and 6, keeping whichever reproduces the block better.
+ * Between them they cover smooth colour, correlated and independent alpha;
+ * the partitioned modes would only pay off on blocks with several distinct
+ * colours and are left out to keep the encoder small. */
+static void encodeBc7Block (const unsigned char* block, unsigned char* output)
+{
+    bool opaque = true;
+
+    for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+    {
+        opaque = opaque && block[i * 4 + 3] == 255;
+    }
+
+    unsigned char mode5 [16];
+    float mode6Error = encodeBc7Mode6(block, opaque, output);
+
+    if (mode6Error > 0.0f && encodeBc7Mode5(block, mode5) < mode6Error)
+    {
+        std::memcpy(output, mode5, sizeof(mode5));
+    }
+}
+
+/* Decodes modes 5 and 6, the only ones the encoder writes. Blocks in any other
+ * mode come out magenta so a foreign file is obvious rather than silently
+ * wrong. */
+static void decodeBc7Block (const unsigned char* input, unsigned char* block)
+{
+    int mode = 0;
+
+    while (mode < 8 && !((input[0] >> mode) & 1))
+    {
+        ++mode;
+    }
+
+    int position = mode + 1;
+
+    if (mode == 6)
+    {
+        int endpoints [2][4];
+
+        for (int c = 0; c < 4; ++c)
+        {
+            endpoints[0][c] = readBits(input, position, 7);
+            endpoints[1][c] = readBits(input, position, 7);
+        }
+
+        int pBit0 = readBits(input, position, 1);
+        int pBit1 = readBits(input, position, 1);
+
+        for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+        {
+            int weight = bc7Weights4[readBits(input, position, i == 0 ? 3 : 4)];
+
+            for (int c = 0; c < 4; ++c)
+            {
+                int value0 = (endpoints[0][c] << 1) | pBit0;
+                int value1 = (endpoints[1][c] << 1) | pBit1;
+                block[i * 4 + c] = ((64 - weight) * value0 + weight * value1 + 32) >> 6;
+            }
+        }
+    }
+    else if (mode == 5)
+    {
+        int rotation = readBits(input, position, 2);
+        int values [2][4];
+
+        for (int c = 0; c < 3; ++c)
+        {
+            for (int e = 0; e < 2; ++e)
+            {
+                int endpoint = readBits(input, position, 7);
+                values[e][c] = (endpoint << 1) | (endpoint >> 6);
+            }
+        }
+
+        values[0][3] = readBits(input, position, 8);
+        values[1][3] = readBits(input, position, 8);
+
+        for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+        {
+            int weight = bc7Weights2[readBits(input, position, i == 0 ? 1 : 2)];
+
+            for (int c = 0; c < 3; ++c)
+            {
+                block[i * 4 + c] = ((64 - weight) * values[0][c] + weight * values[1][c] + 32) >> 6;
+            }
+        }
+
+        for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+        {
+            int weight = bc7Weights2[readBits(input, position, i == 0 ? 1 : 2)];
+            block[i * 4 + 3] = ((64 - weight) * values[0][3] + weight * values[1][3] + 32) >> 6;
+
+            if (rotation > 0)
+            {
+                std::swap(block[i * 4 + 3], block[i * 4 + rotation - 1]);
+            }
+        }
+    }
+    else
+    {
+        for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+        {
+            block[i * 4 + 0] = 255;
+            block[i * 4 + 1] = 0;
+            block[i * 4 + 2] = 255;
+            block[i * 4 + 3] = 255;
+        }
+    }
+}
+
+const size_t getCompressedBlockBytes (CompressedFormat format)
+{
+    return format == COMPRESSED_FORMAT_BC1 || format == COMPRESSED_FORMAT_BC4 ? 8 : 16;
+}
+
+const size_t getCompressedSize (CompressedFormat format, int width, int height)
+{
+    if (format == COMPRESSED_FORMAT_RGBA8)
+    {
+        return (size_t) width * height * 4;
+    }
+
+    size_t blocksX = (width + COMPRESSED_BLOCK_SIZE - 1) / COMPRESSED_BLOCK_SIZE;
+    size_t blocksY = (height + COMPRESSED_BLOCK_SIZE - 1) / COMPRESSED_BLOCK_SIZE;
+    return blocksX * blocksY * getCompressedBlockBytes(format);
+}
+
+const char* getCompressedFormatName (CompressedFormat format)
+{
+    switch (format)
+    {
+        case COMPRESSED_FORMAT_BC1: return "BC1";
+        case COMPRESSED_FORMAT_BC3: return "BC3";
+        case COMPRESSED_FORMAT_BC4: return "BC4";
+        case COMPRESSED_FORMAT_BC7: return "BC7";
+        case COMPRESSED_FORMAT_RGBA8: return "RGBA8";
+        default: return "auto";
+    }
+}
+
+/* Grey opaque images only need one channel and go to BC4. Everything else is
+ * BC7 at high quality, otherwise BC1 when opaque and BC3 when it has alpha. */
+CompressedFormat chooseCompressedFormat (const unsigned char* pixels, int width, int height, bool highQuality)
+{
+    bool opaque = true;
+    bool grey = true;
+
+    for (size_t i = 0; i < (size_t) width * height && (opaque || grey); ++i)
+    {
+        const unsigned char* pixel = pixels + i * 4;
+        opaque = opaque && pixel[3] == 255;
+        grey = grey && pixel[0] == pixel[1] && pixel[1] == pixel[2];
+    }
+
+    if (opaque && grey)
+    {
+        return COMPRESSED_FORMAT_BC4;
+    }
+
+    if (highQuality)
+    {
+        return COMPRESSED_FORMAT_BC7;
+    }
+
+    return opaque ? COMPRESSED_FORMAT_BC1 : COMPRESSED_FORMAT_BC3;
+}
+
+/* Blocks are written row by row, getCompressedSize() bytes in total. BC4
+ * compresses the red channel. */
+void compressImage (CompressedFormat format, const unsigned char* pixels, int width, int height, unsigned char* blocks)
+{
+    if (format == COMPRESSED_FORMAT_RGBA8)
+    {
+        std::memcpy(blocks, pixels, getCompressedSize(format, width, height));
+        return;
+    }
+
+    int blocksX = (width + COMPRESSED_BLOCK_SIZE - 1) / COMPRESSED_BLOCK_SIZE;
+    int blocksY = (height + COMPRESSED_BLOCK_SIZE - 1) / COMPRESSED_BLOCK_SIZE;
+    size_t blockBytes = getCompressedBlockBytes(format);
+    unsigned char block [BLOCK_PIXEL_COUNT * 4];
+
+    for (int blockY = 0; blockY < blocksY; ++blockY)
+    {
+        for (int blockX = 0; blockX < blocksX; ++blockX)
+        {
+            unsigned char* output = blocks + ((size_t) blockY * blocksX + blockX) * blockBytes;
+            loadBlock(pixels, width, height, blockX, blockY, block);
+
+            switch (format)
+            {
+                case COMPRESSED_FORMAT_BC1:
+                    encodeColorBlock(block, output);
+                    break;
+                case COMPRESSED_FORMAT_BC3:
+                    encodeChannelBlock(block, 3, output);
+                    encodeColorBlock(block, output + 8);
+                    break;
+                case COMPRESSED_FORMAT_BC4:
+                    encodeChannelBlock(block, 0, output);
+                    break;
+                default:
+                    encodeBc7Block(block, output);
+                    break;
+            }
+        }
+    }
+}
+
+/* The CPU fallback for drivers without the format. BC4 comes out grey with
+ * full alpha, matching the swizzle the texture uses when it is uploaded
+ * compressed. */
+void decompressImage (CompressedFormat format, const unsigned char* blocks, int width, int height, unsigned char* pixels)
+{
+    if (format == COMPRESSED_FORMAT_RGBA8)
+    {
+        std::memcpy(pixels, blocks, getCompressedSize(format, width, height));
+        return;
+    }
+
+    int blocksX = (width + COMPRESSED_BLOCK_SIZE - 1) / COMPRESSED_BLOCK_SIZE;
+    int blocksY = (height + COMPRESSED_BLOCK_SIZE - 1) / COMPRESSED_BLOCK_SIZE;
+    size_t blockBytes = getCompressedBlockBytes(format);
+    unsigned char block [BLOCK_PIXEL_COUNT * 4];
+    unsigned char values [BLOCK_PIXEL_COUNT];
+
+    for (int blockY = 0; blockY < blocksY; ++blockY)
+    {
+        for (int blockX = 0; blockX < blocksX; ++blockX)
+        {
+            const unsigned char* input = blocks + ((size_t) blockY * blocksX + blockX) * blockBytes;
+
+            switch (format)
+            {
+                case COMPRESSED_FORMAT_BC1:
+                    decodeColorBlock(input, false, block);
+                    break;
+                case COMPRESSED_FORMAT_BC3:
+                    decodeColorBlock(input + 8, true, block);
+                    decodeChannelBlock(input, values);
+
+                    for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+                    {
+                        block[i * 4 + 3] = values[i];
+                    }
+
+                    break;
+                case COMPRESSED_FORMAT_BC4:
+                    decodeChannelBlock(input, values);
+
+                    for (int i = 0; i < BLOCK_PIXEL_COUNT; ++i)
+                    {
+                        block[i * 4 + 0] = values[i];
+                        block[i * 4 + 1] = values[i];
+                        block[i * 4 + 2] = values[i];
+                        block[i * 4 + 3] = 255;
+                    }
+
+                    break;
+                default:
+                    decodeBc7Block(input, block);
+                    break;
+            }
+
+            storeBlock(block, width, height, blockX, blockY, pixels);
+        }
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, CompressedFormat format)
+{
+    return os << getCompressedFormatName(format);
+}
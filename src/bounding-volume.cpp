@@ -0,0 +1,321 @@
+#include "bounding-volume.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* The positions are strided (interleaved with normals and uvs), so each vertex
+ * is loaded as one four lane register and the unused fourth lane is ignored.
+ * Two accumulators per bound keep the min/max dependency chains short. */
+BoundingBox computeBoundingBox (const float* positions, size_t count, size_t stride)
+{
+    if (count == 0)
+    {
+        return { glm::vec3(0.0f), glm::vec3(0.0f) };
+    }
+
+#ifdef __SSE2__
+    if (stride >= 4)
+    {
+        __m128 minimum0 = _mm_set1_ps(FLT_MAX);
+        __m128 maximum0 = _mm_set1_ps(-FLT_MAX);
+        __m128 minimum1 = minimum0;
+        __m128 maximum1 = maximum0;
+        size_t i = 0;
+
+        for (; i + 1 < count; i += 2)
+        {
+            __m128 position0 = _mm_loadu_ps(positions + i * stride);
+            __m128 position1 = _mm_loadu_ps(positions + (i + 1) * stride);
+
+            minimum0 = _mm_min_ps(minimum0, position0);
+            maximum0 = _mm_max_ps(maximum0, position0);
+            minimum1 = _mm_min_ps(minimum1, position1);
+            maximum1 = _mm_max_ps(maximum1, position1);
+        }
+
+        if (i < count)
+        {
+            __m128 position = _mm_loadu_ps(positions + i * stride);
+            minimum0 = _mm_min_ps(minimum0, position);
+            maximum0 = _mm_max_ps(maximum0, position);
+        }
+
+        float minimum [4];
+        float maximum [4];
+        _mm_storeu_ps(minimum, _mm_min_ps(minimum0, minimum1));
+        _mm_storeu_ps(maximum, _mm_max_ps(maximum0, maximum1));
+
+        return { glm::vec3(minimum[0], minimum[1], minimum[2]), glm::vec3(maximum[0], maximum[1], maximum[2]) };
+    }
+#endif
+
+    BoundingBox box { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        glm::vec3 position (positions[i * stride], positions[i * stride + 1], positions[i * stride + 2]);
+        box.min = glm::min(box.min, position);
+        box.max = glm::max(box.max, position);
+    }
+
+    return box;
+}
+
+OrientedBoundingBox makeOrientedBoundingBox (const BoundingBox& box)
+{
+    return {
+        (box.min + box.max) * 0.5f,
+        (box.max - box.min) * 0.5f,
+        { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) }
+    };
+}
+
+/* Cyclic Jacobi rotations on a symmetric 3x3 matrix. On return the columns of
+ * eigenvectors are the principal axes. */
+static void diagonalizeSymmetric (double matrix [3][3], double eigenvectors [3][3])
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            eigenvectors[i][j] = (i == j) ? 1.0 : 0.0;
+        }
+    }
+
+    for (int sweep = 0; sweep < JACOBI_MAX_SWEEPS; ++sweep)
+    {
+        double offDiagonal = std::fabs(matrix[0][1]) + std::fabs(matrix[0][2]) + std::fabs(matrix[1][2]);
+
+        if (offDiagonal < 1e-12)
+        {
+            return;
+        }
+
+        for (int p = 0; p < 2; ++p)
+        {
+            for (int q = p + 1; q < 3; ++q)
+            {
+                if (std::fabs(matrix[p][q]) < 1e-15)
+                {
+                    continue;
+                }
+
+                double theta = (matrix[q][q] - matrix[p][p]) / (2.0 * matrix[p][q]);
+                double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                double c = 1.0 / std::sqrt(t * t + 1.0);
+                double s = t * c;
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    double kp = matrix[k][p];
+                    double kq = matrix[k][q];
+                    matrix[k][p] = c * kp - s * kq;
+                    matrix[k][q] = s * kp + c * kq;
+                }
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    double pk = matrix[p][k];
+                    double qk = matrix[q][k];
+                    matrix[p][k] = c * pk - s * qk;
+                    matrix[q][k] = s * pk + c * qk;
+                }
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    double kp = eigenvectors[k][p];
+                    double kq = eigenvectors[k][q];
+                    eigenvectors[k][p] = c * kp - s * kq;
+                    eigenvectors[k][q] = s * kp + c * kq;
+                }
+            }
+        }
+    }
+}
+
+static inline float distanceSquared (const float* position, glm::vec3 center)
+{
+    float dx = position[0] - center.x;
+    float dy = position[1] - center.y;
+    float dz = position[2] - center.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+/* After the box, every further pass over the vertices does double duty to
+ * keep memory traffic down. The second pass accumulates the covariance for a
+ * principal component analysis together with the sphere radius around the box
+ * centre. The third projects every vertex onto the principal axes for the
+ * oriented extents together with the sphere radius around the centroid, and
+ * the tighter of the two spheres is kept. The axis aligned box stands in for
+ * the oriented one whenever it is the better fit. */
+BoundingVolumes computeBoundingVolumes (const float* positions, size_t count, size_t stride, bool oriented)
+{
+    BoundingVolumes volumes;
+    volumes.box = computeBoundingBox(positions, count, stride);
+    volumes.orientedBox = makeOrientedBoundingBox(volumes.box);
+
+    glm::vec3 origin = volumes.orientedBox.center;
+    float radiusSquared = 0.0f;
+
+    if (!oriented || count < 4)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            radiusSquared = std::max(radiusSquared, distanceSquared(positions + i * stride, origin));
+        }
+
+        volumes.sphere = { origin, std::sqrt(radiusSquared) };
+        return volumes;
+    }
+
+    // Centred on the box so the sums do not lose precision far from the origin.
+    double sum [3] = {};
+    double products [6] = {};
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float* position = positions + i * stride;
+        double x = position[0] - origin.x;
+        double y = position[1] - origin.y;
+        double z = position[2] - origin.z;
+
+        sum[0] += x;
+        sum[1] += y;
+        sum[2] += z;
+        products[0] += x * x;
+        products[1] += x * y;
+        products[2] += x * z;
+        products[3] += y * y;
+        products[4] += y * z;
+        products[5] += z * z;
+
+        radiusSquared = std::max(radiusSquared, (float)(x * x + y * y + z * z));
+    }
+
+    double inverseCount = 1.0 / (double) count;
+    glm::dvec3 mean = glm::dvec3(sum[0], sum[1], sum[2]) * inverseCount;
+
+    double covariance [3][3];
+    covariance[0][0] = products[0] * inverseCount - mean.x * mean.x;
+    covariance[0][1] = covariance[1][0] = products[1] * inverseCount - mean.x * mean.y;
+    covariance[0][2] = covariance[2][0] = products[2] * inverseCount - mean.x * mean.z;
+    covariance[1][1] = products[3] * inverseCount - mean.y * mean.y;
+    covariance[1][2] = covariance[2][1] = products[4] * inverseCount - mean.y * mean.z;
+    covariance[2][2] = products[5] * inverseCount - mean.z * mean.z;
+
+    double eigenvectors [3][3];
+    diagonalizeSymmetric(covariance, eigenvectors);
+
+    glm::vec3 axes [3];
+
+    for (int k = 0; k < 3; ++k)
+    {
+        axes[k] = glm::normalize(glm::vec3(eigenvectors[0][k], eigenvectors[1][k], eigenvectors[2][k]));
+    }
+
+    // Re-orthogonalise so the axes form a proper rotation despite rounding.
+    axes[1] = glm::normalize(axes[1] - axes[0] * glm::dot(axes[0], axes[1]));
+    axes[2] = glm::cross(axes[0], axes[1]);
+
+    glm::vec3 centroid = origin + glm::vec3(mean);
+    glm::vec3 minimum (FLT_MAX);
+    glm::vec3 maximum (-FLT_MAX);
+    float centroidRadiusSquared = 0.0f;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float* position = positions + i * stride;
+        glm::vec3 offset = glm::vec3(position[0], position[1], position[2]) - origin;
+        glm::vec3 projected (glm::dot(offset, axes[0]), glm::dot(offset, axes[1]), glm::dot(offset, axes[2]));
+
+        minimum = glm::min(minimum, projected);
+        maximum = glm::max(maximum, projected);
+        centroidRadiusSquared = std::max(centroidRadiusSquared, distanceSquared(position, centroid));
+    }
+
+    volumes.sphere = centroidRadiusSquared < radiusSquared
+        ? BoundingSphere { centroid, std::sqrt(centroidRadiusSquared) }
+        : BoundingSphere { origin, std::sqrt(radiusSquared) };
+
+    glm::vec3 halfExtents = (maximum - minimum) * 0.5f;
+    glm::vec3 localCenter = (maximum + minimum) * 0.5f;
+    glm::vec3 boxHalfExtents = volumes.orientedBox.halfExtents;
+
+    if (halfExtents.x * halfExtents.y * halfExtents.z < boxHalfExtents.x * boxHalfExtents.y * boxHalfExtents.z)
+    {
+        volumes.orientedBox = {
+            origin + axes[0] * localCenter.x + axes[1] * localCenter.y + axes[2] * localCenter.z,
+            halfExtents,
+            { axes[0], axes[1], axes[2] }
+        };
+    }
+
+    return volumes;
+}
+
+BoundingBox transformBoundingBox (const BoundingBox& box, glm::vec3 position, glm::vec3 scale)
+{
+    glm::vec3 a = box.min * scale + position;
+    glm::vec3 b = box.max * scale + position;
+    return { glm::min(a, b), glm::max(a, b) };
+}
+
+BoundingSphere transformBoundingSphere (const BoundingSphere& sphere, glm::vec3 position, glm::vec3 scale)
+{
+    glm::vec3 absoluteScale = glm::abs(scale);
+    return { sphere.center * scale + position, sphere.radius * std::max(absoluteScale.x, std::max(absoluteScale.y, absoluteScale.z)) };
+}
+
+/* Scaling keeps the box orthogonal when the scale is uniform or lines up with
+ * the box axes. Otherwise the result would be sheared, so the axis aligned box
+ * around the transformed corners is returned instead. */
+OrientedBoundingBox transformOrientedBoundingBox (const OrientedBoundingBox& orientedBox, glm::vec3 position, glm::vec3 scale)
+{
+    glm::vec3 axes [3];
+    float lengths [3];
+
+    for (int k = 0; k < 3; ++k)
+    {
+        axes[k] = orientedBox.axes[k] * scale;
+        lengths[k] = glm::length(axes[k]);
+    }
+
+    bool orthogonal = std::fabs(glm::dot(axes[0], axes[1])) <= 1e-4f * lengths[0] * lengths[1]
+        && std::fabs(glm::dot(axes[0], axes[2])) <= 1e-4f * lengths[0] * lengths[2]
+        && std::fabs(glm::dot(axes[1], axes[2])) <= 1e-4f * lengths[1] * lengths[2];
+
+    glm::vec3 center = orientedBox.center * scale + position;
+
+    if (orthogonal && lengths[0] > 0.0f && lengths[1] > 0.0f && lengths[2] > 0.0f)
+    {
+        return {
+            center,
+            orientedBox.halfExtents * glm::vec3(lengths[0], lengths[1], lengths[2]),
+            { axes[0] / lengths[0], axes[1] / lengths[1], axes[2] / lengths[2] }
+        };
+    }
+
+    glm::vec3 halfExtents = glm::abs(axes[0]) * orientedBox.halfExtents.x
+        + glm::abs(axes[1]) * orientedBox.halfExtents.y
+        + glm::abs(axes[2]) * orientedBox.halfExtents.z;
+
+    return makeOrientedBoundingBox({ center - halfExtents, center + halfExtents });
+}
+
+std::ostream& operator<<(std::ostream& os, const BoundingSphere& sphere)
+{
+    os << "sphere center (" << sphere.center.x << ", " << sphere.center.y << ", " << sphere.center.z << ") radius " << sphere.radius;
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, const OrientedBoundingBox& orientedBox)
+{
+    os << "oriented box center (" << orientedBox.center.x << ", " << orientedBox.center.y << ", " << orientedBox.center.z << ")";
+    os << " half extents (" << orientedBox.halfExtents.x << ", " << orientedBox.halfExtents.y << ", " << orientedBox.halfExtents.z << ")";
+    return os;
+}
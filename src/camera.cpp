@@ -35,6 +35,20 @@ glm::mat4 Camera::getLookAt ()
     return glm::lookAt(this->position, this->position + this->forward, this->up);
 }
 
+/* Approximate on-screen radius in pixels of a bounding sphere, used to pick a
+ * level of detail. A camera inside the sphere gets the full viewport height. */
+float Camera::getProjectedRadius (glm::vec3 center, float radius, float viewportHeight) const
+{
+    float distance = glm::length(center - this->position);
+
+    if (distance <= radius)
+    {
+        return viewportHeight;
+    }
+
+    return radius / (distance * tan(glm::radians(this->fov) * 0.5f)) * viewportHeight * 0.5f;
+}
+
 void Camera::processKeyInput (GLFWwindow* window, float deltaTime)
 {
     float speed = this->moveSpeed * deltaTime;
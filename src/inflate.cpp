@@ -0,0 +1,665 @@
+#include "inflate.hpp"
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#define INFLATE_MAX_CODE_LENGTH 15
+#define INFLATE_LITLEN_SYMBOLS 288
+#define INFLATE_DISTANCE_SYMBOLS 32
+#define INFLATE_PRECODE_SYMBOLS 19
+#define INFLATE_LITLEN_TABLE_BITS 11
+#define INFLATE_DISTANCE_TABLE_BITS 8
+#define INFLATE_PRECODE_TABLE_BITS 7
+
+// The longest match plus the overshoot of a word-at-a-time copy. Matches
+// further than this from the end of the output are copied byte by byte.
+#define INFLATE_FAST_COPY_MARGIN (258 + 8)
+
+/* A table entry packs how to decode one code: the bits it takes in the low
+ * nibble, then the extra bits that follow it (or the index bits of a
+ * subtable), its kind, and its value in the top half: the literal, the base
+ * of a length or distance, or where the subtable starts. */
+enum EntryKind : uint32_t
+{
+    ENTRY_LITERAL = 0,
+    ENTRY_LENGTH = 1,
+    ENTRY_DISTANCE = 2,
+    ENTRY_END = 3,
+    ENTRY_SUBTABLE = 4,
+    ENTRY_INVALID = 5
+};
+
+static inline uint32_t makeEntry (EntryKind kind, uint32_t extraBits, uint32_t value)
+{
+    return (extraBits << 4) | ((uint32_t) kind << 8) | (value << 16);
+}
+
+static inline uint32_t getEntryLength (uint32_t entry)
+{
+    return entry & 0xF;
+}
+
+static inline uint32_t getEntryExtraBits (uint32_t entry)
+{
+    return (entry >> 4) & 0xF;
+}
+
+static inline EntryKind getEntryKind (uint32_t entry)
+{
+    return (EntryKind)((entry >> 8) & 0xFF);
+}
+
+static inline uint32_t getEntryValue (uint32_t entry)
+{
+    return entry >> 16;
+}
+
+static const uint16_t lengthBases [29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t lengthExtraBits [29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t distanceBases [30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t distanceExtraBits [30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static const uint8_t precodeOrder [INFLATE_PRECODE_SYMBOLS] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+static uint32_t getLitlenTemplate (unsigned int symbol)
+{
+    if (symbol < 256)
+    {
+        return makeEntry(ENTRY_LITERAL, 0, symbol);
+    }
+
+    if (symbol == 256)
+    {
+        return makeEntry(ENTRY_END, 0, 0);
+    }
+
+    if (symbol < 286)
+    {
+        return makeEntry(ENTRY_LENGTH, lengthExtraBits[symbol - 257], lengthBases[symbol - 257]);
+    }
+
+    return makeEntry(ENTRY_INVALID, 0, 0);
+}
+
+static uint32_t getDistanceTemplate (unsigned int symbol)
+{
+    return symbol < 30 ? makeEntry(ENTRY_DISTANCE, distanceExtraBits[symbol], distanceBases[symbol]) : makeEntry(ENTRY_INVALID, 0, 0);
+}
+
+static uint32_t getPrecodeTemplate (unsigned int symbol)
+{
+    return makeEntry(ENTRY_LITERAL, 0, symbol);
+}
+
+static uint32_t reverseBits (uint32_t code, unsigned int length)
+{
+    uint32_t reversed = 0;
+
+    for (unsigned int i = 0; i < length; ++i)
+    {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+
+    return reversed;
+}
+
+/* Builds the lookup table of a canonical Huffman code from its code lengths.
+ * Codes up to tableBits long are found with one lookup of the next tableBits
+ * bits; longer ones lead to a subtable indexed by the bits after those, sized
+ * the way zlib sizes them. Deflate sends codes least significant bit first,
+ * so entries are placed at the bit-reversed code. Over-subscribed codes are
+ * rejected; incomplete ones decode their missing codes as invalid. */
+static bool buildTable (const uint8_t* lengths, unsigned int symbolCount, uint32_t (*getTemplate) (unsigned int), unsigned int tableBits, std::vector<uint32_t>& table)
+{
+    unsigned int counts [INFLATE_MAX_CODE_LENGTH + 1] = {};
+    unsigned int offsets [INFLATE_MAX_CODE_LENGTH + 2] = {};
+    uint16_t sorted [INFLATE_LITLEN_SYMBOLS];
+    unsigned int maxLength = 0;
+
+    for (unsigned int symbol = 0; symbol < symbolCount; ++symbol)
+    {
+        ++counts[lengths[symbol]];
+        maxLength = lengths[symbol] > maxLength ? lengths[symbol] : maxLength;
+    }
+
+    counts[0] = 0;
+    int left = 1;
+
+    for (unsigned int length = 1; length <= INFLATE_MAX_CODE_LENGTH; ++length)
+    {
+        left = (left << 1) - counts[length];
+
+        if (left < 0)
+        {
+            return false;
+        }
+
+        offsets[length + 1] = offsets[length] + counts[length];
+    }
+
+    for (unsigned int symbol = 0; symbol < symbolCount; ++symbol)
+    {
+        if (lengths[symbol] != 0)
+        {
+            sorted[offsets[lengths[symbol]]++] = symbol;
+        }
+    }
+
+    table.assign((size_t) 1 << tableBits, makeEntry(ENTRY_INVALID, 0, 0));
+
+    uint32_t code = 0;
+    unsigned int previousLength = 0;
+    uint32_t subtablePrefix = UINT32_MAX;
+    size_t subtableStart = 0;
+    unsigned int subtableBits = 0;
+    unsigned int sortedCount = offsets[INFLATE_MAX_CODE_LENGTH + 1];
+
+    for (unsigned int i = 0; i < sortedCount; ++i)
+    {
+        unsigned int symbol = sorted[i];
+        unsigned int length = lengths[symbol];
+
+        code <<= length - previousLength;
+        previousLength = length;
+
+        uint32_t reversed = reverseBits(code, length);
+        uint32_t entry = getTemplate(symbol);
+
+        if (length <= tableBits)
+        {
+            for (uint32_t j = reversed; j < ((uint32_t) 1 << tableBits); j += (uint32_t) 1 << length)
+            {
+                table[j] = entry | length;
+            }
+        }
+        else
+        {
+            uint32_t prefix = reversed & (((uint32_t) 1 << tableBits) - 1);
+
+            if (prefix != subtablePrefix)
+            {
+                // Large enough for every code still to come that shares the prefix.
+                subtableBits = length - tableBits;
+                int available = 1 << subtableBits;
+
+                while (subtableBits + tableBits < maxLength)
+                {
+                    available -= counts[subtableBits + tableBits];
+
+                    if (available <= 0)
+                    {
+                        break;
+                    }
+
+                    ++subtableBits;
+                    available <<= 1;
+                }
+
+                subtableStart = table.size();
+                subtablePrefix = prefix;
+                table.resize(subtableStart + ((size_t) 1 << subtableBits), makeEntry(ENTRY_INVALID, 0, 0));
+                table[prefix] = makeEntry(ENTRY_SUBTABLE, subtableBits, subtableStart) | tableBits;
+            }
+
+            for (uint32_t j = reversed >> tableBits; j < ((uint32_t) 1 << subtableBits); j += (uint32_t) 1 << (length - tableBits))
+            {
+                table[subtableStart + j] = entry | (length - tableBits);
+            }
+        }
+
+        --counts[length];
+        ++code;
+    }
+
+    return true;
+}
+
+struct FixedTables
+{
+    std::vector<uint32_t> litlen;
+    std::vector<uint32_t> distance;
+};
+
+static const FixedTables& getFixedTables ()
+{
+    static const FixedTables tables = []() {
+        FixedTables tables;
+        uint8_t lengths [INFLATE_LITLEN_SYMBOLS];
+
+        std::memset(lengths, 8, 144);
+        std::memset(lengths + 144, 9, 112);
+        std::memset(lengths + 256, 7, 24);
+        std::memset(lengths + 280, 8, 8);
+        buildTable(lengths, INFLATE_LITLEN_SYMBOLS, getLitlenTemplate, INFLATE_LITLEN_TABLE_BITS, tables.litlen);
+
+        std::memset(lengths, 5, INFLATE_DISTANCE_SYMBOLS);
+        buildTable(lengths, INFLATE_DISTANCE_SYMBOLS, getDistanceTemplate, INFLATE_DISTANCE_TABLE_BITS, tables.distance);
+
+        return tables;
+    }();
+
+    return tables;
+}
+
+/* The bits not yet consumed sit at the bottom of a 64-bit buffer. Refilling
+ * loads eight bytes at once and keeps whole bytes of them, which leaves at
+ * least 56 bits; that covers a length, its extra bits, a distance and its
+ * extra bits in one go. Past the end of the input zeros are fed in and
+ * counted, so reading into them can be caught afterwards. */
+class BitReader
+{
+    private:
+
+        const unsigned char* next;
+        const unsigned char* end;
+        uint64_t bits;
+        unsigned int bitCount;
+        size_t overrunBytes;
+
+    public:
+
+        BitReader (const unsigned char* input, size_t inputSize)
+            : next(input)
+            , end(input + inputSize)
+            , bits(0)
+            , bitCount(0)
+            , overrunBytes(0)
+        { }
+
+        inline void refill ()
+        {
+            if (this->end - this->next >= 8)
+            {
+                uint64_t word;
+                std::memcpy(&word, this->next, sizeof(word));
+
+                this->bits |= word << this->bitCount;
+                this->next += 7 - (this->bitCount >> 3);
+                this->bitCount |= 56;
+                return;
+            }
+
+            while (this->bitCount <= 56)
+            {
+                uint64_t byte = 0;
+
+                if (this->next < this->end)
+                {
+                    byte = *this->next++;
+                }
+                else
+                {
+                    ++this->overrunBytes;
+                }
+
+                this->bits |= byte << this->bitCount;
+                this->bitCount += 8;
+            }
+        }
+
+        inline uint32_t peek (unsigned int count) const
+        {
+            return (uint32_t)(this->bits & (((uint64_t) 1 << count) - 1));
+        }
+
+        inline void consume (unsigned int count)
+        {
+            this->bits >>= count;
+            this->bitCount -= count;
+        }
+
+        inline uint32_t read (unsigned int count)
+        {
+            uint32_t value = this->peek(count);
+            this->consume(count);
+            return value;
+        }
+
+        inline unsigned int getBitCount () const
+        {
+            return this->bitCount;
+        }
+
+        inline uint32_t decode (const std::vector<uint32_t>& table, unsigned int tableBits)
+        {
+            uint32_t entry = table[this->peek(tableBits)];
+
+            if (getEntryKind(entry) == ENTRY_SUBTABLE)
+            {
+                this->consume(tableBits);
+                entry = table[getEntryValue(entry) + this->peek(getEntryExtraBits(entry))];
+            }
+
+            this->consume(getEntryLength(entry));
+            return entry;
+        }
+
+        /* Drops the bits up to the next byte boundary and hands back the bytes
+         * that were buffered but not consumed, for a stored block to read. */
+        const unsigned char* alignToByte ()
+        {
+            this->consume(this->bitCount & 7);
+
+            size_t bufferedBytes = this->bitCount >> 3;
+
+            if (bufferedBytes < this->overrunBytes)
+            {
+                return nullptr;
+            }
+
+            this->next -= bufferedBytes - this->overrunBytes;
+            this->bits = 0;
+            this->bitCount = 0;
+            this->overrunBytes = 0;
+            return this->next;
+        }
+
+        void skipTo (const unsigned char* position)
+        {
+            this->next = position;
+        }
+
+        const unsigned char* getEnd () const
+        {
+            return this->end;
+        }
+
+        bool isOverrun () const
+        {
+            return this->overrunBytes * 8 > this->bitCount;
+        }
+};
+
+static bool readDynamicTables (BitReader& reader, std::vector<uint32_t>& litlenTable, std::vector<uint32_t>& distanceTable)
+{
+    uint8_t lengths [INFLATE_LITLEN_SYMBOLS + INFLATE_DISTANCE_SYMBOLS] = {};
+    uint8_t precodeLengths [INFLATE_PRECODE_SYMBOLS] = {};
+    std::vector<uint32_t> precodeTable;
+
+    reader.refill();
+
+    unsigned int litlenCount = reader.read(5) + 257;
+    unsigned int distanceCount = reader.read(5) + 1;
+    unsigned int precodeCount = reader.read(4) + 4;
+
+    for (unsigned int i = 0; i < precodeCount; ++i)
+    {
+        if (reader.getBitCount() < 3)
+        {
+            reader.refill();
+        }
+
+        precodeLengths[precodeOrder[i]] = reader.read(3);
+    }
+
+    if (litlenCount > 286 || distanceCount > 30
+        || !buildTable(precodeLengths, INFLATE_PRECODE_SYMBOLS, getPrecodeTemplate, INFLATE_PRECODE_TABLE_BITS, precodeTable))
+    {
+        return false;
+    }
+
+    unsigned int total = litlenCount + distanceCount;
+
+    for (unsigned int i = 0; i < total;)
+    {
+        if (reader.getBitCount() < 16)
+        {
+            reader.refill();
+        }
+
+        uint32_t entry = reader.decode(precodeTable, INFLATE_PRECODE_TABLE_BITS);
+
+        if (getEntryKind(entry) != ENTRY_LITERAL)
+        {
+            return false;
+        }
+
+        unsigned int symbol = getEntryValue(entry);
+        unsigned int repeat = 0;
+        uint8_t value = 0;
+
+        if (symbol < 16)
+        {
+            lengths[i++] = symbol;
+            continue;
+        }
+
+        if (symbol == 16)
+        {
+            if (i == 0)
+            {
+                return false;
+            }
+
+            value = lengths[i - 1];
+            repeat = 3 + reader.read(2);
+        }
+        else if (symbol == 17)
+        {
+            repeat = 3 + reader.read(3);
+        }
+        else
+        {
+            repeat = 11 + reader.read(7);
+        }
+
+        if (i + repeat > total)
+        {
+            return false;
+        }
+
+        std::memset(lengths + i, value, repeat);
+        i += repeat;
+    }
+
+    return lengths[256] != 0
+        && buildTable(lengths, litlenCount, getLitlenTemplate, INFLATE_LITLEN_TABLE_BITS, litlenTable)
+        && buildTable(lengths + litlenCount, distanceCount, getDistanceTemplate, INFLATE_DISTANCE_TABLE_BITS, distanceTable);
+}
+
+/* Copies a match that may overlap its own output. Far enough from the end of
+ * the output it goes a word at a time, writing up to seven bytes past the
+ * match that later output overwrites. */
+static inline unsigned char* copyMatch (unsigned char* out, const unsigned char* outputEnd, size_t distance, size_t length)
+{
+    const unsigned char* source = out - distance;
+
+    if ((size_t)(outputEnd - out) >= INFLATE_FAST_COPY_MARGIN)
+    {
+        if (distance >= 8)
+        {
+            unsigned char* target = out;
+            unsigned char* end = out + length;
+
+            do
+            {
+                std::memcpy(target, source, 8);
+                target += 8;
+                source += 8;
+            }
+            while (target < end);
+
+            return end;
+        }
+
+        if (distance == 1)
+        {
+            std::memset(out, *source, length);
+            return out + length;
+        }
+
+        // Shorter distances repeat a pattern, so once a few bytes are out
+        // words can be copied from a whole number of periods back, eight or
+        // more bytes away.
+        size_t period = (8 + distance - 1) / distance * distance;
+        size_t lead = std::min(period - distance, length);
+        unsigned char* target = out;
+        unsigned char* end = out + length;
+
+        for (size_t i = 0; i < lead; ++i)
+        {
+            target[i] = source[i];
+        }
+
+        for (target += lead; target < end; target += 8)
+        {
+            std::memcpy(target, target - period, 8);
+        }
+
+        return end;
+    }
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        out[i] = source[i];
+    }
+
+    return out + length;
+}
+
+static bool inflateBlock (BitReader& reader, const std::vector<uint32_t>& litlenTable, const std::vector<uint32_t>& distanceTable, unsigned char* output, unsigned char*& out, unsigned char* outputEnd)
+{
+    while (true)
+    {
+        if (reader.getBitCount() < 48)
+        {
+            reader.refill();
+        }
+
+        uint32_t entry = reader.decode(litlenTable, INFLATE_LITLEN_TABLE_BITS);
+
+        switch (getEntryKind(entry))
+        {
+            case ENTRY_LITERAL:
+            {
+                if (out == outputEnd)
+                {
+                    return false;
+                }
+
+                *out++ = (unsigned char) getEntryValue(entry);
+                break;
+            }
+            case ENTRY_LENGTH:
+            {
+                size_t length = getEntryValue(entry) + reader.read(getEntryExtraBits(entry));
+                uint32_t distanceEntry = reader.decode(distanceTable, INFLATE_DISTANCE_TABLE_BITS);
+
+                if (getEntryKind(distanceEntry) != ENTRY_DISTANCE)
+                {
+                    return false;
+                }
+
+                size_t distance = getEntryValue(distanceEntry) + reader.read(getEntryExtraBits(distanceEntry));
+
+                if (distance > (size_t)(out - output) || length > (size_t)(outputEnd - out))
+                {
+                    return false;
+                }
+
+                out = copyMatch(out, outputEnd, distance, length);
+                break;
+            }
+            case ENTRY_END:
+                return true;
+            default:
+                return false;
+        }
+    }
+}
+
+/* Decodes a zlib stream into exactly outputSize bytes. The preset dictionary
+ * flag is rejected and, like stb_image, the Adler-32 at the end is not
+ * checked. */
+bool inflateZlib (const unsigned char* input, size_t inputSize, unsigned char* output, size_t outputSize)
+{
+    if (inputSize < 2 || (input[0] & 0x0F) != 8 || (input[0] >> 4) > 7 || ((input[0] << 8) | input[1]) % 31 != 0 || (input[1] & 0x20))
+    {
+        return false;
+    }
+
+    BitReader reader (input + 2, inputSize - 2);
+    std::vector<uint32_t> litlenTable;
+    std::vector<uint32_t> distanceTable;
+    unsigned char* out = output;
+    unsigned char* outputEnd = output + outputSize;
+    bool lastBlock = false;
+
+    while (!lastBlock)
+    {
+        reader.refill();
+        lastBlock = reader.read(1);
+
+        switch (reader.read(2))
+        {
+            case 0:
+            {
+                const unsigned char* stored = reader.alignToByte();
+
+                if (!stored || reader.getEnd() - stored < 4)
+                {
+                    return false;
+                }
+
+                size_t length = stored[0] | (stored[1] << 8);
+                size_t inverse = stored[2] | (stored[3] << 8);
+                stored += 4;
+
+                if ((length ^ 0xFFFF) != inverse || length > (size_t)(reader.getEnd() - stored) || length > (size_t)(outputEnd - out))
+                {
+                    return false;
+                }
+
+                std::memcpy(out, stored, length);
+                out += length;
+                reader.skipTo(stored + length);
+                break;
+            }
+            case 1:
+            {
+                const FixedTables& fixed = getFixedTables();
+
+                if (!inflateBlock(reader, fixed.litlen, fixed.distance, output, out, outputEnd))
+                {
+                    return false;
+                }
+
+                break;
+            }
+            case 2:
+            {
+                if (!readDynamicTables(reader, litlenTable, distanceTable)
+                    || !inflateBlock(reader, litlenTable, distanceTable, output, out, outputEnd))
+                {
+                    return false;
+                }
+
+                break;
+            }
+            default:
+                return false;
+        }
+
+        if (reader.isOverrun())
+        {
+            return false;
+        }
+    }
+
+    return out == outputEnd;
+}
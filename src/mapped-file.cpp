@@ -0,0 +1,66 @@
+#include "mapped-file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+MappedFile::MappedFile (const char* filePath)
+    : data(nullptr)
+    , size(0)
+{
+    int fd = open(filePath, O_RDONLY);
+    struct stat fileStat;
+
+    if (fd < 0 || fstat(fd, &fileStat) != 0)
+    {
+        std::cerr << "File Read Error for '" << filePath << "': " << std::strerror(errno) << std::endl;
+        exit(-1);
+    }
+
+    this->size = fileStat.st_size;
+
+    if (this->size > 0)
+    {
+        this->data = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (this->data == MAP_FAILED)
+        {
+            std::cerr << "File Map Error for '" << filePath << "': " << std::strerror(errno) << std::endl;
+            exit(-1);
+        }
+
+        madvise(this->data, this->size, MADV_SEQUENTIAL);
+    }
+
+    close(fd);
+}
+
+MappedFile::MappedFile (MappedFile&& other)
+    : data(other.data)
+    , size(other.size)
+{
+    other.data = nullptr;
+    other.size = 0;
+}
+
+MappedFile::~MappedFile ()
+{
+    if (this->data)
+    {
+        munmap(this->data, this->size);
+    }
+}
+
+const char* MappedFile::getData () const
+{
+    return (const char*) this->data;
+}
+
+const size_t MappedFile::getSize () const
+{
+    return this->size;
+}
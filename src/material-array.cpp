@@ -0,0 +1,112 @@
+#include "material-array.hpp"
+#include "shader.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+/* Width and height are those of the images. The arrays are made at the
+ * current quality tier's size, so the levels above it take no memory. */
+MaterialArray::MaterialArray (int width, int height, unsigned int layerCapacity)
+    : firstLevel(getTextureQuality())
+    , diffuse(std::max(width >> firstLevel, 1), std::max(height >> firstLevel, 1), std::min(layerCapacity, (unsigned int) MAX_MATERIAL_ARRAY_LAYERS))
+    , specular(std::max(width >> firstLevel, 1), std::max(height >> firstLevel, 1), std::min(layerCapacity, (unsigned int) MAX_MATERIAL_ARRAY_LAYERS))
+    , emissive(std::max(width >> firstLevel, 1), std::max(height >> firstLevel, 1), std::min(layerCapacity, (unsigned int) MAX_MATERIAL_ARRAY_LAYERS))
+{ }
+
+/* Hands out the next layer straight away so materials can refer to it while
+ * their maps are still loading. */
+unsigned int MaterialArray::reserveLayer (float shine)
+{
+    if (this->shines.size() >= this->diffuse.getLayerCapacity())
+    {
+        std::cerr << "Material Array Error: all " << this->diffuse.getLayerCapacity() << " layers are taken" << std::endl;
+        exit(-1);
+    }
+
+    this->shines.push_back(shine);
+    this->readyLayers.push_back(false);
+    return this->shines.size() - 1;
+}
+
+/* The layer only becomes ready once all three maps are in; one that does not
+ * fit its array leaves it unready for good. */
+bool MaterialArray::upload (
+    unsigned int layer,
+    const std::vector<ImageLevel>& diffuseLevels,
+    const std::vector<ImageLevel>& specularLevels,
+    const std::vector<ImageLevel>& emissiveLevels,
+    TextureUploadRing* ring
+)
+{
+    if (layer >= this->readyLayers.size())
+    {
+        std::cerr << "Material Array Error: layer " << layer << " was never reserved" << std::endl;
+        return false;
+    }
+
+    this->readyLayers[layer] = this->diffuse.upload(layer, diffuseLevels, ring)
+        && this->specular.upload(layer, specularLevels, ring)
+        && this->emissive.upload(layer, emissiveLevels, ring);
+
+    return this->readyLayers[layer];
+}
+
+bool MaterialArray::isLayerReady (unsigned int layer) const
+{
+    return layer < this->readyLayers.size() && this->readyLayers[layer];
+}
+
+const unsigned int MaterialArray::getLayerCount () const
+{
+    return this->shines.size();
+}
+
+const int MaterialArray::getWidth () const
+{
+    return this->diffuse.getWidth();
+}
+
+const int MaterialArray::getHeight () const
+{
+    return this->diffuse.getHeight();
+}
+
+const unsigned int MaterialArray::getFirstLevel () const
+{
+    return this->firstLevel;
+}
+
+/* Binds the three arrays and switches the shader over to them, along with
+ * every layer's shine. The samplers need setSamplerUnits() first. */
+void MaterialArray::bind (const Shader& shader) const
+{
+    glActiveTexture(GL_TEXTURE0 + MATERIAL_ARRAY_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->diffuse.getID());
+    glActiveTexture(GL_TEXTURE0 + MATERIAL_ARRAY_TEXTURE_UNIT + 1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->specular.getID());
+    glActiveTexture(GL_TEXTURE0 + MATERIAL_ARRAY_TEXTURE_UNIT + 2);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->emissive.getID());
+
+    shader.setInt("materialArrays", 1);
+
+    for (size_t i = 0; i < this->shines.size(); ++i)
+    {
+        shader.setFloat("materialShines[" + std::to_string(i) + "]", this->shines[i]);
+    }
+}
+
+/* The array samplers default to unit 0 like the plain ones, and a draw fails
+ * when samplers of different types share a unit, so this is needed whether or
+ * not an array is bound. */
+void MaterialArray::setSamplerUnits (const Shader& shader)
+{
+    shader.setInt("diffuseArray", MATERIAL_ARRAY_TEXTURE_UNIT);
+    shader.setInt("specularArray", MATERIAL_ARRAY_TEXTURE_UNIT + 1);
+    shader.setInt("emissiveArray", MATERIAL_ARRAY_TEXTURE_UNIT + 2);
+}
+
+void MaterialArray::setLayer (const Shader& shader, unsigned int layer)
+{
+    shader.setInt("materialLayer", layer);
+}
@@ -0,0 +1,305 @@
+#include "mesh-cache.hpp"
+#include "glad/glad.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#define HASH_SEED 0x9E3779B97F4A7C15ull
+#define HASH_MULTIPLIER 0xFF51AFD7ED558CCDull
+
+bool statSourceFile (const char* sourcePath, SourceFileInfo& info)
+{
+    struct stat fileStat;
+
+    if (stat(sourcePath, &fileStat) != 0)
+    {
+        return false;
+    }
+
+    info.size = fileStat.st_size;
+    info.modifiedTime = (int64_t) fileStat.st_mtim.tv_sec * 1000000000 + fileStat.st_mtim.tv_nsec;
+    return true;
+}
+
+uint64_t hashSourceFile (const char* sourcePath)
+{
+    MappedFile source { sourcePath };
+    return hashBytes(source.getData(), source.getSize());
+}
+
+/* Named for the process and the thread writing it, so writers racing to the
+ * same path never share a temporary file. */
+std::string makeTemporaryPath (const char* path)
+{
+    size_t threadId = std::hash<std::thread::id>()(std::this_thread::get_id());
+    return std::string(path) + "." + std::to_string(getpid()) + "." + std::to_string(threadId) + ".tmp";
+}
+
+static size_t alignOffset (size_t offset)
+{
+    return (offset + MESH_CACHE_ALIGNMENT - 1) & ~(size_t)(MESH_CACHE_ALIGNMENT - 1);
+}
+
+uint64_t hashBytes (const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*) data;
+    uint64_t hash = HASH_SEED ^ size;
+    size_t i = 0;
+
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(uint64_t));
+        hash = (hash ^ word) * HASH_MULTIPLIER;
+        hash ^= hash >> 32;
+    }
+
+    for (; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * HASH_MULTIPLIER;
+    }
+
+    hash ^= hash >> 33;
+    return hash;
+}
+
+MeshCache::MeshCache (const char* cachePath)
+    : file(cachePath)
+    , header(nullptr)
+{
+    if (this->file.getSize() >= sizeof(MeshCacheHeader))
+    {
+        this->header = (const MeshCacheHeader*) this->file.getData();
+    }
+}
+
+static size_t getIndexSize (uint32_t indexType)
+{
+    return indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : indexType == GL_UNSIGNED_INT ? sizeof(uint32_t) : 0;
+}
+
+static bool isInFile (uint64_t offset, uint64_t size, size_t fileSize)
+{
+    return offset <= fileSize && size <= fileSize - offset;
+}
+
+/* Every index has to name a vertex in the cache, or drawing would read past
+ * the end of the vertex buffer. */
+static bool areIndicesInRange (const void* indexData, uint64_t indexCount, size_t indexSize, uint64_t vertexCount)
+{
+    uint32_t maxIndex = 0;
+
+    if (indexSize == sizeof(uint16_t))
+    {
+        const uint16_t* indices = (const uint16_t*) indexData;
+
+        for (uint64_t i = 0; i < indexCount; ++i)
+        {
+            maxIndex = std::max<uint32_t>(maxIndex, indices[i]);
+        }
+    }
+    else
+    {
+        const uint32_t* indices = (const uint32_t*) indexData;
+
+        for (uint64_t i = 0; i < indexCount; ++i)
+        {
+            maxIndex = std::max(maxIndex, indices[i]);
+        }
+    }
+
+    return indexCount == 0 || maxIndex < vertexCount;
+}
+
+/* A cache entry is reused when its version and processing flags match and the
+ * source file has the same size and modification time. If only the timestamp
+ * changed, the source contents are hashed so that touching a file does not
+ * force a full re-parse. Every size, range and index is checked against the
+ * file first, so a truncated or corrupt cache is rebuilt rather than drawn. */
+bool MeshCache::isValidFor (const char* sourcePath, uint32_t processingFlags) const
+{
+    if (!this->header
+        || this->header->magic != MESH_CACHE_MAGIC
+        || this->header->version != MESH_CACHE_VERSION
+        || this->header->processingFlags != processingFlags
+        || this->header->lodCount == 0
+        || this->header->lodCount > MAX_LOD_COUNT)
+    {
+        return false;
+    }
+
+    const MeshCacheHeader& header = *(this->header);
+    size_t indexSize = getIndexSize(header.indexType);
+
+    if ((header.vertexFormat != VERTEX_FORMAT_FLOAT && header.vertexFormat != VERTEX_FORMAT_COMPACT && header.vertexFormat != VERTEX_FORMAT_COMPACT_OCTAHEDRAL)
+        || header.vertexLayout.stride != makeVertexLayout((VertexFormat) header.vertexFormat).stride
+        || header.vertexLayout.attributeCount > MAX_VERTEX_ATTRIBUTES
+        || indexSize == 0)
+    {
+        return false;
+    }
+
+    if (!isInFile(header.vertexDataOffset, header.vertexDataSize, this->file.getSize())
+        || !isInFile(header.indexDataOffset, header.indexDataSize, this->file.getSize())
+        || !isInFile(header.meshletDataOffset, header.meshletDataSize, this->file.getSize())
+        || header.vertexDataOffset % MESH_CACHE_ALIGNMENT != 0
+        || header.indexDataOffset % MESH_CACHE_ALIGNMENT != 0
+        || header.meshletDataOffset % MESH_CACHE_ALIGNMENT != 0
+        || header.vertexCount > header.vertexDataSize
+        || header.vertexDataSize != header.vertexCount * header.vertexLayout.stride
+        || header.indexCount > header.indexDataSize
+        || header.indexDataSize != header.indexCount * indexSize
+        || header.meshletCount > header.meshletDataSize
+        || header.meshletDataSize != header.meshletCount * sizeof(Meshlet))
+    {
+        return false;
+    }
+
+    for (uint64_t i = 0; i < header.meshletCount; ++i)
+    {
+        const Meshlet& meshlet = this->getMeshletData()[i];
+
+        if ((uint64_t) meshlet.indexOffset + meshlet.indexCount > header.indexCount)
+        {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < header.lodCount; ++i)
+    {
+        if (header.lods[i].indexOffset > header.indexCount
+            || header.lods[i].indexCount > header.indexCount - header.lods[i].indexOffset)
+        {
+            return false;
+        }
+    }
+
+    if (!areIndicesInRange(this->getIndexData(), header.indexCount, indexSize, header.vertexCount))
+    {
+        return false;
+    }
+
+    SourceFileInfo source;
+
+    if (!statSourceFile(sourcePath, source) || source.size != this->header->sourceSize)
+    {
+        return false;
+    }
+
+    return source.modifiedTime == this->header->sourceModifiedTime
+        || hashSourceFile(sourcePath) == this->header->sourceHash;
+}
+
+const MeshCacheHeader& MeshCache::getHeader () const
+{
+    return *(this->header);
+}
+
+const void* MeshCache::getVertexData () const
+{
+    return this->file.getData() + this->header->vertexDataOffset;
+}
+
+const void* MeshCache::getIndexData () const
+{
+    return this->file.getData() + this->header->indexDataOffset;
+}
+
+const Meshlet* MeshCache::getMeshletData () const
+{
+    return (const Meshlet*)(this->file.getData() + this->header->meshletDataOffset);
+}
+
+/* Every set of processing options gets a cache of its own, so variants of one
+ * model loaded side by side never replace each other's. */
+std::string MeshCache::getCachePath (const char* sourcePath, uint32_t processingFlags)
+{
+    return std::string(sourcePath) + "." + std::to_string(processingFlags) + MESH_CACHE_EXTENSION;
+}
+
+bool MeshCache::exists (const char* cachePath)
+{
+    struct stat fileStat;
+    return stat(cachePath, &fileStat) == 0 && S_ISREG(fileStat.st_mode);
+}
+
+void MeshCache::write (const char* cachePath, const char* sourcePath, const MeshCacheContents& contents)
+{
+    SourceFileInfo source;
+
+    if (!statSourceFile(sourcePath, source))
+    {
+        return;
+    }
+
+    MeshCacheHeader header {};
+    header.magic = MESH_CACHE_MAGIC;
+    header.version = MESH_CACHE_VERSION;
+    header.processingFlags = contents.processingFlags;
+    header.indexType = contents.indexType;
+    header.vertexFormat = contents.vertexFormat;
+    header.sourceSize = source.size;
+    header.sourceModifiedTime = source.modifiedTime;
+    header.sourceHash = hashSourceFile(sourcePath);
+    header.vertexLayout = contents.vertexLayout;
+    header.vertexCount = contents.vertexCount;
+    header.sourceVertexCount = contents.sourceVertexCount;
+    header.vertexDataOffset = alignOffset(sizeof(MeshCacheHeader));
+    header.vertexDataSize = contents.vertexDataSize;
+    header.indexCount = contents.indexCount;
+    header.indexDataOffset = alignOffset(header.vertexDataOffset + header.vertexDataSize);
+    header.indexDataSize = contents.indexDataSize;
+    header.meshletCount = contents.meshletCount;
+    header.meshletDataOffset = alignOffset(header.indexDataOffset + header.indexDataSize);
+    header.meshletDataSize = contents.meshletCount * sizeof(Meshlet);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        header.boundsMin[i] = contents.boundsMin[i];
+        header.boundsMax[i] = contents.boundsMax[i];
+    }
+
+    header.boundingSphere = contents.boundingSphere;
+    header.orientedBoundingBox = contents.orientedBoundingBox;
+    header.optimizationReport = contents.optimizationReport;
+    header.quantizationReport = contents.quantizationReport;
+    header.lodCount = contents.lodCount;
+
+    for (size_t i = 0; i < contents.lodCount; ++i)
+    {
+        header.lods[i] = contents.lods[i];
+    }
+
+    // Written to a temporary file first so a partially written cache is never picked up.
+    std::string temporaryPath = makeTemporaryPath(cachePath);
+    std::ofstream file (temporaryPath, std::ios::binary | std::ios::trunc);
+
+    if (!file)
+    {
+        std::cerr << "Mesh Cache Write Error for '" << cachePath << "': could not open file" << std::endl;
+        return;
+    }
+
+    const char padding [MESH_CACHE_ALIGNMENT] = {};
+
+    file.write((const char*) &header, sizeof(header));
+    file.write(padding, header.vertexDataOffset - sizeof(header));
+    file.write((const char*) contents.vertexData, contents.vertexDataSize);
+    file.write(padding, header.indexDataOffset - (header.vertexDataOffset + header.vertexDataSize));
+    file.write((const char*) contents.indexData, contents.indexDataSize);
+    file.write(padding, header.meshletDataOffset - (header.indexDataOffset + header.indexDataSize));
+    file.write((const char*) contents.meshlets, header.meshletDataSize);
+    file.close();
+
+    if (!file || std::rename(temporaryPath.c_str(), cachePath) != 0)
+    {
+        std::cerr << "Mesh Cache Write Error for '" << cachePath << "': could not write file" << std::endl;
+        std::remove(temporaryPath.c_str());
+    }
+}
@@ -0,0 +1,376 @@
+#include "mesh-optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+
+#define CACHE_DECAY_POWER 1.5f
+#define LAST_TRIANGLE_SCORE 0.75f
+#define VALENCE_BOOST_SCALE 2.0f
+#define VALENCE_BOOST_POWER 0.5f
+#define MAX_SCORED_VALENCE 32
+
+struct TriangleCluster
+{
+    size_t firstTriangle;
+    size_t triangleCount;
+    float sortKey;
+};
+
+VertexCacheStatistics analyzeVertexCache (const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize)
+{
+    std::vector<size_t> cacheTimestamps (vertexCount, 0);
+    std::vector<bool> referenced (vertexCount, false);
+
+    size_t time = cacheSize + 1;
+    size_t misses = 0;
+    size_t referencedCount = 0;
+
+    // FIFO cache: a vertex is resident while fewer than cacheSize misses happened since it was loaded.
+    for (unsigned int index : indices)
+    {
+        if (time - cacheTimestamps[index] > cacheSize)
+        {
+            cacheTimestamps[index] = time++;
+            ++misses;
+        }
+
+        if (!referenced[index])
+        {
+            referenced[index] = true;
+            ++referencedCount;
+        }
+    }
+
+    size_t triangleCount = indices.size() / VERTICES_PER_FACE;
+
+    VertexCacheStatistics statistics;
+    statistics.acmr = triangleCount ? (float) misses / triangleCount : 0.0f;
+    statistics.atvr = referencedCount ? (float) misses / referencedCount : 0.0f;
+    return statistics;
+}
+
+/* Tom Forsyth's linear-speed vertex cache optimisation: greedily emits the
+ * triangle whose vertices score best under a simulated LRU cache, favouring
+ * recently used vertices and vertices with few remaining triangles. */
+void optimizeVertexCache (std::vector<unsigned int>& indices, size_t vertexCount)
+{
+    size_t triangleCount = indices.size() / VERTICES_PER_FACE;
+
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    float cacheScores [OPTIMIZER_CACHE_SIZE];
+    float valenceScores [MAX_SCORED_VALENCE + 1];
+
+    for (int i = 0; i < OPTIMIZER_CACHE_SIZE; ++i)
+    {
+        cacheScores[i] = i < 3
+            ? LAST_TRIANGLE_SCORE
+            : std::pow(1.0f - (float)(i - 3) / (OPTIMIZER_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+    }
+
+    valenceScores[0] = 0.0f;
+
+    for (int i = 1; i <= MAX_SCORED_VALENCE; ++i)
+    {
+        valenceScores[i] = VALENCE_BOOST_SCALE * std::pow((float) i, -VALENCE_BOOST_POWER);
+    }
+
+    auto vertexScore = [&](int cachePosition, unsigned int remainingTriangles) {
+        if (remainingTriangles == 0)
+        {
+            return -1.0f;
+        }
+
+        float score = cachePosition >= 0 ? cacheScores[cachePosition] : 0.0f;
+        return score + valenceScores[std::min<unsigned int>(remainingTriangles, MAX_SCORED_VALENCE)];
+    };
+
+    std::vector<unsigned int> remainingTriangles (vertexCount, 0);
+
+    for (unsigned int index : indices)
+    {
+        ++remainingTriangles[index];
+    }
+
+    std::vector<size_t> adjacencyOffsets (vertexCount + 1, 0);
+
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        adjacencyOffsets[i + 1] = adjacencyOffsets[i] + remainingTriangles[i];
+    }
+
+    std::vector<unsigned int> adjacency (indices.size());
+    std::vector<size_t> adjacencyFill (adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        adjacency[adjacencyFill[indices[i]]++] = i / VERTICES_PER_FACE;
+    }
+
+    std::vector<int> cachePositions (vertexCount, -1);
+    std::vector<float> vertexScores (vertexCount);
+
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        vertexScores[i] = vertexScore(-1, remainingTriangles[i]);
+    }
+
+    std::vector<float> triangleScores (triangleCount);
+    std::vector<bool> triangleEmitted (triangleCount, false);
+
+    for (size_t i = 0; i < triangleCount; ++i)
+    {
+        triangleScores[i] = vertexScores[indices[3 * i]] + vertexScores[indices[3 * i + 1]] + vertexScores[indices[3 * i + 2]];
+    }
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+
+    unsigned int cache [OPTIMIZER_CACHE_SIZE + 3];
+    unsigned int newCache [OPTIMIZER_CACHE_SIZE + 3];
+    size_t cacheCount = 0;
+    size_t deadEndCursor = 0;
+
+    long bestTriangle = std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin();
+
+    while (true)
+    {
+        if (bestTriangle < 0)
+        {
+            while (deadEndCursor < triangleCount && triangleEmitted[deadEndCursor])
+            {
+                ++deadEndCursor;
+            }
+
+            if (deadEndCursor == triangleCount)
+            {
+                break;
+            }
+
+            bestTriangle = deadEndCursor;
+        }
+
+        const unsigned int* triangle = &indices[3 * bestTriangle];
+        triangleEmitted[bestTriangle] = true;
+
+        size_t newCacheCount = 0;
+
+        for (int i = 0; i < VERTICES_PER_FACE; ++i)
+        {
+            unsigned int vertex = triangle[i];
+            output.push_back(vertex);
+            newCache[newCacheCount++] = vertex;
+
+            // Remove the emitted triangle from the vertex's live adjacency range.
+            unsigned int* begin = &adjacency[adjacencyOffsets[vertex]];
+            unsigned int* end = begin + remainingTriangles[vertex];
+            unsigned int* found = std::find(begin, end, (unsigned int) bestTriangle);
+            std::swap(*found, *(end - 1));
+            --remainingTriangles[vertex];
+        }
+
+        for (size_t i = 0; i < cacheCount; ++i)
+        {
+            unsigned int vertex = cache[i];
+
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+            {
+                newCache[newCacheCount++] = vertex;
+            }
+        }
+
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+
+        for (size_t i = 0; i < newCacheCount; ++i)
+        {
+            unsigned int vertex = newCache[i];
+            cachePositions[vertex] = i < OPTIMIZER_CACHE_SIZE ? (int) i : -1;
+
+            float score = vertexScore(cachePositions[vertex], remainingTriangles[vertex]);
+            float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+
+            for (size_t j = 0; j < remainingTriangles[vertex]; ++j)
+            {
+                unsigned int adjacentTriangle = adjacency[adjacencyOffsets[vertex] + j];
+                triangleScores[adjacentTriangle] += delta;
+
+                if (i < OPTIMIZER_CACHE_SIZE && triangleScores[adjacentTriangle] > bestScore)
+                {
+                    bestScore = triangleScores[adjacentTriangle];
+                    bestTriangle = adjacentTriangle;
+                }
+            }
+        }
+
+        cacheCount = std::min<size_t>(newCacheCount, OPTIMIZER_CACHE_SIZE);
+        std::copy(newCache, newCache + cacheCount, cache);
+    }
+
+    indices.swap(output);
+}
+
+/* Splits the cache-optimised order into clusters at points where the cache is
+ * effectively restarted, then draws clusters facing away from the mesh centre
+ * first so they occlude the rest. The reorder is dropped if it costs more than
+ * acmrThreshold in vertex cache efficiency. */
+void optimizeOverdraw (std::vector<unsigned int>& indices, const std::vector<float>& vertexData, float acmrThreshold)
+{
+    size_t triangleCount = indices.size() / VERTICES_PER_FACE;
+    size_t vertexCount = vertexData.size() / VERTEX_DATA_STRIDE;
+
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    auto position = [&](unsigned int index) {
+        const float* vertex = &vertexData[index * VERTEX_DATA_STRIDE];
+        return glm::vec3(vertex[0], vertex[1], vertex[2]);
+    };
+
+    std::vector<TriangleCluster> clusters;
+    std::vector<size_t> cacheTimestamps (vertexCount, 0);
+    size_t time = ANALYSIS_CACHE_SIZE + 1;
+
+    for (size_t i = 0; i < triangleCount; ++i)
+    {
+        int misses = 0;
+
+        for (int j = 0; j < VERTICES_PER_FACE; ++j)
+        {
+            unsigned int index = indices[3 * i + j];
+
+            if (time - cacheTimestamps[index] > ANALYSIS_CACHE_SIZE)
+            {
+                cacheTimestamps[index] = time++;
+                ++misses;
+            }
+        }
+
+        if (clusters.empty() || misses == VERTICES_PER_FACE)
+        {
+            clusters.push_back({ i, 0, 0.0f });
+        }
+
+        ++clusters.back().triangleCount;
+    }
+
+    std::vector<glm::vec3> clusterCentroids (clusters.size());
+    std::vector<glm::vec3> clusterNormals (clusters.size());
+    glm::vec3 meshCentroid (0.0f);
+    float meshArea = 0.0f;
+
+    for (size_t c = 0; c < clusters.size(); ++c)
+    {
+        const TriangleCluster& cluster = clusters[c];
+        glm::vec3 centroid (0.0f);
+        glm::vec3 normal (0.0f);
+        float area = 0.0f;
+
+        for (size_t i = cluster.firstTriangle; i < cluster.firstTriangle + cluster.triangleCount; ++i)
+        {
+            glm::vec3 a = position(indices[3 * i]);
+            glm::vec3 b = position(indices[3 * i + 1]);
+            glm::vec3 c = position(indices[3 * i + 2]);
+
+            glm::vec3 areaNormal = glm::cross(b - a, c - a);
+            float triangleArea = glm::length(areaNormal);
+
+            centroid += (a + b + c) * (triangleArea / 3.0f);
+            normal += areaNormal;
+            area += triangleArea;
+        }
+
+        meshCentroid += centroid;
+        meshArea += area;
+
+        float normalLength = glm::length(normal);
+        clusterCentroids[c] = area > 0.0f ? centroid / area : position(indices[3 * cluster.firstTriangle]);
+        clusterNormals[c] = normalLength > 0.0f ? normal / normalLength : glm::vec3(0.0f);
+    }
+
+    meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : glm::vec3(0.0f);
+
+    for (size_t c = 0; c < clusters.size(); ++c)
+    {
+        clusters[c].sortKey = glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c]);
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const TriangleCluster& a, const TriangleCluster& b) {
+        return a.sortKey > b.sortKey;
+    });
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+
+    for (const TriangleCluster& cluster : clusters)
+    {
+        output.insert(
+            output.end(),
+            indices.begin() + VERTICES_PER_FACE * cluster.firstTriangle,
+            indices.begin() + VERTICES_PER_FACE * (cluster.firstTriangle + cluster.triangleCount)
+        );
+    }
+
+    float originalAcmr = analyzeVertexCache(indices, vertexCount).acmr;
+    float reorderedAcmr = analyzeVertexCache(output, vertexCount).acmr;
+
+    if (reorderedAcmr <= originalAcmr * acmrThreshold)
+    {
+        indices.swap(output);
+    }
+}
+
+void optimizeVertexFetch (Mesh& mesh)
+{
+    size_t vertexCount = mesh.vertexData.size() / VERTEX_DATA_STRIDE;
+
+    std::vector<unsigned int> remap (vertexCount, UINT32_MAX);
+    std::vector<float> vertexData (mesh.vertexData.size());
+    unsigned int nextVertex = 0;
+
+    for (unsigned int& index : mesh.indices)
+    {
+        if (remap[index] == UINT32_MAX)
+        {
+            std::copy_n(&mesh.vertexData[index * VERTEX_DATA_STRIDE], VERTEX_DATA_STRIDE, &vertexData[nextVertex * VERTEX_DATA_STRIDE]);
+            remap[index] = nextVertex++;
+        }
+
+        index = remap[index];
+    }
+
+    // Vertices no longer referenced by any triangle are dropped.
+    vertexData.resize(nextVertex * VERTEX_DATA_STRIDE);
+    mesh.vertexData.swap(vertexData);
+}
+
+MeshOptimizationReport optimizeMesh (Mesh& mesh)
+{
+    size_t vertexCount = mesh.vertexData.size() / VERTEX_DATA_STRIDE;
+
+    MeshOptimizationReport report;
+    report.before = analyzeVertexCache(mesh.indices, vertexCount);
+
+    optimizeVertexCache(mesh.indices, vertexCount);
+    optimizeOverdraw(mesh.indices, mesh.vertexData);
+    optimizeVertexFetch(mesh);
+
+    report.after = analyzeVertexCache(mesh.indices, mesh.vertexData.size() / VERTEX_DATA_STRIDE);
+    return report;
+}
+
+std::ostream& operator<<(std::ostream& os, const MeshOptimizationReport& report)
+{
+    os << std::fixed << std::setprecision(3);
+    os << "ACMR " << report.before.acmr << " -> " << report.after.acmr << ", ";
+    os << "ATVR " << report.before.atvr << " -> " << report.after.atvr;
+    return os;
+}
@@ -0,0 +1,366 @@
+#include "mesh-simplifier.hpp"
+#include "mesh-optimizer.hpp"
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#define MIN_NORMAL_AGREEMENT 0.2f
+
+struct Quadric
+{
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+    double weight;
+};
+
+struct Collapse
+{
+    unsigned int from;
+    unsigned int to;
+    double cost;
+};
+
+static inline glm::vec3 getPosition (const Mesh& mesh, unsigned int index)
+{
+    const float* vertex = &mesh.vertexData[(size_t) index * VERTEX_DATA_STRIDE];
+    return glm::vec3(vertex[0], vertex[1], vertex[2]);
+}
+
+static inline void addQuadric (Quadric& q, const Quadric& other)
+{
+    q.a00 += other.a00; q.a01 += other.a01; q.a02 += other.a02;
+    q.a11 += other.a11; q.a12 += other.a12; q.a22 += other.a22;
+    q.b0 += other.b0; q.b1 += other.b1; q.b2 += other.b2;
+    q.c += other.c;
+    q.weight += other.weight;
+}
+
+static inline Quadric makePlaneQuadric (glm::vec3 normal, float distance, float weight)
+{
+    double x = normal.x, y = normal.y, z = normal.z, d = distance;
+    return {
+        weight * x * x, weight * x * y, weight * x * z,
+        weight * y * y, weight * y * z, weight * z * z,
+        weight * x * d, weight * y * d, weight * z * d,
+        weight * d * d,
+        weight
+    };
+}
+
+static inline double evaluateQuadric (const Quadric& q, glm::vec3 p)
+{
+    double x = p.x, y = p.y, z = p.z;
+    double result = q.a00 * x * x + 2.0 * q.a01 * x * y + 2.0 * q.a02 * x * z
+        + q.a11 * y * y + 2.0 * q.a12 * y * z + q.a22 * z * z
+        + 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+    // Normalised by the accumulated area so the cost is a squared distance.
+    return result > 0.0 && q.weight > 0.0 ? result / q.weight : 0.0;
+}
+
+/* Vertices that share a position with another vertex sit on an attribute seam,
+ * and vertices on an open edge sit on a border; both are locked so collapses
+ * never tear the surface or stretch uv islands. */
+static std::vector<bool> findLockedVertices (const Mesh& mesh, const std::vector<unsigned int>& indices, size_t vertexCount)
+{
+    std::vector<bool> locked (vertexCount, false);
+    std::unordered_map<uint64_t, unsigned int> firstVertexAtPosition;
+    firstVertexAtPosition.reserve(vertexCount);
+
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        glm::vec3 position = getPosition(mesh, i);
+        uint32_t bits [3];
+        std::memcpy(bits, &position, sizeof(bits));
+
+        uint64_t key = ((uint64_t) bits[0] * 0x9E3779B97F4A7C15ull) ^ ((uint64_t) bits[1] << 21) ^ ((uint64_t) bits[2] * 0xC2B2AE3D27D4EB4Full);
+        auto inserted = firstVertexAtPosition.emplace(key, (unsigned int) i);
+
+        if (!inserted.second && getPosition(mesh, inserted.first->second) == position)
+        {
+            locked[i] = true;
+            locked[inserted.first->second] = true;
+        }
+    }
+
+    std::unordered_map<uint64_t, int> edgeUses;
+    edgeUses.reserve(indices.size());
+
+    for (size_t i = 0; i < indices.size(); i += VERTICES_PER_FACE)
+    {
+        for (int j = 0; j < VERTICES_PER_FACE; ++j)
+        {
+            unsigned int a = indices[i + j];
+            unsigned int b = indices[i + (j + 1) % VERTICES_PER_FACE];
+            ++edgeUses[((uint64_t) std::min(a, b) << 32) | std::max(a, b)];
+        }
+    }
+
+    for (const auto& edge : edgeUses)
+    {
+        if (edge.second == 1)
+        {
+            locked[edge.first >> 32] = true;
+            locked[edge.first & 0xFFFFFFFFu] = true;
+        }
+    }
+
+    return locked;
+}
+
+static bool collapseFlipsTriangles (const Mesh& mesh, const std::vector<unsigned int>& indices, const std::vector<size_t>& adjacencyOffsets, const std::vector<unsigned int>& adjacency, unsigned int from, unsigned int to)
+{
+    glm::vec3 target = getPosition(mesh, to);
+
+    for (size_t i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; ++i)
+    {
+        const unsigned int* triangle = &indices[(size_t) adjacency[i] * VERTICES_PER_FACE];
+
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+        {
+            continue;
+        }
+
+        glm::vec3 corners [VERTICES_PER_FACE];
+
+        for (int j = 0; j < VERTICES_PER_FACE; ++j)
+        {
+            corners[j] = getPosition(mesh, triangle[j]);
+        }
+
+        glm::vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+
+        for (int j = 0; j < VERTICES_PER_FACE; ++j)
+        {
+            if (triangle[j] == from)
+            {
+                corners[j] = target;
+            }
+        }
+
+        glm::vec3 after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+        float lengths = glm::length(before) * glm::length(after);
+
+        if (lengths == 0.0f || glm::dot(before, after) < MIN_NORMAL_AGREEMENT * lengths)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Greedy quadric error metric simplification. Each pass ranks every edge by the
+ * cost of collapsing one endpoint onto the other and applies the cheapest
+ * collapses whose one-rings do not overlap, until the target is reached or no
+ * valid collapse remains. Vertices are only ever merged onto existing vertices,
+ * so the result indexes the original vertex buffer. */
+std::vector<unsigned int> simplifyMesh (const Mesh& mesh, const std::vector<unsigned int>& indices, size_t targetIndexCount, float& error)
+{
+    size_t vertexCount = mesh.vertexData.size() / VERTEX_DATA_STRIDE;
+    std::vector<unsigned int> result (indices);
+    std::vector<bool> locked = findLockedVertices(mesh, indices, vertexCount);
+    std::vector<Quadric> quadrics (vertexCount, Quadric {});
+
+    glm::vec3 extent = mesh.boundsMax - mesh.boundsMin;
+    float radius = glm::length(extent) * 0.5f;
+
+    for (size_t i = 0; i < result.size(); i += VERTICES_PER_FACE)
+    {
+        glm::vec3 a = getPosition(mesh, result[i]);
+        glm::vec3 b = getPosition(mesh, result[i + 1]);
+        glm::vec3 c = getPosition(mesh, result[i + 2]);
+
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float area = glm::length(normal);
+
+        if (area == 0.0f)
+        {
+            continue;
+        }
+
+        normal /= area;
+        Quadric quadric = makePlaneQuadric(normal, -glm::dot(normal, a), area);
+
+        for (int j = 0; j < VERTICES_PER_FACE; ++j)
+        {
+            addQuadric(quadrics[result[i + j]], quadric);
+        }
+    }
+
+    double maxCost = 0.0;
+    std::vector<unsigned int> remap (vertexCount);
+    std::vector<bool> touched (vertexCount);
+    std::vector<size_t> adjacencyOffsets (vertexCount + 1);
+    std::vector<unsigned int> adjacency;
+    std::vector<Collapse> collapses;
+
+    while (result.size() > targetIndexCount)
+    {
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+
+        for (unsigned int index : result)
+        {
+            ++adjacencyOffsets[index + 1];
+        }
+
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+        }
+
+        adjacency.resize(result.size());
+        std::vector<size_t> adjacencyFill (adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+        for (size_t i = 0; i < result.size(); ++i)
+        {
+            adjacency[adjacencyFill[result[i]]++] = i / VERTICES_PER_FACE;
+        }
+
+        collapses.clear();
+
+        for (size_t i = 0; i < result.size(); i += VERTICES_PER_FACE)
+        {
+            for (int j = 0; j < VERTICES_PER_FACE; ++j)
+            {
+                unsigned int a = result[i + j];
+                unsigned int b = result[i + (j + 1) % VERTICES_PER_FACE];
+
+                if (a > b)
+                {
+                    continue;
+                }
+
+                Quadric combined = quadrics[a];
+                addQuadric(combined, quadrics[b]);
+
+                double costToB = locked[a] ? INFINITY : evaluateQuadric(combined, getPosition(mesh, b));
+                double costToA = locked[b] ? INFINITY : evaluateQuadric(combined, getPosition(mesh, a));
+
+                if (costToB <= costToA && costToB != INFINITY)
+                {
+                    collapses.push_back({ a, b, costToB });
+                }
+                else if (costToA != INFINITY)
+                {
+                    collapses.push_back({ b, a, costToA });
+                }
+            }
+        }
+
+        if (collapses.empty())
+        {
+            break;
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) {
+            return x.cost < y.cost;
+        });
+
+        // Each collapse removes about two triangles.
+        size_t collapseBudget = (result.size() - targetIndexCount) / (2 * VERTICES_PER_FACE) + 1;
+        size_t collapseCount = 0;
+
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            remap[i] = i;
+        }
+
+        std::fill(touched.begin(), touched.end(), false);
+
+        for (const Collapse& collapse : collapses)
+        {
+            if (collapseCount >= collapseBudget)
+            {
+                break;
+            }
+
+            if (touched[collapse.from] || touched[collapse.to])
+            {
+                continue;
+            }
+
+            if (collapseFlipsTriangles(mesh, result, adjacencyOffsets, adjacency, collapse.from, collapse.to))
+            {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+            maxCost = std::max(maxCost, collapse.cost);
+            ++collapseCount;
+
+            // Freeze the whole one-ring so later collapses in this pass see unchanged neighbours.
+            for (size_t j = adjacencyOffsets[collapse.from]; j < adjacencyOffsets[collapse.from + 1]; ++j)
+            {
+                const unsigned int* triangle = &result[(size_t) adjacency[j] * VERTICES_PER_FACE];
+                touched[triangle[0]] = true;
+                touched[triangle[1]] = true;
+                touched[triangle[2]] = true;
+            }
+        }
+
+        if (collapseCount == 0)
+        {
+            break;
+        }
+
+        size_t write = 0;
+
+        for (size_t i = 0; i < result.size(); i += VERTICES_PER_FACE)
+        {
+            unsigned int a = remap[result[i]];
+            unsigned int b = remap[result[i + 1]];
+            unsigned int c = remap[result[i + 2]];
+
+            if (a != b && b != c && a != c)
+            {
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+        }
+
+        result.resize(write);
+    }
+
+    error = radius > 0.0f ? (float)(std::sqrt(maxCost) / radius) : 0.0f;
+    return result;
+}
+
+/* Appends up to lodCount - 1 coarser index lists after the full-detail one,
+ * each simplified from the previous level. Generation stops early once a level
+ * no longer shrinks meaningfully. */
+void generateLods (Mesh& mesh, unsigned int lodCount, float reduction, bool optimize)
+{
+    size_t vertexCount = mesh.vertexData.size() / VERTEX_DATA_STRIDE;
+
+    mesh.lods.clear();
+    mesh.lods.push_back({ 0, mesh.indices.size(), 0.0f, 0.0f });
+
+    std::vector<unsigned int> previous (mesh.indices);
+
+    for (unsigned int lod = 1; lod < std::min(lodCount, (unsigned int) MAX_LOD_COUNT); ++lod)
+    {
+        size_t targetIndexCount = (size_t)(previous.size() / VERTICES_PER_FACE * reduction) * VERTICES_PER_FACE;
+        float error = 0.0f;
+        std::vector<unsigned int> simplified = simplifyMesh(mesh, previous, targetIndexCount, error);
+
+        if (simplified.empty() || simplified.size() > previous.size() * MIN_LOD_REDUCTION_GAIN)
+        {
+            break;
+        }
+
+        if (optimize)
+        {
+            optimizeVertexCache(simplified, vertexCount);
+        }
+
+        mesh.lods.push_back({ mesh.indices.size(), simplified.size(), std::max(error, mesh.lods.back().error), 0.0f });
+        mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.end());
+        previous.swap(simplified);
+    }
+}
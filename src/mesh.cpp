@@ -0,0 +1,20 @@
+#include "mesh.hpp"
+#include "bounding-volume.hpp"
+
+const VertexLayout makeFloatVertexLayout ()
+{
+    VertexLayout layout {};
+    layout.stride = VERTEX_DATA_STRIDE * sizeof(float);
+    layout.attributeCount = 3;
+    layout.attributes[0] = { 0, 3, GL_FLOAT, GL_FALSE, 0 };
+    layout.attributes[1] = { 1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float) };
+    layout.attributes[2] = { 2, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float) };
+    return layout;
+}
+
+void computeMeshBounds (Mesh& mesh)
+{
+    BoundingBox box = computeBoundingBox(mesh.vertexData.data(), mesh.vertexData.size() / VERTEX_DATA_STRIDE, VERTEX_DATA_STRIDE);
+    mesh.boundsMin = box.min;
+    mesh.boundsMax = box.max;
+}
@@ -0,0 +1,202 @@
+#include "meshlet.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#define NO_MESHLET UINT32_MAX
+
+static inline glm::vec3 getPosition (const Mesh& mesh, unsigned int index)
+{
+    const float* vertex = &mesh.vertexData[(size_t) index * VERTEX_DATA_STRIDE];
+    return glm::vec3(vertex[0], vertex[1], vertex[2]);
+}
+
+/* Fills in the bounding sphere and normal cone of the triangles in a meshlet.
+ * The cone cutoff is the sine of its half angle, or 1 when the normals spread
+ * over a hemisphere or more and the meshlet can never be back-face culled. */
+static void computeMeshletBounds (const Mesh& mesh, const std::vector<unsigned int>& vertices, Meshlet& meshlet)
+{
+    glm::vec3 minimum (FLT_MAX);
+    glm::vec3 maximum (-FLT_MAX);
+
+    for (unsigned int vertex : vertices)
+    {
+        minimum = glm::min(minimum, getPosition(mesh, vertex));
+        maximum = glm::max(maximum, getPosition(mesh, vertex));
+    }
+
+    meshlet.center = (minimum + maximum) * 0.5f;
+    meshlet.radius = 0.0f;
+
+    for (unsigned int vertex : vertices)
+    {
+        meshlet.radius = std::max(meshlet.radius, glm::length(getPosition(mesh, vertex) - meshlet.center));
+    }
+
+    const unsigned int* indices = &mesh.indices[meshlet.indexOffset];
+    std::vector<glm::vec3> normals;
+    glm::vec3 normalSum (0.0f);
+
+    for (uint32_t i = 0; i < meshlet.indexCount; i += VERTICES_PER_FACE)
+    {
+        glm::vec3 a = getPosition(mesh, indices[i]);
+        glm::vec3 normal = glm::cross(getPosition(mesh, indices[i + 1]) - a, getPosition(mesh, indices[i + 2]) - a);
+        float length = glm::length(normal);
+
+        if (length > 0.0f)
+        {
+            normals.push_back(normal / length);
+            normalSum += normal / length;
+        }
+    }
+
+    float sumLength = glm::length(normalSum);
+    meshlet.coneAxis = sumLength > 0.0f ? normalSum / sumLength : glm::vec3(0.0f, 0.0f, 1.0f);
+    meshlet.coneCutoff = 1.0f;
+
+    if (normals.empty() || sumLength == 0.0f)
+    {
+        return;
+    }
+
+    float minimumDot = 1.0f;
+
+    for (const glm::vec3& normal : normals)
+    {
+        minimumDot = std::min(minimumDot, glm::dot(normal, meshlet.coneAxis));
+    }
+
+    if (minimumDot > 0.0f)
+    {
+        meshlet.coneCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+    }
+}
+
+/* Splits an index range into consecutive meshlets. The triangles are taken in
+ * their existing order, which is already vertex cache optimised and therefore
+ * spatially coherent, so every meshlet stays a contiguous index range that can
+ * be drawn straight from the model's index buffer. */
+std::vector<Meshlet> buildMeshlets (const Mesh& mesh, size_t indexOffset, size_t indexCount)
+{
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> vertexMeshlet (mesh.vertexData.size() / VERTEX_DATA_STRIDE, NO_MESHLET);
+    std::vector<unsigned int> vertices;
+
+    Meshlet meshlet {};
+    meshlet.indexOffset = indexOffset;
+
+    for (size_t i = indexOffset; i < indexOffset + indexCount; i += VERTICES_PER_FACE)
+    {
+        uint32_t meshletIndex = meshlets.size();
+        int newVertexCount = 0;
+
+        for (int j = 0; j < VERTICES_PER_FACE; ++j)
+        {
+            newVertexCount += vertexMeshlet[mesh.indices[i + j]] != meshletIndex;
+        }
+
+        if (vertices.size() + newVertexCount > MAX_MESHLET_VERTICES || meshlet.indexCount / VERTICES_PER_FACE >= MAX_MESHLET_TRIANGLES)
+        {
+            computeMeshletBounds(mesh, vertices, meshlet);
+            meshlets.push_back(meshlet);
+
+            meshlet = {};
+            meshlet.indexOffset = i;
+            vertices.clear();
+            meshletIndex = meshlets.size();
+        }
+
+        for (int j = 0; j < VERTICES_PER_FACE; ++j)
+        {
+            unsigned int vertex = mesh.indices[i + j];
+
+            if (vertexMeshlet[vertex] != meshletIndex)
+            {
+                vertexMeshlet[vertex] = meshletIndex;
+                vertices.push_back(vertex);
+            }
+        }
+
+        meshlet.indexCount += VERTICES_PER_FACE;
+    }
+
+    if (meshlet.indexCount > 0)
+    {
+        computeMeshletBounds(mesh, vertices, meshlet);
+        meshlets.push_back(meshlet);
+    }
+
+    return meshlets;
+}
+
+/* Works in model space: the frustum planes come straight out of the combined
+ * model-view-projection matrix and the camera position is expected in model
+ * space too, so nothing per meshlet has to be transformed. Visible meshlets
+ * that are adjacent in the index buffer are merged into a single range. */
+void cullMeshlets (const std::vector<Meshlet>& meshlets, const glm::mat4& modelViewProjection, glm::vec3 cameraPosition, std::vector<MeshletRange>& visibleRanges, MeshletCullingStatistics& statistics)
+{
+    glm::vec4 planes [FRUSTUM_PLANE_COUNT];
+    glm::vec4 rows [4];
+
+    for (int i = 0; i < 4; ++i)
+    {
+        rows[i] = glm::vec4(modelViewProjection[0][i], modelViewProjection[1][i], modelViewProjection[2][i], modelViewProjection[3][i]);
+    }
+
+    for (int i = 0; i < 3; ++i)
+    {
+        planes[i * 2] = rows[3] + rows[i];
+        planes[i * 2 + 1] = rows[3] - rows[i];
+    }
+
+    for (glm::vec4& plane : planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    visibleRanges.clear();
+    statistics = { meshlets.size(), 0, 0, 0 };
+
+    for (const Meshlet& meshlet : meshlets)
+    {
+        bool outside = false;
+
+        for (const glm::vec4& plane : planes)
+        {
+            outside |= glm::dot(glm::vec3(plane), meshlet.center) + plane.w < -meshlet.radius;
+        }
+
+        if (outside)
+        {
+            ++statistics.frustumCulledCount;
+            continue;
+        }
+
+        glm::vec3 view = meshlet.center - cameraPosition;
+
+        if (glm::dot(view, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(view) + meshlet.radius)
+        {
+            ++statistics.backfaceCulledCount;
+            continue;
+        }
+
+        if (!visibleRanges.empty() && visibleRanges.back().indexOffset + visibleRanges.back().indexCount == meshlet.indexOffset)
+        {
+            visibleRanges.back().indexCount += meshlet.indexCount;
+        }
+        else
+        {
+            visibleRanges.push_back({ meshlet.indexOffset, meshlet.indexCount });
+        }
+    }
+
+    statistics.rangeCount = visibleRanges.size();
+}
+
+std::ostream& operator<<(std::ostream& os, const MeshletCullingStatistics& statistics)
+{
+    os << statistics.meshletCount << " meshlets, " << statistics.frustumCulledCount << " outside the frustum, ";
+    os << statistics.backfaceCulledCount << " back-facing, " << statistics.rangeCount << " draw ranges";
+    return os;
+}
@@ -0,0 +1,380 @@
+#include "model-data.hpp"
+#include "obj-parser.hpp"
+#include "glm/glm.hpp"
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+
+uint32_t getModelProcessingFlags (const ModelOptions& options)
+{
+    uint32_t flags = (uint32_t) options.vertexFormat << MESH_PROCESSING_VERTEX_FORMAT_SHIFT;
+    flags |= options.computeOrientedBounds ? MESH_PROCESSING_ORIENTED_BOUNDS : 0;
+    flags |= options.buildMeshlets ? MESH_PROCESSING_MESHLETS : 0;
+    flags |= (uint32_t) std::min(options.lodCount, (unsigned int) MAX_LOD_COUNT) << MESH_PROCESSING_LOD_COUNT_SHIFT;
+    flags |= (uint32_t)(std::min(std::max(options.lodReduction, 0.0f), 1.0f) * 255.0f) << MESH_PROCESSING_LOD_REDUCTION_SHIFT;
+    return options.optimizeMesh ? flags | MESH_PROCESSING_OPTIMIZED : flags;
+}
+
+bool ModelData::constructFromObj (const char* filePath, const ModelOptions& options)
+{
+    if (!parseObjFile(filePath, this->mesh, options.parseThreadCount))
+    {
+        return false;
+    }
+
+    if (options.optimizeMesh)
+    {
+        this->optimizationReport = optimizeMesh(this->mesh);
+    }
+    else
+    {
+        VertexCacheStatistics statistics = analyzeVertexCache(this->mesh.indices, this->mesh.vertexData.size() / VERTEX_DATA_STRIDE);
+        this->optimizationReport = { statistics, statistics };
+    }
+
+    BoundingVolumes volumes = computeBoundingVolumes(this->mesh.vertexData.data(), this->mesh.vertexData.size() / VERTEX_DATA_STRIDE, VERTEX_DATA_STRIDE, options.computeOrientedBounds);
+    this->mesh.boundsMin = volumes.box.min;
+    this->mesh.boundsMax = volumes.box.max;
+    this->boundingSphere = volumes.sphere;
+    this->orientedBoundingBox = volumes.orientedBox;
+
+    generateLods(this->mesh, options.lodCount, options.lodReduction, options.optimizeMesh);
+    this->lods = this->mesh.lods;
+
+    if (options.buildMeshlets)
+    {
+        this->meshlets = buildMeshlets(this->mesh, this->lods[0].indexOffset, this->lods[0].indexCount);
+    }
+
+    this->vertexFormat = options.vertexFormat;
+    this->vertexLayout = makeVertexLayout(this->vertexFormat);
+    this->vertexDataCount = this->mesh.vertexData.size() / VERTEX_DATA_STRIDE;
+
+    if (this->vertexFormat == VERTEX_FORMAT_FLOAT)
+    {
+        this->vertexData = this->mesh.vertexData.data();
+        this->vertexDataSize = this->mesh.vertexData.size() * sizeof(float);
+        this->quantizationReport = { this->vertexLayout.stride, 0.0f, 0.0f, 0.0f, 0.0f };
+    }
+    else
+    {
+        quantizeVertices(this->mesh, this->vertexFormat, this->packedVertices, this->quantizationReport);
+        this->vertexData = this->packedVertices.data();
+        this->vertexDataSize = this->packedVertices.size();
+    }
+
+    this->indexCount = this->mesh.indices.size();
+
+    if (this->vertexDataCount <= UINT16_MAX + 1)
+    {
+        this->shortIndices.assign(this->mesh.indices.begin(), this->mesh.indices.end());
+        this->indexData = this->shortIndices.data();
+        this->indexDataSize = this->shortIndices.size() * sizeof(uint16_t);
+        this->indexType = GL_UNSIGNED_SHORT;
+    }
+    else
+    {
+        this->indexData = this->mesh.indices.data();
+        this->indexDataSize = this->mesh.indices.size() * sizeof(unsigned int);
+        this->indexType = GL_UNSIGNED_INT;
+    }
+
+    this->sourceVertexCount = this->mesh.sourceVertexCount;
+    this->boundsMin = this->mesh.boundsMin;
+    this->boundsMax = this->mesh.boundsMax;
+    this->positionDequantization = makePositionDequantization(this->vertexFormat, this->boundsMin, this->boundsMax);
+    return true;
+}
+
+bool ModelData::constructFromCache (const char* filePath, const ModelOptions& options)
+{
+    std::string cachePath = MeshCache::getCachePath(filePath, getModelProcessingFlags(options));
+
+    if (!MeshCache::exists(cachePath.c_str()))
+    {
+        return false;
+    }
+
+    std::unique_ptr<MeshCache> cache (new MeshCache(cachePath.c_str()));
+
+    if (!cache->isValidFor(filePath, getModelProcessingFlags(options)))
+    {
+        return false;
+    }
+
+    const MeshCacheHeader& header = cache->getHeader();
+
+    this->vertexFormat = (VertexFormat) header.vertexFormat;
+    this->vertexLayout = header.vertexLayout;
+    this->vertexData = cache->getVertexData();
+    this->vertexDataCount = header.vertexCount;
+    this->vertexDataSize = header.vertexDataSize;
+
+    this->indexData = cache->getIndexData();
+    this->indexDataSize = header.indexDataSize;
+    this->indexCount = header.indexCount;
+    this->indexType = header.indexType;
+    this->lods.assign(header.lods, header.lods + header.lodCount);
+    this->meshlets.assign(cache->getMeshletData(), cache->getMeshletData() + header.meshletCount);
+
+    this->sourceVertexCount = header.sourceVertexCount;
+    this->boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    this->boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+    this->boundingSphere = header.boundingSphere;
+    this->orientedBoundingBox = header.orientedBoundingBox;
+    this->optimizationReport = header.optimizationReport;
+    this->quantizationReport = header.quantizationReport;
+    this->positionDequantization = makePositionDequantization(this->vertexFormat, this->boundsMin, this->boundsMax);
+
+    this->meshCache = std::move(cache);
+    return true;
+}
+
+void ModelData::writeCache (const char* filePath, const ModelOptions& options) const
+{
+    MeshCacheContents contents;
+    contents.processingFlags = getModelProcessingFlags(options);
+    contents.vertexFormat = this->vertexFormat;
+    contents.vertexLayout = this->vertexLayout;
+    contents.vertexData = this->vertexData;
+    contents.vertexDataSize = this->vertexDataSize;
+    contents.vertexCount = this->vertexDataCount;
+    contents.sourceVertexCount = this->sourceVertexCount;
+    contents.indexData = this->indexData;
+    contents.indexDataSize = this->indexDataSize;
+    contents.indexCount = this->indexCount;
+    contents.indexType = this->indexType;
+    contents.meshlets = this->meshlets.data();
+    contents.meshletCount = this->meshlets.size();
+    contents.boundsMin = this->boundsMin;
+    contents.boundsMax = this->boundsMax;
+    contents.boundingSphere = this->boundingSphere;
+    contents.orientedBoundingBox = this->orientedBoundingBox;
+    contents.optimizationReport = this->optimizationReport;
+    contents.quantizationReport = this->quantizationReport;
+    contents.lods = this->lods.data();
+    contents.lodCount = this->lods.size();
+
+    MeshCache::write(MeshCache::getCachePath(filePath, contents.processingFlags).c_str(), filePath, contents);
+}
+
+ModelData::ModelData ()
+    : vertexFormat(VERTEX_FORMAT_FLOAT)
+    , vertexData(nullptr)
+    , vertexDataSize(0)
+    , vertexDataCount(0)
+    , indexData(nullptr)
+    , indexDataSize(0)
+    , indexCount(0)
+    , indexType(GL_UNSIGNED_INT)
+    , sourceVertexCount(0)
+    , boundsMin(0.0f)
+    , boundsMax(0.0f)
+    , boundingSphere { glm::vec3(0.0f), 0.0f }
+    , orientedBoundingBox(makeOrientedBoundingBox({ glm::vec3(0.0f), glm::vec3(0.0f) }))
+{ }
+
+ModelData::ModelData (const char* objFilePath, const ModelOptions& options)
+    : ModelData()
+{
+    if (!this->load(objFilePath, options))
+    {
+        exit(-1);
+    }
+}
+
+/* Streaming needs the GL thread and is not used here, so streamMemoryLimit is
+ * ignored. Returns false, with the error reported, if the OBJ is malformed. */
+bool ModelData::load (const char* objFilePath, const ModelOptions& options)
+{
+    if (!options.useMeshCache || !this->constructFromCache(objFilePath, options))
+    {
+        if (!this->constructFromObj(objFilePath, options))
+        {
+            return false;
+        }
+
+        if (options.useMeshCache)
+        {
+            this->writeCache(objFilePath, options);
+        }
+    }
+
+    return true;
+}
+
+const size_t ModelData::getVertexDataSize () const
+{
+    return this->vertexDataSize;
+}
+
+const void* const ModelData::getVertexData () const
+{
+    return this->vertexData;
+}
+
+void ModelData::getVertex (unsigned int index, float* vertex) const
+{
+    const unsigned char* packedVertex = (const unsigned char*) this->vertexData + (size_t) index * this->vertexLayout.stride;
+    decodeVertex(packedVertex, this->vertexFormat, this->positionDequantization, vertex);
+}
+
+const VertexFormat ModelData::getVertexFormat () const
+{
+    return this->vertexFormat;
+}
+
+const PositionDequantization& ModelData::getPositionDequantization () const
+{
+    return this->positionDequantization;
+}
+
+const unsigned int ModelData::getVertexDataCount () const
+{
+    return this->vertexDataCount;
+}
+
+const VertexLayout& ModelData::getVertexLayout () const
+{
+    return this->vertexLayout;
+}
+
+const void* const ModelData::getIndexData () const
+{
+    return this->indexData;
+}
+
+const size_t ModelData::getIndexDataSize () const
+{
+    return this->indexDataSize;
+}
+
+const unsigned int ModelData::getIndexCount () const
+{
+    return this->indexCount;
+}
+
+const GLenum ModelData::getIndexType () const
+{
+    return this->indexType;
+}
+
+const unsigned int ModelData::getLodCount () const
+{
+    return this->lods.size();
+}
+
+const MeshLod& ModelData::getLod (unsigned int lod) const
+{
+    return this->lods[std::min(lod, (unsigned int) this->lods.size() - 1)];
+}
+
+/* Picks the coarsest level whose simplification error, which is stored relative
+ * to the mesh radius, stays under maxErrorPixels once projected to the screen. */
+unsigned int ModelData::selectLod (float projectedRadius, float maxErrorPixels) const
+{
+    unsigned int selected = 0;
+
+    for (unsigned int i = 1; i < this->lods.size(); ++i)
+    {
+        if (this->lods[i].error * projectedRadius > maxErrorPixels)
+        {
+            break;
+        }
+
+        selected = i;
+    }
+
+    return selected;
+}
+
+const std::vector<Meshlet>& ModelData::getMeshlets () const
+{
+    return this->meshlets;
+}
+
+const size_t ModelData::getSourceVertexCount () const
+{
+    return this->sourceVertexCount;
+}
+
+const glm::vec3 ModelData::getBoundsMin () const
+{
+    return this->boundsMin;
+}
+
+const glm::vec3 ModelData::getBoundsMax () const
+{
+    return this->boundsMax;
+}
+
+const BoundingBox ModelData::getBoundingBox () const
+{
+    return { this->boundsMin, this->boundsMax };
+}
+
+const BoundingSphere& ModelData::getBoundingSphere () const
+{
+    return this->boundingSphere;
+}
+
+const OrientedBoundingBox& ModelData::getOrientedBoundingBox () const
+{
+    return this->orientedBoundingBox;
+}
+
+const MeshOptimizationReport& ModelData::getOptimizationReport () const
+{
+    return this->optimizationReport;
+}
+
+const QuantizationReport& ModelData::getQuantizationReport () const
+{
+    return this->quantizationReport;
+}
+
+std::ostream& operator<<(std::ostream& os, const ModelData& model)
+{
+    for (unsigned int i = 0; model.getVertexData() && i < model.getVertexDataCount(); ++i)
+    {
+        float vertex [VERTEX_DATA_STRIDE];
+        model.getVertex(i, vertex);
+
+        for (int j = 0; j < VERTEX_DATA_STRIDE; ++j)
+        {
+            if (j == 0 || j == 3 || j == 6)
+            {
+                os << "[ ";
+            }
+
+            os << std::setw(10) << std::fixed << std::setprecision(7) << vertex[j] << " ";
+
+            if (j == 2 || j == 5 || j == 7)
+            {
+                os << "], ";
+            }
+
+            if (j == VERTEX_DATA_STRIDE - 1)
+            {
+                os << "\n";
+            }
+        }
+    }
+
+    os << model.getVertexDataCount() << " " << model.getVertexDataSize() << std::endl;
+    os << model.getIndexCount() << " indices, " << model.getSourceVertexCount() << " vertices before deduplication" << std::endl;
+    os << model.getBoundingSphere() << ", " << model.getOrientedBoundingBox() << std::endl;
+    os << model.getOptimizationReport() << std::endl;
+
+    for (unsigned int i = 0; i < model.getLodCount(); ++i)
+    {
+        os << "lod " << i << ": " << model.getLod(i).indexCount / VERTICES_PER_FACE << " triangles, error " << model.getLod(i).error << std::endl;
+    }
+
+    os << model.getQuantizationReport() << std::endl;
+
+    return os;
+}
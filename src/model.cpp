@@ -1,182 +1,260 @@
 #include "model.hpp"
+#include "obj-parser.hpp"
+#include "shader.hpp"
 #include "glm/glm.hpp"
 #include "glad/glad.h"
 
-#include <fstream>
+#include <stdint.h>
+#include <algorithm>
+#include <cfloat>
+#include <cstdlib>
 #include <iostream>
-#include <sstream>
-#include <iomanip>
+#include <string>
+#include <utility>
 
-void Model::constructFromObj (const char* filePath)
+/* Appends to a buffer object, doubling its storage on the GPU when it runs out
+ * so earlier batches never have to be kept in client memory. */
+static void appendBufferData (GLenum target, GLuint& buffer, size_t& capacity, size_t size, const void* data, size_t dataSize)
 {
-    std::ifstream file;
-    file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    if (size + dataSize > capacity)
+    {
+        size_t newCapacity = std::max(capacity * 2, size + dataSize);
+        GLuint newBuffer;
 
-    std::stringstream objDataStream;
+        glGenBuffers(1, &newBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, newCapacity, nullptr, GL_STATIC_DRAW);
 
-    try
-    {
-        file.open(filePath);
-        objDataStream << file.rdbuf();
-        file.close();
-    }
-    catch(const std::ifstream::failure &e)
-    {
-        std::cerr << "File Read Error for '" << filePath << "': " << e.what() << std::endl;
-        exit(-1);
+        if (size > 0)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size);
+        }
+
+        glDeleteBuffers(1, &buffer);
+        buffer = newBuffer;
+        capacity = newCapacity;
     }
 
-    unsigned int vertexCount = 0;
-    unsigned int surfaceNormalCount = 0;
-    unsigned int uvCoordinateCount = 0;
-    unsigned int faceCount = 0;
+    glBindBuffer(target, buffer);
+    glBufferSubData(target, size, dataSize, data);
+}
 
-    std::stringstream vertexStream;
-    std::stringstream surfaceNormalStream;
-    std::stringstream uvCoordinateStream;
-    std::stringstream faceStream;
+/* Names the processing options a streamed load cannot honour, so a caller
+ * that asked for them is told they were dropped. */
+static std::string getIgnoredStreamOptions (const ModelOptions& options)
+{
+    std::string ignored;
 
-    std::string line;
+    ignored += options.vertexFormat != VERTEX_FORMAT_FLOAT ? " vertexFormat" : "";
+    ignored += options.optimizeMesh ? " optimizeMesh" : "";
+    ignored += options.lodCount > 1 ? " lodCount" : "";
+    ignored += options.buildMeshlets ? " buildMeshlets" : "";
+    ignored += options.computeOrientedBounds ? " computeOrientedBounds" : "";
 
-    while (std::getline(objDataStream, line))
-    {
-
-        if (line[0] == 'v' && line[1] == ' ')
-        {
-            vertexStream << line << "\n";
-            ++vertexCount;
-        }
-        else if (line[0] == 'v' && line[1] == 'n' && line[2] == ' ')
-        {
-            surfaceNormalStream << line << "\n";
-            ++surfaceNormalCount;
-        }
-        else if (line[0] == 'v' && line[1] == 't' && line[2] == ' ')
-        {
-            uvCoordinateStream << line << "\n";
-            ++uvCoordinateCount;
-        }
-        else if (line[0] == 'f' && line[1] == ' ')
-        {
-            faceStream << line << "\n";
-            ++faceCount;
-        }
-    }
+    return ignored;
+}
 
-    glm::vec3* vertices = (glm::vec3*) malloc(vertexCount * sizeof(glm::vec3));
-    glm::vec3* surfaceNormals = (glm::vec3*) malloc(surfaceNormalCount * sizeof(glm::vec3));
-    glm::vec2* uvCoordinates = (glm::vec2*) malloc(uvCoordinateCount * sizeof(glm::vec2));
+bool Model::constructFromStream (const char* filePath, const ModelOptions& options)
+{
+    std::string ignored = getIgnoredStreamOptions(options);
 
-    for (int i = 0; i < vertexCount; ++i)
+    if (!ignored.empty())
     {
-        std::string throwAwayID;
-        vertexStream >> throwAwayID;
-        vertexStream >> vertices[i].x;
-        vertexStream >> vertices[i].y;
-        vertexStream >> vertices[i].z;
+        std::cerr << "Model Stream Warning for '" << filePath << "': ignoring" << ignored
+            << "; streamed models have float vertices, 32-bit indices and one LOD" << std::endl;
     }
 
-    for (int i = 0; i < surfaceNormalCount; ++i)
-    {
-        std::string throwAwayID;
-        surfaceNormalStream >> throwAwayID;
-        surfaceNormalStream >> surfaceNormals[i].x;
-        surfaceNormalStream >> surfaceNormals[i].y;
-        surfaceNormalStream >> surfaceNormals[i].z;
-    }
+    glGenVertexArrays(1, &(this->vertexArray));
+    glBindVertexArray(this->vertexArray);
 
-    for (int i = 0; i < uvCoordinateCount; ++i)
-    {
-        std::string throwAwayID;
-        uvCoordinateStream >> throwAwayID;
-        uvCoordinateStream >> uvCoordinates[i].x;
-        uvCoordinateStream >> uvCoordinates[i].y;
-    }
+    this->vertexBuffer = 0;
+    this->indexBuffer = 0;
+
+    size_t vertexCapacity = 0;
+    size_t indexCapacity = 0;
+    std::vector<unsigned int> batchIndices;
 
-    this->vertexDataCount = faceCount * VERTICES_PER_FACE;
-    this->vertexDataSize = this->vertexDataCount * (VERTEX_SIZE + SURFACE_NORMAL_SIZE + UV_COORDINATE_SIZE);
-    this->vertexData = (float*) malloc(this->vertexDataSize);
+    this->vertexDataSize = 0;
+    this->vertexDataCount = 0;
+    this->indexDataSize = 0;
+    this->indexCount = 0;
+    this->boundsMin = glm::vec3(FLT_MAX);
+    this->boundsMax = glm::vec3(-FLT_MAX);
 
-    for (int i = 0; i < faceCount; ++i) {
+    bool streamed = streamObjFile(filePath, options.streamMemoryLimit, [&](const Mesh& batch) {
+        size_t batchVertexDataSize = batch.vertexData.size() * sizeof(float);
+        appendBufferData(GL_ARRAY_BUFFER, this->vertexBuffer, vertexCapacity, this->vertexDataSize, batch.vertexData.data(), batchVertexDataSize);
 
-        std::string throwAwayID;
-        faceStream >> throwAwayID;
+        batchIndices.resize(batch.indices.size());
 
-        for (int j = 0; j < 3; ++j)
+        for (size_t i = 0; i < batch.indices.size(); ++i)
         {
-            int vertexDataIndex = VERTEX_DATA_STRIDE * ((i * VERTICES_PER_FACE) + j);
+            batchIndices[i] = batch.indices[i] + this->vertexDataCount;
+        }
 
-            std::string vertexInfo;
-            faceStream >> vertexInfo;
+        size_t batchIndexDataSize = batchIndices.size() * sizeof(unsigned int);
+        appendBufferData(GL_ELEMENT_ARRAY_BUFFER, this->indexBuffer, indexCapacity, this->indexDataSize, batchIndices.data(), batchIndexDataSize);
 
-            int delimiterPosition = vertexInfo.find('/');
-            int vertexIndex = std::stoi(vertexInfo.substr(0, delimiterPosition)) - 1;
+        this->vertexDataSize += batchVertexDataSize;
+        this->vertexDataCount += batch.vertexData.size() / VERTEX_DATA_STRIDE;
+        this->indexDataSize += batchIndexDataSize;
+        this->indexCount += batch.indices.size();
+        this->boundsMin = glm::min(this->boundsMin, batch.boundsMin);
+        this->boundsMax = glm::max(this->boundsMax, batch.boundsMax);
+    });
 
-            vertexInfo = vertexInfo.substr(delimiterPosition + 1);
-            delimiterPosition = vertexInfo.find('/');
-            int uvCoordinateIndex = std::stoi(vertexInfo.substr(0, delimiterPosition)) - 1;
+    if (!streamed)
+    {
+        return false;
+    }
 
-            vertexInfo = vertexInfo.substr(delimiterPosition + 1);
-            int surfaceNormalIndex = std::stoi(vertexInfo) - 1;
+    if (this->indexCount == 0)
+    {
+        this->boundsMin = glm::vec3(0.0f);
+        this->boundsMax = glm::vec3(0.0f);
+    }
 
-            this->vertexData[vertexDataIndex] = vertices[vertexIndex].x;
-            this->vertexData[vertexDataIndex + 1] = vertices[vertexIndex].y;
-            this->vertexData[vertexDataIndex + 2] = vertices[vertexIndex].z;
+    // Batches are gone by now, so the sphere and box can only be derived from the bounds.
+    this->orientedBoundingBox = makeOrientedBoundingBox({ this->boundsMin, this->boundsMax });
+    this->boundingSphere = { this->orientedBoundingBox.center, glm::length(this->orientedBoundingBox.halfExtents) };
 
-            this->vertexData[vertexDataIndex + 3] = surfaceNormals[surfaceNormalIndex].x;
-            this->vertexData[vertexDataIndex + 4] = surfaceNormals[surfaceNormalIndex].y;
-            this->vertexData[vertexDataIndex + 5] = surfaceNormals[surfaceNormalIndex].z;
+    // Nothing is kept in client memory once the batches are on the GPU.
+    this->vertexData = nullptr;
+    this->indexData = nullptr;
+    this->indexType = GL_UNSIGNED_INT;
+    this->lods.assign(1, { 0, this->indexCount, 0.0f, 0.0f });
 
-            this->vertexData[vertexDataIndex + 6] = uvCoordinates[uvCoordinateIndex].x;
-            this->vertexData[vertexDataIndex + 7] = uvCoordinates[uvCoordinateIndex].y;
-        }
-    }
+    this->vertexFormat = VERTEX_FORMAT_FLOAT;
+    this->vertexLayout = makeVertexLayout(this->vertexFormat);
+    this->positionDequantization = makePositionDequantization(this->vertexFormat, this->boundsMin, this->boundsMax);
+    this->sourceVertexCount = this->indexCount;
+    this->optimizationReport = {};
+    this->quantizationReport = { this->vertexLayout.stride, 0.0f, 0.0f, 0.0f, 0.0f };
 
-    free(vertices);
-    free(surfaceNormals);
-    free(uvCoordinates);
+    glBindBuffer(GL_ARRAY_BUFFER, this->vertexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->indexBuffer);
+    this->setVertexAttributes();
+    return true;
 }
 
-Model::Model (const char* objFilePath)
+void Model::upload ()
 {
-    this->constructFromObj(objFilePath);
-
     glGenVertexArrays(1, &(this->vertexArray));
     glBindVertexArray(this->vertexArray);
 
     glGenBuffers(1, &(this->vertexBuffer));
     glBindBuffer(GL_ARRAY_BUFFER, this->vertexBuffer);
-
     glBufferData(GL_ARRAY_BUFFER, this->vertexDataSize, this->vertexData, GL_STATIC_DRAW);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_DATA_STRIDE * sizeof(float), (void*)(0));
-    glEnableVertexAttribArray(0);
+    glGenBuffers(1, &(this->indexBuffer));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->indexDataSize, this->indexData, GL_STATIC_DRAW);
 
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, VERTEX_DATA_STRIDE * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    this->setVertexAttributes();
+    this->ready = true;
+}
 
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, VERTEX_DATA_STRIDE * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+void Model::setVertexAttributes () const
+{
+    for (unsigned int i = 0; i < this->vertexLayout.attributeCount; ++i)
+    {
+        const VertexAttribute& attribute = this->vertexLayout.attributes[i];
+
+        glVertexAttribPointer(
+            attribute.location,
+            attribute.componentCount,
+            attribute.type,
+            attribute.normalized,
+            this->vertexLayout.stride,
+            (void*)(size_t)(attribute.offset)
+        );
+        glEnableVertexAttribArray(attribute.location);
+    }
 }
 
-Model::~Model ()
+Model::Model ()
+    : cullingStatistics {}
+    , vertexArray(0)
+    , vertexBuffer(0)
+    , indexBuffer(0)
+    , ready(false)
+    , failed(false)
+{ }
+
+Model::Model (const char* objFilePath, const ModelOptions& options)
+    : Model()
 {
-    free(this->vertexData);
+    if (options.streamMemoryLimit > 0)
+    {
+        if (!this->constructFromStream(objFilePath, options))
+        {
+            exit(-1);
+        }
+
+        this->ready = true;
+        return;
+    }
+
+    if (!this->load(objFilePath, options))
+    {
+        exit(-1);
+    }
+
+    this->upload();
+}
+
+/* Takes over data built without a context. Nothing is uploaded until upload()
+ * is called on the GL thread. */
+Model::Model (ModelData&& data)
+    : ModelData(std::move(data))
+    , cullingStatistics {}
+    , vertexArray(0)
+    , vertexBuffer(0)
+    , indexBuffer(0)
+    , ready(false)
+    , failed(false)
+{ }
+
+/* A model that failed to load is never drawn; draw calls skip it as they do
+ * one still loading. */
+void Model::markFailed ()
+{
+    this->failed = true;
 }
 
-const size_t Model::getVertexDataSize () const
+bool Model::isReady () const
 {
-    return this->vertexDataSize;
+    return this->ready;
 }
 
-const float* const Model::getVertexData () const
+bool Model::hasFailed () const
 {
-    return this->vertexData;
+    return this->failed;
 }
 
-const unsigned int Model::getVertexDataCount () const
+/* GL objects are released here, so the last handle to a model that was
+ * uploaded has to be dropped on the GL thread. */
+Model::~Model ()
 {
-    return this->vertexDataCount;
+    if (this->vertexArray)
+    {
+        glDeleteBuffers(1, &(this->indexBuffer));
+        glDeleteBuffers(1, &(this->vertexBuffer));
+        glDeleteVertexArrays(1, &(this->vertexArray));
+    }
+}
+
+const MeshletCullingStatistics& Model::getCullingStatistics () const
+{
+    return this->cullingStatistics;
+}
+
+void Model::setDequantizationUniforms (const Shader& shader) const
+{
+    shader.setVec3("positionOffset", this->positionDequantization.offset);
+    shader.setVec3("positionScale", this->positionDequantization.scale);
+    shader.setInt("octahedralNormals", this->vertexFormat == VERTEX_FORMAT_COMPACT_OCTAHEDRAL);
 }
 
 void Model::bindVertexArray () const
@@ -191,39 +269,51 @@ void Model::bindVertexBuffer () const
 
 void Model::drawVertexArray () const
 {
-    glDrawArrays(GL_TRIANGLES, 0, this->vertexDataCount);
+    this->drawLod(0);
 }
 
-std::ostream& operator<<(std::ostream& os, const Model& model)
+void Model::drawLod (unsigned int lod) const
 {
-    const float* const vertices = model.getVertexData();
+    if (!this->ready)
+    {
+        return;
+    }
+
+    const MeshLod& range = this->getLod(lod);
+    size_t indexSize = this->indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+    glDrawElements(GL_TRIANGLES, range.indexCount, this->indexType, (void*)(range.indexOffset * indexSize));
+}
 
-    for (int i = 0; i < model.getVertexDataCount(); ++i)
+/* Draws the full detail level with only the meshlets that survive frustum and
+ * back-face culling, in one multi-draw call. The camera position has to be in
+ * model space. Models without meshlets fall back to drawing everything. */
+void Model::drawMeshlets (const glm::mat4& modelViewProjection, glm::vec3 cameraPosition) const
+{
+    if (!this->ready)
     {
-        const int vertexIdx = i * VERTEX_DATA_STRIDE;
+        return;
+    }
 
-        for (int j = 0; j < VERTEX_DATA_STRIDE; ++j)
-        {
-            if (j == 0 || j == 3 || j == 6)
-            {
-                os << "[ ";
-            }
-
-            os << std::setw(10) << std::fixed << std::setprecision(7) << vertices[vertexIdx + j] << " ";
-
-            if (j == 2 || j == 5 || j == 7)
-            {
-                os << "], ";
-            }
-
-            if (j == VERTEX_DATA_STRIDE - 1)
-            {
-                os << "\n";
-            }
-        }
+    if (this->meshlets.empty())
+    {
+        this->drawLod(0);
+        return;
     }
 
-    os << model.getVertexDataCount() << " " << model.getVertexDataSize() << std::endl;
+    cullMeshlets(this->meshlets, modelViewProjection, cameraPosition, this->visibleRanges, this->cullingStatistics);
+
+    size_t indexSize = this->indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+    this->drawCounts.resize(this->visibleRanges.size());
+    this->drawOffsets.resize(this->visibleRanges.size());
+
+    for (size_t i = 0; i < this->visibleRanges.size(); ++i)
+    {
+        this->drawCounts[i] = this->visibleRanges[i].indexCount;
+        this->drawOffsets[i] = (const void*)(this->visibleRanges[i].indexOffset * indexSize);
+    }
 
-    return os;
-}
\ No newline at end of file
+    if (!this->visibleRanges.empty())
+    {
+        glMultiDrawElements(GL_TRIANGLES, this->drawCounts.data(), this->indexType, this->drawOffsets.data(), this->visibleRanges.size());
+    }
+}
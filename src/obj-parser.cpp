@@ -0,0 +1,1069 @@
+#include "obj-parser.hpp"
+#include "mapped-file.hpp"
+#include "scratch-buffer.hpp"
+#include "vertex-index-map.hpp"
+#include "glm/glm.hpp"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#define MAX_FAST_FLOAT_DIGITS 19
+#define MAX_FAST_FLOAT_EXPONENT 22
+#define MAX_FALLBACK_FLOAT_LENGTH 64
+
+#define MIN_PARALLEL_CHUNK_SIZE (1 << 20)
+
+#define MIN_STREAM_WINDOW_SIZE (64 << 10)
+#define MAX_STREAM_WINDOW_SIZE (16 << 20)
+#define MIN_STREAM_BATCH_VERTEX_COUNT 1024
+#define MAX_STREAM_BATCH_VERTEX_COUNT (1 << 20)
+#define STREAM_BATCH_BYTES_PER_VERTEX 128
+
+#define MISSING_INDEX -1L
+#define INVALID_INDEX LONG_MIN
+#define RELATIVE_INDEX_BASE (1L << 40)
+
+struct ObjCorner
+{
+    long vertex;
+    long uvCoordinate;
+    long surfaceNormal;
+};
+
+struct ObjChunk
+{
+    const char* begin;
+    const char* end;
+
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> surfaceNormals;
+    std::vector<glm::vec2> uvCoordinates;
+    std::vector<ObjCorner> corners;
+
+    // Each distinct corner once, in the order it first appears in the chunk,
+    // with the number of every corner among them and the numbers split by shard.
+    std::vector<ObjCorner> distinctCorners;
+    std::vector<uint32_t> distinctIndices;
+    std::vector<std::vector<uint32_t>> shardDistinctIndices;
+
+    size_t vertexOffset;
+    size_t surfaceNormalOffset;
+    size_t uvCoordinateOffset;
+    size_t cornerOffset;
+    size_t distinctOffset;
+    size_t meshVertexOffset;
+
+    // How many attributes must precede the chunk for its positive indices to
+    // refer back, as the serial parser requires, rather than forward.
+    long vertexReach;
+    long surfaceNormalReach;
+    long uvCoordinateReach;
+};
+
+static const double POWERS_OF_TEN [] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool isDigit (char c)
+{
+    return (unsigned char)(c - '0') < 10;
+}
+
+static inline bool isSpace (char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* skipSpaces (const char* p, const char* end)
+{
+    while (p < end && isSpace(*p))
+    {
+        ++p;
+    }
+
+    return p;
+}
+
+static inline const char* findLineEnd (const char* p, const char* end)
+{
+    const char* lineEnd = (const char*) std::memchr(p, '\n', end - p);
+    return lineEnd ? lineEnd : end;
+}
+
+static void reportParseErrorOnLine (const char* sourceName, size_t lineNumber, const char* message)
+{
+    std::cerr << "OBJ Parse Error in '" << sourceName << "' on line " << lineNumber << ": " << message << std::endl;
+}
+
+static void reportParseError (const char* sourceName, const char* data, const char* position, const char* message)
+{
+    size_t lineNumber = 1;
+
+    for (const char* p = data; p < position; ++p)
+    {
+        lineNumber += (*p == '\n');
+    }
+
+    reportParseErrorOnLine(sourceName, lineNumber, message);
+}
+
+/* Chunks parsed in parallel leave the report to the serial parser, which stops
+ * on the first bad line in the file rather than the first any thread finds. */
+template <bool deferred>
+static bool rejectLine (const char* sourceName, const char* data, const char* position, const char* message)
+{
+    if (!deferred)
+    {
+        reportParseError(sourceName, data, position, message);
+    }
+
+    return false;
+}
+
+static const char* parseFloatFallback (const char* start, const char* end, float& value)
+{
+    char buffer [MAX_FALLBACK_FLOAT_LENGTH];
+    size_t length = 0;
+
+    while (start + length < end && length < MAX_FALLBACK_FLOAT_LENGTH - 1 && !isSpace(start[length]) && start[length] != '\n')
+    {
+        buffer[length] = start[length];
+        ++length;
+    }
+
+    buffer[length] = '\0';
+
+    char* parsedEnd = nullptr;
+    value = std::strtof(buffer, &parsedEnd);
+
+    return parsedEnd == buffer ? nullptr : start + (parsedEnd - buffer);
+}
+
+/* Parses a decimal float without allocating. Values whose mantissa and exponent
+ * are exactly representable as doubles take the exact fast path, anything else
+ * is handed to strtof. */
+static inline const char* parseFloat (const char* p, const char* end, float& value)
+{
+    const char* start = p;
+    bool negative = false;
+
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    uint64_t mantissa = 0;
+    int significantDigits = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+
+    while (p < end && isDigit(*p))
+    {
+        hasDigits = true;
+
+        if (significantDigits < MAX_FAST_FLOAT_DIGITS)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            significantDigits += (mantissa != 0);
+        }
+        else
+        {
+            ++exponent;
+        }
+
+        ++p;
+    }
+
+    if (p < end && *p == '.')
+    {
+        ++p;
+
+        while (p < end && isDigit(*p))
+        {
+            hasDigits = true;
+
+            if (significantDigits < MAX_FAST_FLOAT_DIGITS)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                significantDigits += (mantissa != 0);
+                --exponent;
+            }
+
+            ++p;
+        }
+    }
+
+    if (!hasDigits)
+    {
+        return parseFloatFallback(start, end, value);
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* exponentStart = p;
+        ++p;
+
+        bool negativeExponent = false;
+
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            negativeExponent = (*p == '-');
+            ++p;
+        }
+
+        if (p == end || !isDigit(*p))
+        {
+            p = exponentStart;
+        }
+        else
+        {
+            int explicitExponent = 0;
+
+            while (p < end && isDigit(*p))
+            {
+                if (explicitExponent < 10000)
+                {
+                    explicitExponent = explicitExponent * 10 + (*p - '0');
+                }
+
+                ++p;
+            }
+
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        }
+    }
+
+    if (mantissa >= (uint64_t(1) << 53) || exponent < -MAX_FAST_FLOAT_EXPONENT || exponent > MAX_FAST_FLOAT_EXPONENT)
+    {
+        return parseFloatFallback(start, end, value);
+    }
+
+    double result = (double) mantissa;
+    result = exponent < 0 ? result / POWERS_OF_TEN[-exponent] : result * POWERS_OF_TEN[exponent];
+    value = (float)(negative ? -result : result);
+
+    return p;
+}
+
+static inline const char* parseIndex (const char* p, const char* end, long& value)
+{
+    bool negative = false;
+
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    if (p == end || !isDigit(*p))
+    {
+        return nullptr;
+    }
+
+    long result = 0;
+
+    while (p < end && isDigit(*p))
+    {
+        result = result * 10 + (*p - '0');
+        ++p;
+    }
+
+    value = negative ? -result : result;
+    return p;
+}
+
+static inline long resolveIndex (long index, size_t count)
+{
+    long resolved = index > 0 ? index - 1 : (long) count + index;
+    return (index == 0 || resolved < 0 || resolved >= (long) count) ? INVALID_INDEX : resolved;
+}
+
+/* Chunks parsed in parallel do not yet know how many attributes precede them,
+ * so negative indices are kept relative to the chunk and offset after the merge.
+ * Positive ones are kept as they are and checked against the chunk's reach. */
+static inline long deferIndex (long index, size_t count)
+{
+    if (index == 0)
+    {
+        return INVALID_INDEX;
+    }
+
+    return index > 0 ? index - 1 : (long) count + index - RELATIVE_INDEX_BASE;
+}
+
+static inline void extendReach (long index, size_t count, long& reach)
+{
+    if (index >= 0)
+    {
+        reach = std::max(reach, index + 1 - (long) count);
+    }
+}
+
+static inline long resolveDeferredIndex (long index, size_t chunkOffset, size_t count)
+{
+    if (index == MISSING_INDEX)
+    {
+        return MISSING_INDEX;
+    }
+
+    long resolved = index >= 0 ? index : index + RELATIVE_INDEX_BASE + (long) chunkOffset;
+    return (resolved < 0 || resolved >= (long) count) ? INVALID_INDEX : resolved;
+}
+
+template <bool deferred>
+static inline long mapIndex (long index, size_t count)
+{
+    return deferred ? deferIndex(index, count) : resolveIndex(index, count);
+}
+
+template <bool deferred>
+static inline const char* parseCorner (const char* p, const char* end, ObjCorner& corner, size_t vertexCount, size_t uvCoordinateCount, size_t surfaceNormalCount)
+{
+    long index = 0;
+
+    p = parseIndex(p, end, index);
+    if (!p || (corner.vertex = mapIndex<deferred>(index, vertexCount)) == INVALID_INDEX)
+    {
+        return nullptr;
+    }
+
+    corner.uvCoordinate = MISSING_INDEX;
+    corner.surfaceNormal = MISSING_INDEX;
+
+    if (p < end && *p == '/')
+    {
+        ++p;
+
+        if (p < end && *p != '/')
+        {
+            p = parseIndex(p, end, index);
+            if (!p || (corner.uvCoordinate = mapIndex<deferred>(index, uvCoordinateCount)) == INVALID_INDEX)
+            {
+                return nullptr;
+            }
+        }
+
+        if (p < end && *p == '/')
+        {
+            ++p;
+            p = parseIndex(p, end, index);
+            if (!p || (corner.surfaceNormal = mapIndex<deferred>(index, surfaceNormalCount)) == INVALID_INDEX)
+            {
+                return nullptr;
+            }
+        }
+    }
+
+    return p;
+}
+
+static inline float* writeCorner (float* out, const ObjCorner& corner, const glm::vec3* vertices, const glm::vec2* uvCoordinates, const glm::vec3* surfaceNormals)
+{
+    const glm::vec3& vertex = vertices[corner.vertex];
+    const glm::vec3 surfaceNormal = corner.surfaceNormal == MISSING_INDEX ? glm::vec3(0.0f) : surfaceNormals[corner.surfaceNormal];
+    const glm::vec2 uvCoordinate = corner.uvCoordinate == MISSING_INDEX ? glm::vec2(0.0f) : uvCoordinates[corner.uvCoordinate];
+
+    out[0] = vertex.x;
+    out[1] = vertex.y;
+    out[2] = vertex.z;
+    out[3] = surfaceNormal.x;
+    out[4] = surfaceNormal.y;
+    out[5] = surfaceNormal.z;
+    out[6] = uvCoordinate.x;
+    out[7] = uvCoordinate.y;
+
+    return out + VERTEX_DATA_STRIDE;
+}
+
+static inline VertexKey makeVertexKey (const ObjCorner& corner)
+{
+    return { (int32_t) corner.vertex, (int32_t) corner.uvCoordinate, (int32_t) corner.surfaceNormal };
+}
+
+static inline unsigned int emitCorner (Mesh& mesh, VertexIndexMap& vertexIndices, const ObjCorner& corner, const glm::vec3* vertices, const glm::vec2* uvCoordinates, const glm::vec3* surfaceNormals)
+{
+    bool inserted = false;
+    uint32_t index = vertexIndices.findOrInsert(makeVertexKey(corner), (uint32_t) vertexIndices.getCount(), inserted);
+
+    if (inserted)
+    {
+        size_t offset = mesh.vertexData.size();
+        mesh.vertexData.resize(offset + VERTEX_DATA_STRIDE);
+        writeCorner(mesh.vertexData.data() + offset, corner, vertices, uvCoordinates, surfaceNormals);
+    }
+
+    return index;
+}
+
+/* Parses the lines in [chunk.begin, chunk.end). The serial path resolves every
+ * face corner immediately and emits it into the mesh; the deferred path takes
+ * no mesh and only records corners in the chunk so they can be resolved after
+ * a merge. */
+template <bool deferred>
+static bool parseObjRange (const char* data, const char* sourceName, ObjChunk& chunk, Mesh* mesh, VertexIndexMap* vertexIndices)
+{
+    std::vector<glm::vec3>& vertices = chunk.vertices;
+    std::vector<glm::vec3>& surfaceNormals = chunk.surfaceNormals;
+    std::vector<glm::vec2>& uvCoordinates = chunk.uvCoordinates;
+
+    const char* p = chunk.begin;
+    const char* end = chunk.end;
+
+    while (p < end)
+    {
+        p = skipSpaces(p, end);
+        const char* lineEnd = findLineEnd(p, end);
+
+        if (p + 1 < lineEnd && p[0] == 'v' && isSpace(p[1]))
+        {
+            glm::vec3 vertex;
+            p = parseFloat(skipSpaces(p + 2, lineEnd), lineEnd, vertex.x);
+            p = p ? parseFloat(skipSpaces(p, lineEnd), lineEnd, vertex.y) : p;
+            p = p ? parseFloat(skipSpaces(p, lineEnd), lineEnd, vertex.z) : p;
+
+            if (!p)
+            {
+                return rejectLine<deferred>(sourceName, data, lineEnd, "malformed vertex");
+            }
+
+            vertices.push_back(vertex);
+        }
+        else if (p + 2 < lineEnd && p[0] == 'v' && p[1] == 'n' && isSpace(p[2]))
+        {
+            glm::vec3 surfaceNormal;
+            p = parseFloat(skipSpaces(p + 3, lineEnd), lineEnd, surfaceNormal.x);
+            p = p ? parseFloat(skipSpaces(p, lineEnd), lineEnd, surfaceNormal.y) : p;
+            p = p ? parseFloat(skipSpaces(p, lineEnd), lineEnd, surfaceNormal.z) : p;
+
+            if (!p)
+            {
+                return rejectLine<deferred>(sourceName, data, lineEnd, "malformed surface normal");
+            }
+
+            surfaceNormals.push_back(surfaceNormal);
+        }
+        else if (p + 2 < lineEnd && p[0] == 'v' && p[1] == 't' && isSpace(p[2]))
+        {
+            glm::vec2 uvCoordinate;
+            p = parseFloat(skipSpaces(p + 3, lineEnd), lineEnd, uvCoordinate.x);
+            p = p ? parseFloat(skipSpaces(p, lineEnd), lineEnd, uvCoordinate.y) : p;
+
+            if (!p)
+            {
+                return rejectLine<deferred>(sourceName, data, lineEnd, "malformed uv coordinate");
+            }
+
+            uvCoordinates.push_back(uvCoordinate);
+        }
+        else if (p + 1 < lineEnd && p[0] == 'f' && isSpace(p[1]))
+        {
+            ObjCorner first = {};
+            ObjCorner previous = {};
+            ObjCorner current;
+            unsigned int firstIndex = 0;
+            unsigned int previousIndex = 0;
+            unsigned int currentIndex = 0;
+            int cornerCount = 0;
+
+            p = skipSpaces(p + 2, lineEnd);
+
+            while (p < lineEnd)
+            {
+                p = parseCorner<deferred>(p, lineEnd, current, vertices.size(), uvCoordinates.size(), surfaceNormals.size());
+
+                if (!p)
+                {
+                    return rejectLine<deferred>(sourceName, data, lineEnd, "malformed or out of range face index");
+                }
+
+                if (deferred)
+                {
+                    extendReach(current.vertex, vertices.size(), chunk.vertexReach);
+                    extendReach(current.uvCoordinate, uvCoordinates.size(), chunk.uvCoordinateReach);
+                    extendReach(current.surfaceNormal, surfaceNormals.size(), chunk.surfaceNormalReach);
+                }
+                else
+                {
+                    currentIndex = emitCorner(*mesh, *vertexIndices, current, vertices.data(), uvCoordinates.data(), surfaceNormals.data());
+                }
+
+                // Polygons with more than three corners are fan triangulated.
+                if (cornerCount >= 2 && deferred)
+                {
+                    chunk.corners.push_back(first);
+                    chunk.corners.push_back(previous);
+                    chunk.corners.push_back(current);
+                }
+                else if (cornerCount >= 2)
+                {
+                    mesh->indices.push_back(firstIndex);
+                    mesh->indices.push_back(previousIndex);
+                    mesh->indices.push_back(currentIndex);
+                }
+                else if (cornerCount == 0)
+                {
+                    first = current;
+                    firstIndex = currentIndex;
+                }
+
+                previous = current;
+                previousIndex = currentIndex;
+                ++cornerCount;
+
+                p = skipSpaces(p, lineEnd);
+            }
+
+            if (cornerCount < VERTICES_PER_FACE)
+            {
+                return rejectLine<deferred>(sourceName, data, lineEnd, "face has fewer than three corners");
+            }
+        }
+
+        p = lineEnd + 1;
+    }
+
+    return true;
+}
+
+template <typename Function>
+static void runParallel (size_t taskCount, Function function)
+{
+    std::vector<std::thread> threads;
+    threads.reserve(taskCount - 1);
+
+    for (size_t i = 1; i < taskCount; ++i)
+    {
+        threads.emplace_back(function, i);
+    }
+
+    function(0);
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+bool parseObj (const char* data, size_t size, const char* sourceName, Mesh& mesh)
+{
+    ObjChunk chunk {};
+    chunk.begin = data;
+    chunk.end = data + size;
+
+    VertexIndexMap vertexIndices;
+
+    mesh.vertexData.clear();
+    mesh.indices.clear();
+
+    if (!parseObjRange<false>(data, sourceName, chunk, &mesh, &vertexIndices))
+    {
+        return false;
+    }
+
+    mesh.sourceVertexCount = mesh.indices.size();
+    return true;
+}
+
+bool parseObjParallel (const char* data, size_t size, const char* sourceName, unsigned int threadCount, Mesh& mesh)
+{
+    size_t chunkCount = std::min<size_t>(threadCount, size / MIN_PARALLEL_CHUNK_SIZE);
+
+    if (chunkCount <= 1)
+    {
+        return parseObj(data, size, sourceName, mesh);
+    }
+
+    const char* end = data + size;
+    std::vector<ObjChunk> chunks (chunkCount);
+
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        chunks[i].begin = i == 0 ? data : chunks[i - 1].end;
+        chunks[i].end = i == chunkCount - 1 ? end : findLineEnd(std::max(chunks[i].begin, data + (size / chunkCount) * (i + 1)), end);
+        chunks[i].end = std::min(chunks[i].end + 1, end);
+    }
+
+    std::atomic<bool> malformed { false };
+
+    runParallel(chunkCount, [&](size_t i) {
+        if (!parseObjRange<true>(data, sourceName, chunks[i], nullptr, nullptr))
+        {
+            malformed = true;
+        }
+    });
+
+    // The serial parser reports the first malformed line in the file.
+    if (malformed)
+    {
+        return parseObj(data, size, sourceName, mesh);
+    }
+
+    size_t vertexCount = 0;
+    size_t surfaceNormalCount = 0;
+    size_t uvCoordinateCount = 0;
+    size_t cornerCount = 0;
+
+    for (ObjChunk& chunk : chunks)
+    {
+        chunk.vertexOffset = vertexCount;
+        chunk.surfaceNormalOffset = surfaceNormalCount;
+        chunk.uvCoordinateOffset = uvCoordinateCount;
+        chunk.cornerOffset = cornerCount;
+
+        vertexCount += chunk.vertices.size();
+        surfaceNormalCount += chunk.surfaceNormals.size();
+        uvCoordinateCount += chunk.uvCoordinates.size();
+        cornerCount += chunk.corners.size();
+    }
+
+    std::vector<glm::vec3> vertices (vertexCount);
+    std::vector<glm::vec3> surfaceNormals (surfaceNormalCount);
+    std::vector<glm::vec2> uvCoordinates (uvCoordinateCount);
+
+    runParallel(chunkCount, [&](size_t i) {
+        ObjChunk& chunk = chunks[i];
+        std::copy(chunk.vertices.begin(), chunk.vertices.end(), vertices.begin() + chunk.vertexOffset);
+        std::copy(chunk.surfaceNormals.begin(), chunk.surfaceNormals.end(), surfaceNormals.begin() + chunk.surfaceNormalOffset);
+        std::copy(chunk.uvCoordinates.begin(), chunk.uvCoordinates.end(), uvCoordinates.begin() + chunk.uvCoordinateOffset);
+
+        chunk.vertices = std::vector<glm::vec3>();
+        chunk.surfaceNormals = std::vector<glm::vec3>();
+        chunk.uvCoordinates = std::vector<glm::vec2>();
+    });
+
+    std::atomic<bool> outOfRange { false };
+
+    runParallel(chunkCount, [&](size_t i) {
+        ObjChunk& chunk = chunks[i];
+
+        if (chunk.vertexReach > (long) chunk.vertexOffset
+            || chunk.uvCoordinateReach > (long) chunk.uvCoordinateOffset
+            || chunk.surfaceNormalReach > (long) chunk.surfaceNormalOffset)
+        {
+            outOfRange = true;
+            return;
+        }
+
+        for (ObjCorner& corner : chunk.corners)
+        {
+            corner.vertex = resolveDeferredIndex(corner.vertex, chunk.vertexOffset, vertexCount);
+            corner.uvCoordinate = resolveDeferredIndex(corner.uvCoordinate, chunk.uvCoordinateOffset, uvCoordinateCount);
+            corner.surfaceNormal = resolveDeferredIndex(corner.surfaceNormal, chunk.surfaceNormalOffset, surfaceNormalCount);
+
+            if (corner.vertex == INVALID_INDEX || corner.vertex == MISSING_INDEX || corner.uvCoordinate == INVALID_INDEX || corner.surfaceNormal == INVALID_INDEX)
+            {
+                outOfRange = true;
+                return;
+            }
+        }
+    });
+
+    // A bad index is only found after the merge, where its line is no longer
+    // known; the serial parser stops on it and reports the line.
+    if (outOfRange)
+    {
+        return parseObj(data, size, sourceName, mesh);
+    }
+
+    // Every chunk numbers its distinct corners in the order they first appear.
+    runParallel(chunkCount, [&](size_t i) {
+        ObjChunk& chunk = chunks[i];
+        VertexIndexMap chunkIndices (chunk.corners.size());
+
+        chunk.distinctIndices.resize(chunk.corners.size());
+        chunk.shardDistinctIndices.resize(chunkCount);
+
+        for (size_t j = 0; j < chunk.corners.size(); ++j)
+        {
+            const ObjCorner& corner = chunk.corners[j];
+            bool inserted = false;
+            uint32_t index = chunkIndices.findOrInsert(makeVertexKey(corner), (uint32_t) chunk.distinctCorners.size(), inserted);
+
+            if (inserted)
+            {
+                chunk.shardDistinctIndices[(size_t) corner.vertex % chunkCount].push_back(index);
+                chunk.distinctCorners.push_back(corner);
+            }
+
+            chunk.distinctIndices[j] = index;
+        }
+
+        chunk.corners = std::vector<ObjCorner>();
+    });
+
+    size_t distinctCount = 0;
+
+    for (ObjChunk& chunk : chunks)
+    {
+        chunk.distinctOffset = distinctCount;
+        distinctCount += chunk.distinctCorners.size();
+    }
+
+    // A corner found in more than one chunk takes the number of its first
+    // appearance. Corners are split into shards by position, so every shard
+    // is searched on a thread of its own, visiting the chunks in file order.
+    std::vector<uint32_t> firstDistinctIndices (distinctCount);
+
+    runParallel(chunkCount, [&](size_t shard) {
+        size_t shardCount = 0;
+
+        for (const ObjChunk& chunk : chunks)
+        {
+            shardCount += chunk.shardDistinctIndices[shard].size();
+        }
+
+        VertexIndexMap shardIndices (shardCount);
+
+        for (ObjChunk& chunk : chunks)
+        {
+            for (uint32_t index : chunk.shardDistinctIndices[shard])
+            {
+                bool inserted = false;
+                uint32_t distinctIndex = (uint32_t)(chunk.distinctOffset + index);
+                firstDistinctIndices[distinctIndex] = shardIndices.findOrInsert(makeVertexKey(chunk.distinctCorners[index]), distinctIndex, inserted);
+            }
+
+            chunk.shardDistinctIndices[shard] = std::vector<uint32_t>();
+        }
+    });
+
+    runParallel(chunkCount, [&](size_t i) {
+        ObjChunk& chunk = chunks[i];
+        chunk.meshVertexOffset = 0;
+
+        for (size_t j = 0; j < chunk.distinctCorners.size(); ++j)
+        {
+            chunk.meshVertexOffset += (firstDistinctIndices[chunk.distinctOffset + j] == chunk.distinctOffset + j);
+        }
+    });
+
+    size_t meshVertexCount = 0;
+
+    for (ObjChunk& chunk : chunks)
+    {
+        size_t chunkVertexCount = chunk.meshVertexOffset;
+        chunk.meshVertexOffset = meshVertexCount;
+        meshVertexCount += chunkVertexCount;
+    }
+
+    // Corners seen for the first time are numbered in file order, so the result
+    // matches the serial parser exactly.
+    std::vector<uint32_t> meshIndices (distinctCount);
+
+    mesh.vertexData.resize(meshVertexCount * VERTEX_DATA_STRIDE);
+    mesh.indices.resize(cornerCount);
+
+    runParallel(chunkCount, [&](size_t i) {
+        ObjChunk& chunk = chunks[i];
+        size_t meshVertexIndex = chunk.meshVertexOffset;
+
+        for (size_t j = 0; j < chunk.distinctCorners.size(); ++j)
+        {
+            if (firstDistinctIndices[chunk.distinctOffset + j] == chunk.distinctOffset + j)
+            {
+                meshIndices[chunk.distinctOffset + j] = (uint32_t) meshVertexIndex;
+                writeCorner(mesh.vertexData.data() + meshVertexIndex * VERTEX_DATA_STRIDE, chunk.distinctCorners[j], vertices.data(), uvCoordinates.data(), surfaceNormals.data());
+                ++meshVertexIndex;
+            }
+        }
+
+        chunk.distinctCorners = std::vector<ObjCorner>();
+    });
+
+    runParallel(chunkCount, [&](size_t i) {
+        ObjChunk& chunk = chunks[i];
+
+        for (size_t j = 0; j < chunk.distinctIndices.size(); ++j)
+        {
+            mesh.indices[chunk.cornerOffset + j] = meshIndices[firstDistinctIndices[chunk.distinctOffset + chunk.distinctIndices[j]]];
+        }
+
+        chunk.distinctIndices = std::vector<uint32_t>();
+    });
+
+    mesh.sourceVertexCount = mesh.indices.size();
+    return true;
+}
+
+bool parseObjFile (const char* filePath, Mesh& mesh, unsigned int threadCount)
+{
+    MappedFile file { filePath };
+
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    return parseObjParallel(file.getData(), file.getSize(), filePath, threadCount, mesh);
+}
+
+/* Reads the file through a fixed size window and hands every run of complete
+ * lines to handleLines, stopping if it returns false. A partial line at the end
+ * of a window is carried over to the front of the next read, so no line may be
+ * longer than the window. */
+template <typename Function>
+static bool streamLines (int fd, const char* sourceName, std::vector<char>& window, Function handleLines)
+{
+    if (lseek(fd, 0, SEEK_SET) != 0)
+    {
+        std::cerr << "File Read Error for '" << sourceName << "': " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    size_t carried = 0;
+
+    while (true)
+    {
+        ssize_t bytesRead = read(fd, window.data() + carried, window.size() - carried);
+
+        if (bytesRead < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (bytesRead < 0)
+        {
+            std::cerr << "File Read Error for '" << sourceName << "': " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        const char* begin = window.data();
+        size_t available = carried + bytesRead;
+
+        if (bytesRead == 0)
+        {
+            return available == 0 || handleLines(begin, begin + available);
+        }
+
+        const char* lastLineEnd = (const char*) memrchr(begin, '\n', available);
+
+        if (!lastLineEnd)
+        {
+            if (available == window.size())
+            {
+                std::cerr << "OBJ Parse Error in '" << sourceName << "': line longer than the " << window.size() << " byte stream window" << std::endl;
+                return false;
+            }
+
+            carried = available;
+            continue;
+        }
+
+        if (!handleLines(begin, lastLineEnd + 1))
+        {
+            return false;
+        }
+
+        carried = begin + available - (lastLineEnd + 1);
+        std::memmove(window.data(), lastLineEnd + 1, carried);
+    }
+}
+
+/* Streams the file in two passes over a bounded window. The first pass only
+ * counts attributes so they can be stored in a single allocation, which spills
+ * to a file backed mapping when it would not fit in half the memory limit. The
+ * second pass parses everything and emits faces into batches with their own
+ * vertex deduplication, handing each batch off once it reaches the vertex
+ * limit. Vertices shared by faces in different batches are duplicated. */
+bool streamObjFile (const char* filePath, size_t memoryLimit, const MeshBatchHandler& handleBatch)
+{
+    int fd = open(filePath, O_RDONLY);
+
+    if (fd < 0)
+    {
+        std::cerr << "File Read Error for '" << filePath << "': " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    size_t windowSize = std::min<size_t>(std::max<size_t>(memoryLimit / 16, MIN_STREAM_WINDOW_SIZE), MAX_STREAM_WINDOW_SIZE);
+    size_t batchVertexLimit = std::min<size_t>(std::max<size_t>(memoryLimit / 4 / STREAM_BATCH_BYTES_PER_VERTEX, MIN_STREAM_BATCH_VERTEX_COUNT), MAX_STREAM_BATCH_VERTEX_COUNT);
+    std::vector<char> window (windowSize);
+
+    size_t vertexCapacity = 0;
+    size_t surfaceNormalCapacity = 0;
+    size_t uvCoordinateCapacity = 0;
+
+    bool counted = streamLines(fd, filePath, window, [&](const char* p, const char* end) {
+        while (p < end)
+        {
+            p = skipSpaces(p, end);
+            const char* lineEnd = findLineEnd(p, end);
+
+            if (p + 1 < lineEnd && p[0] == 'v' && isSpace(p[1]))
+            {
+                ++vertexCapacity;
+            }
+            else if (p + 2 < lineEnd && p[0] == 'v' && isSpace(p[2]))
+            {
+                surfaceNormalCapacity += (p[1] == 'n');
+                uvCoordinateCapacity += (p[1] == 't');
+            }
+
+            p = lineEnd + 1;
+        }
+
+        return true;
+    });
+
+    if (!counted)
+    {
+        close(fd);
+        return false;
+    }
+
+    size_t attributeSize = (vertexCapacity + surfaceNormalCapacity) * sizeof(glm::vec3) + uvCoordinateCapacity * sizeof(glm::vec2);
+    ScratchBuffer attributes (attributeSize, attributeSize > memoryLimit / 2);
+
+    glm::vec3* vertices = (glm::vec3*) attributes.getData();
+    glm::vec3* surfaceNormals = vertices + vertexCapacity;
+    glm::vec2* uvCoordinates = (glm::vec2*)(surfaceNormals + surfaceNormalCapacity);
+
+    size_t vertexCount = 0;
+    size_t surfaceNormalCount = 0;
+    size_t uvCoordinateCount = 0;
+    size_t lineNumber = 0;
+
+    Mesh batch {};
+    VertexIndexMap vertexIndices (batchVertexLimit);
+    std::vector<ObjCorner> faceCorners;
+
+    auto flushBatch = [&]() {
+        if (batch.indices.empty())
+        {
+            return;
+        }
+
+        batch.sourceVertexCount = batch.indices.size();
+        computeMeshBounds(batch);
+        handleBatch(batch);
+
+        batch.vertexData.clear();
+        batch.indices.clear();
+        vertexIndices.clear();
+    };
+
+    bool parsed = streamLines(fd, filePath, window, [&](const char* p, const char* end) {
+        while (p < end)
+        {
+            p = skipSpaces(p, end);
+            const char* lineEnd = findLineEnd(p, end);
+            ++lineNumber;
+
+            if (p + 1 < lineEnd && p[0] == 'v' && isSpace(p[1]))
+            {
+                glm::vec3 vertex;
+                p = parseFloat(skipSpaces(p + 2, lineEnd), lineEnd, vertex.x);
+                p = p ? parseFloat(skipSpaces(p, lineEnd), lineEnd, vertex.y) : p;
+                p = p ? parseFloat(skipSpaces(p, lineEnd), lineEnd, vertex.z) : p;
+
+                if (!p || vertexCount == vertexCapacity)
+                {
+                    reportParseErrorOnLine(filePath, lineNumber, p ? "file changed while streaming" : "malformed vertex");
+                    return false;
+                }
+
+                vertices[vertexCount++] = vertex;
+            }
+            else if (p + 2 < lineEnd && p[0] == 'v' && p[1] == 'n' && isSpace(p[2]))
+            {
+                glm::vec3 surfaceNormal;
+                p = parseFloat(skipSpaces(p + 3, lineEnd), lineEnd, surfaceNormal.x);
+                p = p ? parseFloat(skipSpaces(p, lineEnd), lineEnd, surfaceNormal.y) : p;
+                p = p ? parseFloat(skipSpaces(p, lineEnd), lineEnd, surfaceNormal.z) : p;
+
+                if (!p || surfaceNormalCount == surfaceNormalCapacity)
+                {
+                    reportParseErrorOnLine(filePath, lineNumber, p ? "file changed while streaming" : "malformed surface normal");
+                    return false;
+                }
+
+                surfaceNormals[surfaceNormalCount++] = surfaceNormal;
+            }
+            else if (p + 2 < lineEnd && p[0] == 'v' && p[1] == 't' && isSpace(p[2]))
+            {
+                glm::vec2 uvCoordinate;
+                p = parseFloat(skipSpaces(p + 3, lineEnd), lineEnd, uvCoordinate.x);
+                p = p ? parseFloat(skipSpaces(p, lineEnd), lineEnd, uvCoordinate.y) : p;
+
+                if (!p || uvCoordinateCount == uvCoordinateCapacity)
+                {
+                    reportParseErrorOnLine(filePath, lineNumber, p ? "file changed while streaming" : "malformed uv coordinate");
+                    return false;
+                }
+
+                uvCoordinates[uvCoordinateCount++] = uvCoordinate;
+            }
+            else if (p + 1 < lineEnd && p[0] == 'f' && isSpace(p[1]))
+            {
+                faceCorners.clear();
+                p = skipSpaces(p + 2, lineEnd);
+
+                while (p < lineEnd)
+                {
+                    ObjCorner corner;
+                    p = parseCorner<false>(p, lineEnd, corner, vertexCount, uvCoordinateCount, surfaceNormalCount);
+
+                    if (!p)
+                    {
+                        reportParseErrorOnLine(filePath, lineNumber, "malformed or out of range face index");
+                        return false;
+                    }
+
+                    faceCorners.push_back(corner);
+                    p = skipSpaces(p, lineEnd);
+                }
+
+                if (faceCorners.size() < VERTICES_PER_FACE)
+                {
+                    reportParseErrorOnLine(filePath, lineNumber, "face has fewer than three corners");
+                    return false;
+                }
+
+                // Faces are never split, so a batch is handed off before it would overflow.
+                if (vertexIndices.getCount() + faceCorners.size() > batchVertexLimit)
+                {
+                    flushBatch();
+                }
+
+                unsigned int firstIndex = emitCorner(batch, vertexIndices, faceCorners[0], vertices, uvCoordinates, surfaceNormals);
+                unsigned int previousIndex = emitCorner(batch, vertexIndices, faceCorners[1], vertices, uvCoordinates, surfaceNormals);
+
+                for (size_t i = 2; i < faceCorners.size(); ++i)
+                {
+                    unsigned int currentIndex = emitCorner(batch, vertexIndices, faceCorners[i], vertices, uvCoordinates, surfaceNormals);
+
+                    batch.indices.push_back(firstIndex);
+                    batch.indices.push_back(previousIndex);
+                    batch.indices.push_back(currentIndex);
+
+                    previousIndex = currentIndex;
+                }
+            }
+
+            p = lineEnd + 1;
+        }
+
+        return true;
+    });
+
+    if (parsed)
+    {
+        flushBatch();
+    }
+
+    close(fd);
+    return parsed;
+}
@@ -0,0 +1,589 @@
+#include "png-decoder.hpp"
+#include "inflate.hpp"
+
+#include <stdint.h>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Deflate's best case is a 258 byte match in a single bit, just over 1032:1.
+#define PNG_MAX_INFLATE_RATIO 1040
+
+enum PngColorType : uint32_t
+{
+    PNG_COLOR_GREY = 0,
+    PNG_COLOR_RGB = 2,
+    PNG_COLOR_PALETTE = 3,
+    PNG_COLOR_GREY_ALPHA = 4,
+    PNG_COLOR_RGBA = 6
+};
+
+enum PngFilter : uint32_t
+{
+    PNG_FILTER_NONE = 0,
+    PNG_FILTER_SUB = 1,
+    PNG_FILTER_UP = 2,
+    PNG_FILTER_AVERAGE = 3,
+    PNG_FILTER_PAETH = 4
+};
+
+struct PngInfo
+{
+    int width;
+    int height;
+    unsigned int bitDepth;
+    PngColorType colorType;
+    unsigned int channelCount;
+
+    // The tRNS colour key of grey and RGB images, as stored.
+    bool hasColorKey;
+    uint16_t colorKey [3];
+
+    unsigned int paletteSize;
+    unsigned char palette [256 * TEXTURE_IMAGE_CHANNELS];
+};
+
+static const unsigned char pngSignature [PNG_SIGNATURE_SIZE] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+// What stb_image multiplies grey samples below eight bits by, per bit depth.
+static const unsigned int greyDepthScales [9] = { 0, 0xFF, 0x55, 0, 0x11, 0, 0, 0, 0x01 };
+
+static uint32_t readBigEndian32 (const unsigned char* bytes)
+{
+    return ((uint32_t) bytes[0] << 24) | ((uint32_t) bytes[1] << 16) | ((uint32_t) bytes[2] << 8) | bytes[3];
+}
+
+static uint16_t readBigEndian16 (const unsigned char* bytes)
+{
+    return (uint16_t)((bytes[0] << 8) | bytes[1]);
+}
+
+static unsigned int getChannelCount (PngColorType colorType)
+{
+    switch (colorType)
+    {
+        case PNG_COLOR_GREY: return 1;
+        case PNG_COLOR_RGB: return 3;
+        case PNG_COLOR_PALETTE: return 1;
+        case PNG_COLOR_GREY_ALPHA: return 2;
+        case PNG_COLOR_RGBA: return 4;
+        default: return 0;
+    }
+}
+
+static bool isValidBitDepth (PngColorType colorType, unsigned int bitDepth)
+{
+    switch (colorType)
+    {
+        case PNG_COLOR_GREY: return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8 || bitDepth == 16;
+        case PNG_COLOR_PALETTE: return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8;
+        case PNG_COLOR_RGB:
+        case PNG_COLOR_GREY_ALPHA:
+        case PNG_COLOR_RGBA: return bitDepth == 8 || bitDepth == 16;
+        default: return false;
+    }
+}
+
+static void unfilterSub (unsigned char* row, size_t rowBytes, unsigned int pixelBytes)
+{
+    for (size_t i = pixelBytes; i < rowBytes; ++i)
+    {
+        row[i] += row[i - pixelBytes];
+    }
+}
+
+static void unfilterUp (unsigned char* row, const unsigned char* previous, size_t rowBytes)
+{
+    size_t i = 0;
+
+#ifdef __SSE2__
+    for (; i + 16 <= rowBytes; i += 16)
+    {
+        __m128i current = _mm_loadu_si128((const __m128i*)(row + i));
+        __m128i above = _mm_loadu_si128((const __m128i*)(previous + i));
+        _mm_storeu_si128((__m128i*)(row + i), _mm_add_epi8(current, above));
+    }
+#endif
+
+    for (; i < rowBytes; ++i)
+    {
+        row[i] += previous[i];
+    }
+}
+
+static void unfilterAverage (unsigned char* row, const unsigned char* previous, size_t rowBytes, unsigned int pixelBytes)
+{
+    for (size_t i = 0; i < pixelBytes; ++i)
+    {
+        row[i] += previous[i] >> 1;
+    }
+
+    for (size_t i = pixelBytes; i < rowBytes; ++i)
+    {
+        row[i] += (row[i - pixelBytes] + previous[i]) >> 1;
+    }
+}
+
+static void unfilterPaeth (unsigned char* row, const unsigned char* previous, size_t rowBytes, unsigned int pixelBytes)
+{
+    for (size_t i = 0; i < pixelBytes; ++i)
+    {
+        row[i] += previous[i];
+    }
+
+    for (size_t i = pixelBytes; i < rowBytes; ++i)
+    {
+        int a = row[i - pixelBytes];
+        int b = previous[i];
+        int c = previous[i - pixelBytes];
+        int pa = std::abs(b - c);
+        int pb = std::abs(a - c);
+        int pc = std::abs(a + b - 2 * c);
+
+        row[i] += pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+    }
+}
+
+#ifdef __SSE2__
+/* Sub, Average and Paeth depend on the pixel to the left, so the vector paths
+ * go a pixel at a time with all of its channels in one register, which only
+ * pays for three and four byte pixels. */
+template <unsigned int PixelBytes>
+static inline __m128i loadPixel (const unsigned char* pixel)
+{
+    int32_t value = 0;
+    std::memcpy(&value, pixel, PixelBytes);
+    return _mm_cvtsi32_si128(value);
+}
+
+template <unsigned int PixelBytes>
+static inline void storePixel (unsigned char* pixel, __m128i value)
+{
+    int32_t packed = _mm_cvtsi128_si32(value);
+    std::memcpy(pixel, &packed, PixelBytes);
+}
+
+template <unsigned int PixelBytes>
+static void unfilterSubPixels (unsigned char* row, size_t rowBytes)
+{
+    __m128i left = _mm_setzero_si128();
+
+    for (size_t i = 0; i < rowBytes; i += PixelBytes)
+    {
+        left = _mm_add_epi8(left, loadPixel<PixelBytes>(row + i));
+        storePixel<PixelBytes>(row + i, left);
+    }
+}
+
+/* _mm_avg_epu8 rounds up where the filter rounds down, which the low bit of
+ * the two inputs' difference corrects. */
+template <unsigned int PixelBytes>
+static void unfilterAveragePixels (unsigned char* row, const unsigned char* previous, size_t rowBytes)
+{
+    __m128i one = _mm_set1_epi8(1);
+    __m128i left = _mm_setzero_si128();
+
+    for (size_t i = 0; i < rowBytes; i += PixelBytes)
+    {
+        __m128i above = loadPixel<PixelBytes>(previous + i);
+        __m128i average = _mm_sub_epi8(_mm_avg_epu8(left, above), _mm_and_si128(_mm_xor_si128(left, above), one));
+
+        left = _mm_add_epi8(loadPixel<PixelBytes>(row + i), average);
+        storePixel<PixelBytes>(row + i, left);
+    }
+}
+
+static inline __m128i absolute16 (__m128i value)
+{
+    return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value));
+}
+
+static inline __m128i select (__m128i mask, __m128i whenSet, __m128i otherwise)
+{
+    return _mm_or_si128(_mm_and_si128(mask, whenSet), _mm_andnot_si128(mask, otherwise));
+}
+
+/* The predictor's distances are worked out in 16 bits: with p = a + b - c,
+ * |p - a| = |b - c|, |p - b| = |a - c| and |p - c| is the sum of the two
+ * before taking their absolute values. */
+template <unsigned int PixelBytes>
+static void unfilterPaethPixels (unsigned char* row, const unsigned char* previous, size_t rowBytes)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i left = zero;
+    __m128i aboveLeft = zero;
+
+    for (size_t i = 0; i < rowBytes; i += PixelBytes)
+    {
+        __m128i above = _mm_unpacklo_epi8(loadPixel<PixelBytes>(previous + i), zero);
+        __m128i toLeft = _mm_sub_epi16(above, aboveLeft);
+        __m128i toAbove = _mm_sub_epi16(left, aboveLeft);
+        __m128i toAboveLeft = absolute16(_mm_add_epi16(toLeft, toAbove));
+
+        toLeft = absolute16(toLeft);
+        toAbove = absolute16(toAbove);
+
+        __m128i smallest = _mm_min_epi16(toAboveLeft, _mm_min_epi16(toLeft, toAbove));
+        __m128i predicted = select(_mm_cmpeq_epi16(toLeft, smallest), left, select(_mm_cmpeq_epi16(toAbove, smallest), above, aboveLeft));
+        __m128i pixel = _mm_add_epi8(loadPixel<PixelBytes>(row + i), _mm_packus_epi16(predicted, predicted));
+
+        storePixel<PixelBytes>(row + i, pixel);
+        left = _mm_unpacklo_epi8(pixel, zero);
+        aboveLeft = above;
+    }
+}
+#endif
+
+/* Undoes a row's filter in place, given the filter type and the row above,
+ * already unfiltered. */
+static bool unfilterRow (unsigned char filter, unsigned char* row, const unsigned char* previous, size_t rowBytes, unsigned int pixelBytes)
+{
+#ifdef __SSE2__
+    bool vector = pixelBytes == 3 || pixelBytes == 4;
+#endif
+
+    switch (filter)
+    {
+        case PNG_FILTER_NONE:
+            return true;
+        case PNG_FILTER_SUB:
+#ifdef __SSE2__
+            if (vector)
+            {
+                pixelBytes == 4 ? unfilterSubPixels<4>(row, rowBytes) : unfilterSubPixels<3>(row, rowBytes);
+                return true;
+            }
+#endif
+            unfilterSub(row, rowBytes, pixelBytes);
+            return true;
+        case PNG_FILTER_UP:
+            unfilterUp(row, previous, rowBytes);
+            return true;
+        case PNG_FILTER_AVERAGE:
+#ifdef __SSE2__
+            if (vector)
+            {
+                pixelBytes == 4 ? unfilterAveragePixels<4>(row, previous, rowBytes) : unfilterAveragePixels<3>(row, previous, rowBytes);
+                return true;
+            }
+#endif
+            unfilterAverage(row, previous, rowBytes, pixelBytes);
+            return true;
+        case PNG_FILTER_PAETH:
+#ifdef __SSE2__
+            if (vector)
+            {
+                pixelBytes == 4 ? unfilterPaethPixels<4>(row, previous, rowBytes) : unfilterPaethPixels<3>(row, previous, rowBytes);
+                return true;
+            }
+#endif
+            unfilterPaeth(row, previous, rowBytes, pixelBytes);
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* A sample of a row below eight bits, most significant bits first. */
+static inline unsigned int getPackedSample (const unsigned char* row, int x, unsigned int bitDepth)
+{
+    unsigned int bit = x * bitDepth;
+    return (row[bit >> 3] >> (8 - bitDepth - (bit & 7))) & ((1u << bitDepth) - 1);
+}
+
+/* Turns one unfiltered row into RGBA8 the way stb_image does: sixteen bit
+ * samples keep their high byte, grey below eight bits is scaled up, and a
+ * colour key makes the matching pixels transparent. */
+static void expandRow (const PngInfo& info, const unsigned char* row, unsigned char* target)
+{
+    int width = info.width;
+    bool wide = info.bitDepth == 16;
+
+    switch (info.colorType)
+    {
+        case PNG_COLOR_RGBA:
+        {
+            if (!wide)
+            {
+                std::memcpy(target, row, (size_t) width * TEXTURE_IMAGE_CHANNELS);
+                break;
+            }
+
+            for (size_t i = 0; i < (size_t) width * TEXTURE_IMAGE_CHANNELS; ++i)
+            {
+                target[i] = row[2 * i];
+            }
+
+            break;
+        }
+        case PNG_COLOR_RGB:
+        {
+            for (int x = 0; x < width; ++x, target += TEXTURE_IMAGE_CHANNELS)
+            {
+                bool keyed;
+
+                if (wide)
+                {
+                    const unsigned char* sample = row + x * 6;
+                    target[0] = sample[0];
+                    target[1] = sample[2];
+                    target[2] = sample[4];
+                    keyed = readBigEndian16(sample) == info.colorKey[0] && readBigEndian16(sample + 2) == info.colorKey[1]
+                        && readBigEndian16(sample + 4) == info.colorKey[2];
+                }
+                else
+                {
+                    std::memcpy(target, row + x * 3, 3);
+                    keyed = target[0] == (info.colorKey[0] & 0xFF) && target[1] == (info.colorKey[1] & 0xFF) && target[2] == (info.colorKey[2] & 0xFF);
+                }
+
+                target[3] = info.hasColorKey && keyed ? 0 : 255;
+            }
+
+            break;
+        }
+        case PNG_COLOR_GREY:
+        {
+            unsigned int scale = wide ? 1 : greyDepthScales[info.bitDepth];
+            unsigned char key = (unsigned char)((info.colorKey[0] & 0xFF) * scale);
+
+            for (int x = 0; x < width; ++x, target += TEXTURE_IMAGE_CHANNELS)
+            {
+                bool keyed;
+
+                if (wide)
+                {
+                    target[0] = row[2 * x];
+                    keyed = readBigEndian16(row + 2 * x) == info.colorKey[0];
+                }
+                else
+                {
+                    unsigned int sample = info.bitDepth == 8 ? row[x] : getPackedSample(row, x, info.bitDepth);
+                    target[0] = (unsigned char)(sample * scale);
+                    keyed = target[0] == key;
+                }
+
+                target[1] = target[0];
+                target[2] = target[0];
+                target[3] = info.hasColorKey && keyed ? 0 : 255;
+            }
+
+            break;
+        }
+        case PNG_COLOR_GREY_ALPHA:
+        {
+            unsigned int sampleBytes = wide ? 2 : 1;
+
+            for (int x = 0; x < width; ++x, target += TEXTURE_IMAGE_CHANNELS)
+            {
+                const unsigned char* sample = row + x * 2 * sampleBytes;
+                target[0] = sample[0];
+                target[1] = sample[0];
+                target[2] = sample[0];
+                target[3] = sample[sampleBytes];
+            }
+
+            break;
+        }
+        case PNG_COLOR_PALETTE:
+        {
+            for (int x = 0; x < width; ++x, target += TEXTURE_IMAGE_CHANNELS)
+            {
+                unsigned int index = info.bitDepth == 8 ? row[x] : getPackedSample(row, x, info.bitDepth);
+                std::memcpy(target, info.palette + index * TEXTURE_IMAGE_CHANNELS, TEXTURE_IMAGE_CHANNELS);
+            }
+
+            break;
+        }
+    }
+}
+
+bool isPngData (const unsigned char* data, size_t size)
+{
+    return size >= PNG_SIGNATURE_SIZE && std::memcmp(data, pngSignature, PNG_SIGNATURE_SIZE) == 0;
+}
+
+/* Reads the chunks, inflates the image data straight into rows of the known
+ * size, then unfilters them in place and expands them to RGBA8 bottom row first,
+ * matching what stb_image gives with vertical flipping on. Interlaced images
+ * and anything stb_image treats specially are refused, as are damaged files,
+ * so the caller can hand them to stb_image instead. */
+bool decodePng (const unsigned char* data, size_t size, TextureImage& image)
+{
+    if (!isPngData(data, size))
+    {
+        return false;
+    }
+
+    PngInfo info = {};
+    std::vector<unsigned char> compressed;
+    size_t offset = PNG_SIGNATURE_SIZE;
+    bool hasHeader = false;
+    bool ended = false;
+
+    for (unsigned int i = 0; i < 256; ++i)
+    {
+        info.palette[i * TEXTURE_IMAGE_CHANNELS + 3] = 255;
+    }
+
+    while (!ended && size - offset >= 12)
+    {
+        uint32_t length = readBigEndian32(data + offset);
+        const unsigned char* type = data + offset + 4;
+        const unsigned char* chunk = data + offset + 8;
+
+        if (length > size - offset - 12 || (!hasHeader && std::memcmp(type, "IHDR", 4) != 0))
+        {
+            return false;
+        }
+
+        if (std::memcmp(type, "IHDR", 4) == 0)
+        {
+            if (hasHeader || length != 13)
+            {
+                return false;
+            }
+
+            info.width = readBigEndian32(chunk);
+            info.height = readBigEndian32(chunk + 4);
+            info.bitDepth = chunk[8];
+            info.colorType = (PngColorType) chunk[9];
+            info.channelCount = getChannelCount(info.colorType);
+
+            // Compression and filter method, then interlacing.
+            if (chunk[10] != 0 || chunk[11] != 0 || chunk[12] != 0
+                || info.width <= 0 || info.height <= 0 || info.width > PNG_MAX_DIMENSION || info.height > PNG_MAX_DIMENSION
+                || !isValidBitDepth(info.colorType, info.bitDepth))
+            {
+                return false;
+            }
+
+            hasHeader = true;
+        }
+        else if (std::memcmp(type, "PLTE", 4) == 0)
+        {
+            if (length % 3 != 0 || length / 3 > 256 || length == 0)
+            {
+                return false;
+            }
+
+            info.paletteSize = length / 3;
+
+            for (unsigned int i = 0; i < info.paletteSize; ++i)
+            {
+                std::memcpy(info.palette + i * TEXTURE_IMAGE_CHANNELS, chunk + i * 3, 3);
+            }
+        }
+        else if (std::memcmp(type, "tRNS", 4) == 0)
+        {
+            if (info.colorType == PNG_COLOR_PALETTE)
+            {
+                if (info.paletteSize == 0 || length > info.paletteSize)
+                {
+                    return false;
+                }
+
+                for (unsigned int i = 0; i < length; ++i)
+                {
+                    info.palette[i * TEXTURE_IMAGE_CHANNELS + 3] = chunk[i];
+                }
+            }
+            else if (info.colorType == PNG_COLOR_GREY || info.colorType == PNG_COLOR_RGB)
+            {
+                if (length != info.channelCount * 2)
+                {
+                    return false;
+                }
+
+                for (unsigned int i = 0; i < info.channelCount; ++i)
+                {
+                    info.colorKey[i] = readBigEndian16(chunk + i * 2);
+                }
+
+                info.hasColorKey = true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else if (std::memcmp(type, "IDAT", 4) == 0)
+        {
+            compressed.insert(compressed.end(), chunk, chunk + length);
+        }
+        else if (std::memcmp(type, "IEND", 4) == 0)
+        {
+            ended = true;
+        }
+        else if (!(type[0] & 0x20) || std::memcmp(type, "CgBI", 4) == 0)
+        {
+            // An unknown critical chunk, or Apple's variant of the format.
+            return false;
+        }
+
+        offset += (size_t) length + 12;
+    }
+
+    if (!hasHeader || !ended || compressed.empty() || (info.colorType == PNG_COLOR_PALETTE && info.paletteSize == 0))
+    {
+        return false;
+    }
+
+    unsigned int pixelBits = info.channelCount * info.bitDepth;
+    unsigned int pixelBytes = pixelBits >= 8 ? pixelBits / 8 : 1;
+    size_t rowBytes = ((size_t) info.width * pixelBits + 7) / 8;
+    size_t rowsSize = (rowBytes + 1) * info.height;
+    size_t targetRowBytes = (size_t) info.width * TEXTURE_IMAGE_CHANNELS;
+
+    // A header promising more than the image data could inflate to is
+    // damaged, and stb_image refuses anything past INT_MAX bytes anyway.
+    if (rowsSize / PNG_MAX_INFLATE_RATIO > compressed.size() || targetRowBytes * info.height > INT_MAX)
+    {
+        return false;
+    }
+
+    // Kept per thread, so a worker decoding one texture after another does not
+    // fault in a fresh buffer the size of the image every time.
+    static thread_local std::vector<unsigned char> rows;
+    rows.resize(rowsSize);
+
+    if (!inflateZlib(compressed.data(), compressed.size(), rows.data(), rowsSize))
+    {
+        return false;
+    }
+
+    std::unique_ptr<unsigned char, void (*)(void*)> pixels ((unsigned char*) std::malloc(targetRowBytes * info.height), std::free);
+    std::vector<unsigned char> zeroRow (rowBytes, 0);
+    const unsigned char* previous = zeroRow.data();
+
+    if (!pixels)
+    {
+        return false;
+    }
+
+    // Each row is expanded straight after it is unfiltered, while it is still
+    // in cache.
+    for (int y = 0; y < info.height; ++y)
+    {
+        unsigned char* row = rows.data() + (size_t) y * (rowBytes + 1);
+
+        if (!unfilterRow(row[0], row + 1, previous, rowBytes, pixelBytes))
+        {
+            return false;
+        }
+
+        expandRow(info, row + 1, pixels.get() + (size_t)(info.height - 1 - y) * targetRowBytes);
+        previous = row + 1;
+    }
+
+    image.width = info.width;
+    image.height = info.height;
+    image.pixels = std::move(pixels);
+    return true;
+}
@@ -0,0 +1,74 @@
+#include "scratch-buffer.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+/* Working memory that may be larger than the process should keep resident. A
+ * file backed buffer maps an unlinked temporary file, so the kernel can write
+ * its pages out and drop them instead of the process growing without bound. */
+ScratchBuffer::ScratchBuffer (size_t size, bool fileBacked)
+    : data(nullptr)
+    , size(size)
+    , fileBacked(fileBacked)
+{
+    if (this->size == 0)
+    {
+        return;
+    }
+
+    if (!this->fileBacked)
+    {
+        this->data = mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    else
+    {
+        const char* directory = std::getenv("TMPDIR");
+        std::string path = std::string(directory && *directory ? directory : "/tmp") + "/scratch-XXXXXX";
+
+        int fd = mkstemp(&path[0]);
+
+        if (fd < 0 || unlink(path.c_str()) != 0 || ftruncate(fd, this->size) != 0)
+        {
+            std::cerr << "Scratch Buffer Error for '" << path << "': " << std::strerror(errno) << std::endl;
+            exit(-1);
+        }
+
+        this->data = mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+    }
+
+    if (this->data == MAP_FAILED)
+    {
+        std::cerr << "Scratch Buffer Error: could not map " << this->size << " bytes: " << std::strerror(errno) << std::endl;
+        exit(-1);
+    }
+}
+
+ScratchBuffer::~ScratchBuffer ()
+{
+    if (this->data)
+    {
+        munmap(this->data, this->size);
+    }
+}
+
+char* ScratchBuffer::getData () const
+{
+    return (char*) this->data;
+}
+
+const size_t ScratchBuffer::getSize () const
+{
+    return this->size;
+}
+
+const bool ScratchBuffer::isFileBacked () const
+{
+    return this->fileBacked;
+}
@@ -21,40 +21,57 @@ void Shader::checkCompilerErrors (unsigned int shader, std::string type)
     }
 }
 
+Shader::Shader ()
+    : failed(false)
+    , programID(0)
+{ }
+
 Shader::Shader (const char* vertexShaderPath, const char* fragmentShaderPath)
+    : failed(false)
+    , programID(0)
 {
-    std::string vertexShaderSource;
-    std::string fragmentShaderSource;
-
-    std::ifstream vertexShaderFile;
-    std::ifstream fragmentShaderFile;
+    this->compile(readSourceFile(vertexShaderPath), readSourceFile(fragmentShaderPath));
+}
 
-    vertexShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fragmentShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+std::string Shader::readSourceFile (const char* shaderPath)
+{
+    std::string source;
 
-    try
+    if (!readSourceFile(shaderPath, source))
     {
-        vertexShaderFile.open(vertexShaderPath);
-        fragmentShaderFile.open(fragmentShaderPath);
+        exit(-1);
+    }
 
-        std::stringstream vertexShaderStream;
-        std::stringstream fragmentShaderStream;
+    return source;
+}
 
-        vertexShaderStream << vertexShaderFile.rdbuf();
-        fragmentShaderStream << fragmentShaderFile.rdbuf();
+/* Reports a file that cannot be read and returns false rather than exiting,
+ * so a loader thread can hand the failure back to the GL thread. */
+bool Shader::readSourceFile (const char* shaderPath, std::string& source)
+{
+    std::ifstream shaderFile;
+    shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
 
-        vertexShaderFile.close();
-        fragmentShaderFile.close();
+    try
+    {
+        shaderFile.open(shaderPath);
 
-        vertexShaderSource = vertexShaderStream.str();
-        fragmentShaderSource = fragmentShaderStream.str();
+        std::stringstream shaderStream;
+        shaderStream << shaderFile.rdbuf();
+        shaderFile.close();
+
+        source = shaderStream.str();
+        return true;
     }
     catch (std::ifstream::failure &e)
     {
-        std::cerr << "Shader File Read Error: " << e.what() << std::endl;
-        exit(-1);
+        std::cerr << "Shader File Read Error for '" << shaderPath << "': " << e.what() << std::endl;
+        return false;
     }
+}
 
+void Shader::compile (const std::string& vertexShaderSource, const std::string& fragmentShaderSource)
+{
     const char* vertexShaderString = vertexShaderSource.c_str();
     const char* fragmentShaderString = fragmentShaderSource.c_str();
 
@@ -78,6 +95,21 @@ Shader::Shader (const char* vertexShaderPath, const char* fragmentShaderPath)
     glDeleteShader(fragmentShader);
 }
 
+void Shader::markFailed ()
+{
+    this->failed = true;
+}
+
+bool Shader::isReady () const
+{
+    return this->programID != 0;
+}
+
+bool Shader::hasFailed () const
+{
+    return this->failed;
+}
+
 void Shader::use ()
 {
     glUseProgram(this->programID);
@@ -102,3 +134,8 @@ void Shader::setVec3 (const std::string &name, const glm::vec3 &vec) const
 {
     glUniform3fv(glGetUniformLocation(this->programID, name.c_str()), 1, &vec[0]);
 }
+
+void Shader::setVec4 (const std::string &name, const glm::vec4 &vec) const
+{
+    glUniform4fv(glGetUniformLocation(this->programID, name.c_str()), 1, &vec[0]);
+}
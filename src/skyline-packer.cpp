@@ -0,0 +1,123 @@
+#include "skyline-packer.hpp"
+
+#include <algorithm>
+#include <climits>
+
+SkylinePacker::SkylinePacker (int width, int height)
+    : width(width)
+    , height(height)
+    , usedArea(0)
+    , skyline { { 0, 0, width } }
+{ }
+
+/* A rectangle whose left edge sits on the given segment rests on the highest
+ * segment it spans. */
+bool SkylinePacker::fitSegment (size_t segment, int rectangleWidth, int rectangleHeight, int& y) const
+{
+    int x = this->skyline[segment].x;
+
+    if (x + rectangleWidth > this->width)
+    {
+        return false;
+    }
+
+    int remaining = rectangleWidth;
+    y = 0;
+
+    for (size_t i = segment; remaining > 0; ++i)
+    {
+        y = std::max(y, this->skyline[i].y);
+        remaining -= this->skyline[i].width;
+    }
+
+    return y + rectangleHeight <= this->height;
+}
+
+/* Picks the lowest position, then the one wasting the least width, and
+ * raises the skyline over the rectangle. */
+bool SkylinePacker::insert (int rectangleWidth, int rectangleHeight, int& x, int& y)
+{
+    size_t bestSegment = this->skyline.size();
+    int bestY = INT_MAX;
+    int bestWidth = INT_MAX;
+
+    for (size_t i = 0; i < this->skyline.size(); ++i)
+    {
+        int segmentY;
+
+        if (this->fitSegment(i, rectangleWidth, rectangleHeight, segmentY)
+            && (segmentY < bestY || (segmentY == bestY && this->skyline[i].width < bestWidth)))
+        {
+            bestSegment = i;
+            bestY = segmentY;
+            bestWidth = this->skyline[i].width;
+        }
+    }
+
+    if (bestSegment == this->skyline.size())
+    {
+        return false;
+    }
+
+    x = this->skyline[bestSegment].x;
+    y = bestY;
+
+    Segment raised = { x, y + rectangleHeight, rectangleWidth };
+    this->skyline.insert(this->skyline.begin() + bestSegment, raised);
+
+    // Cut the segments now under the rectangle back to where it ends.
+    for (size_t i = bestSegment + 1; i < this->skyline.size();)
+    {
+        Segment& segment = this->skyline[i];
+        int end = raised.x + raised.width;
+
+        if (segment.x >= end)
+        {
+            break;
+        }
+
+        if (segment.x + segment.width <= end)
+        {
+            this->skyline.erase(this->skyline.begin() + i);
+            continue;
+        }
+
+        segment.width -= end - segment.x;
+        segment.x = end;
+        break;
+    }
+
+    // Neighbours at the same height become one segment.
+    for (size_t i = 0; i + 1 < this->skyline.size();)
+    {
+        if (this->skyline[i].y == this->skyline[i + 1].y)
+        {
+            this->skyline[i].width += this->skyline[i + 1].width;
+            this->skyline.erase(this->skyline.begin() + i + 1);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    this->usedArea += (size_t) rectangleWidth * rectangleHeight;
+    return true;
+}
+
+const int SkylinePacker::getUsedHeight () const
+{
+    int usedHeight = 0;
+
+    for (const Segment& segment : this->skyline)
+    {
+        usedHeight = std::max(usedHeight, segment.y);
+    }
+
+    return usedHeight;
+}
+
+const float SkylinePacker::getOccupancy () const
+{
+    return (float) this->usedArea / ((size_t) this->width * this->height);
+}
@@ -4,6 +4,9 @@
 #include "camera.hpp"
 #include "shader.hpp"
 #include "object.hpp"
+#include "asset-loader.hpp"
+#include "asset-registry.hpp"
+#include "texture-manager.hpp"
 
 #include <GLFW/glfw3.h>
 #include <iostream>
@@ -13,6 +16,7 @@
 
 constexpr unsigned int WINDOW_WIDTH = 1600;
 constexpr unsigned int WINDOW_HEIGHT = 800;
+constexpr const char* TEXTURE_PACK_PATH = "textures/textures.texpack";
 
 void errorCallback (int error, const char* description)
 {
@@ -34,45 +38,87 @@ void keyCallback (GLFWwindow* window, int key, int scancode, int action, int mod
     }
 }
 
-int main ()
+/* Binds only what changed since the previous object. Switching between
+ * materials of an array that is already bound costs a single uniform. Returns
+ * false, binding nothing, for an array layer whose maps are not in yet. */
+bool bindMaterial (const Shader& shader, const Material& material, const Material*& boundMaterial, const MaterialArray*& boundArray)
 {
-    glfwSetErrorCallback(errorCallback);
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (&material == boundMaterial)
+    {
+        return true;
+    }
 
-    GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "opengl-solitaire", NULL, NULL);
-    if (window == NULL)
+    if (material.array)
     {
-        std::cerr << "GLFW Error: Failed to create a window." << std::endl;
-        glfwTerminate();
-        return -1;
+        if (!material.array->isLayerReady(material.arrayLayer))
+        {
+            return false;
+        }
+
+        if (material.array.get() != boundArray)
+        {
+            material.array->bind(shader);
+            boundArray = material.array.get();
+        }
+
+        MaterialArray::setLayer(shader, material.arrayLayer);
     }
+    else
+    {
+        shader.setInt("materialArrays", 0);
+        shader.setFloat("material.shine", material.shine);
+        boundArray = nullptr;
 
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
-    glfwSetKeyCallback(window, keyCallback);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, material.diffuse->getID());
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, material.specular->getID());
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, material.emissive->getID());
+    }
 
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    boundMaterial = &material;
+    return true;
+}
 
-    if (!gladLoadGLLoader((GLADloadproc)(glfwGetProcAddress)))
+/* Array materials keep every layer resident, so only plain ones stream. */
+void requestMaterialTextures (TextureManager& textureManager, const Material& material, float screenSize)
+{
+    if (material.array)
     {
-        std::cerr << "GLFW Error: Failed to initialize GLAD.";
-        glfwTerminate();
-        return -1;
+        return;
     }
 
+    textureManager.request(*material.diffuse, screenSize);
+    textureManager.request(*material.specular, screenSize);
+    textureManager.request(*material.emissive, screenSize);
+}
+
+/* Owns every GL resource, so they are all released before the context goes away. */
+void runScene (GLFWwindow* window)
+{
     glEnable(GL_DEPTH_TEST);
 
-    Shader lightingShader { "shaders/lighting.vert.glsl", "shaders/lighting.frag.glsl" };
-    Shader sourceShader { "shaders/source.vert.glsl", "shaders/source.frag.glsl" };
+    AssetLoader assetLoader;
+    assetLoader.addTexturePack(TEXTURE_PACK_PATH);
 
-    Model cubeModel { "models/cube.obj" };
-    Texture diffuseMap { "textures/box_texture_diffuse_map.png" };
-    Texture specularMap { "textures/box_texture_specular_map.png" };
-    Texture emissiveMap { "textures/box_texture_empty.png" };
-    Material cubeMaterial { diffuseMap.getID(), specularMap.getID(), emissiveMap.getID(), 64.0f };
+    TextureManager textureManager { assetLoader };
+    AssetRegistry assetRegistry { assetLoader, &textureManager };
+
+    std::shared_ptr<Shader> lightingShader = assetLoader.loadShader("shaders/lighting.vert.glsl", "shaders/lighting.frag.glsl");
+    std::shared_ptr<Shader> sourceShader = assetLoader.loadShader("shaders/source.vert.glsl", "shaders/source.frag.glsl");
+
+    // Specular intensities are data rather than colour, so they are filtered as is.
+    TextureOptions specularOptions;
+    specularOptions.mipChain.srgb = false;
+
+    std::shared_ptr<Model> cubeModel = assetRegistry.getModel("models/cube.obj");
+    std::shared_ptr<Material> cubeMaterial = std::make_shared<Material>(Material {
+        assetRegistry.getTexture("textures/box_texture_diffuse_map.png"),
+        assetRegistry.getTexture("textures/box_texture_specular_map.png", 0xFF000000, specularOptions),
+        assetRegistry.getTexture("textures/box_texture_empty.png", 0xFF000000),
+        64.0f
+    });
 
     glm::vec3 cubePositions [10] = {
         glm::vec3( 0.0f,  0.0f,  0.0f),
@@ -97,7 +143,7 @@ int main ()
     Object cubes [10];
 
     for (int i = 0; i < 10; ++i) {
-        cubes[i] = { cubePositions[i], glm::vec3(0.5f), &cubeModel, &cubeMaterial };
+        cubes[i] = { cubePositions[i], glm::vec3(0.5f), cubeModel, cubeMaterial };
     }
 
     SunLight sunLight {
@@ -150,51 +196,65 @@ int main ()
         glfwGetCursorPos(window, &xCursorPos, &yCursorPos);
         camera.processMouseInput(glm::vec2(xCursorPos, yCursorPos));
 
+        assetLoader.processUploads();
+
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        lightingShader.use();
+        // Nothing can be drawn without these, and the loader has already said why.
+        if (lightingShader->hasFailed() || sourceShader->hasFailed() || cubeModel->hasFailed())
+        {
+            std::cerr << "Scene Error: a shader or the cube model failed to load, closing the window" << std::endl;
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
+            continue;
+        }
+
+        // Keep presenting frames while the first assets are still loading.
+        if (!lightingShader->isReady() || !sourceShader->isReady() || !cubeModel->isReady())
+        {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+            continue;
+        }
+
+        lightingShader->use();
 
-        lightingShader.setVec3("viewPosition", camera.position);
+        lightingShader->setVec3("viewPosition", camera.position);
 
-        lightingShader.setFloat("material.shine", cubeMaterial.shine);
-        lightingShader.setInt("material.diffuse", 0);
-        lightingShader.setInt("material.specular", 1);
-        lightingShader.setInt("material.emissive", 2);
+        lightingShader->setInt("material.diffuse", 0);
+        lightingShader->setInt("material.specular", 1);
+        lightingShader->setInt("material.emissive", 2);
+        MaterialArray::setSamplerUnits(*lightingShader);
 
-        lightingShader.setVec3("sunLight.direction", sunLight.direction);
-        lightingShader.setVec3("sunLight.ambient", sunLight.ambient);
-        lightingShader.setVec3("sunLight.diffuse", sunLight.diffuse);
-        lightingShader.setVec3("sunLight.specular", sunLight.specular);
+        lightingShader->setVec3("sunLight.direction", sunLight.direction);
+        lightingShader->setVec3("sunLight.ambient", sunLight.ambient);
+        lightingShader->setVec3("sunLight.diffuse", sunLight.diffuse);
+        lightingShader->setVec3("sunLight.specular", sunLight.specular);
 
         for (int i = 0; i < 4; ++i) {
             std::string name = "pointLights[" + std::to_string(i) + "].";
-            lightingShader.setVec3(name + "position", pointLights[i].position);
-            lightingShader.setFloat(name + "constant", pointLights[i].constant);
-            lightingShader.setFloat(name + "linear", pointLights[i].linear);
-            lightingShader.setFloat(name + "quadratic", pointLights[i].quadratic);
-            lightingShader.setVec3(name + "ambient", pointLights[i].ambient);
-            lightingShader.setVec3(name + "diffuse", pointLights[i].diffuse);
-            lightingShader.setVec3(name + "specular", pointLights[i].specular);
+            lightingShader->setVec3(name + "position", pointLights[i].position);
+            lightingShader->setFloat(name + "constant", pointLights[i].constant);
+            lightingShader->setFloat(name + "linear", pointLights[i].linear);
+            lightingShader->setFloat(name + "quadratic", pointLights[i].quadratic);
+            lightingShader->setVec3(name + "ambient", pointLights[i].ambient);
+            lightingShader->setVec3(name + "diffuse", pointLights[i].diffuse);
+            lightingShader->setVec3(name + "specular", pointLights[i].specular);
         }
 
-        lightingShader.setVec3("spotLight.position", camera.position);
-        lightingShader.setVec3("spotLight.direction", camera.forward);
-        lightingShader.setFloat("spotLight.cutOff", spotLight.cutOff);
-        lightingShader.setFloat("spotLight.outerCutOff", spotLight.outerCutOff);
-        lightingShader.setFloat("spotLight.constant", spotLight.constant);
-        lightingShader.setFloat("spotLight.linear", spotLight.linear);
-        lightingShader.setFloat("spotLight.quadratic", spotLight.quadratic);
-        lightingShader.setVec3("spotLight.ambient", spotLight.ambient);
-        lightingShader.setVec3("spotLight.diffuse", spotLight.diffuse);
-        lightingShader.setVec3("spotLight.specular", spotLight.specular);
+        lightingShader->setVec3("spotLight.position", camera.position);
+        lightingShader->setVec3("spotLight.direction", camera.forward);
+        lightingShader->setFloat("spotLight.cutOff", spotLight.cutOff);
+        lightingShader->setFloat("spotLight.outerCutOff", spotLight.outerCutOff);
+        lightingShader->setFloat("spotLight.constant", spotLight.constant);
+        lightingShader->setFloat("spotLight.linear", spotLight.linear);
+        lightingShader->setFloat("spotLight.quadratic", spotLight.quadratic);
+        lightingShader->setVec3("spotLight.ambient", spotLight.ambient);
+        lightingShader->setVec3("spotLight.diffuse", spotLight.diffuse);
+        lightingShader->setVec3("spotLight.specular", spotLight.specular);
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, cubeMaterial.diffuse);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, cubeMaterial.specular);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, cubeMaterial.emissive);
+        const Material* boundMaterial = nullptr;
+        const MaterialArray* boundArray = nullptr;
 
         glm::mat4 viewMat = camera.getLookAt();
         glm::mat4 projectionMat = glm::perspective(
@@ -204,11 +264,14 @@ int main ()
             100.0f
         );
 
-        lightingShader.setMat4("view", viewMat);
-        lightingShader.setMat4("projection", projectionMat);
+        lightingShader->setMat4("view", viewMat);
+        lightingShader->setMat4("projection", projectionMat);
+
+        cubeModel->bindVertexBuffer();
+        cubeModel->bindVertexArray();
+        cubeModel->setDequantizationUniforms(*lightingShader);
 
-        cubeModel.bindVertexBuffer();
-        cubeModel.bindVertexArray();
+        const BoundingSphere& cubeSphere = cubeModel->getBoundingSphere();
 
         for (int i = 0; i < 10; ++i) {
 
@@ -217,14 +280,37 @@ int main ()
             modelMat = glm::rotate(modelMat, glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.3f));
             modelMat = glm::scale(modelMat, cubes[i].scale);
 
-            lightingShader.setMat4("model", modelMat);
-
-            cubeModel.drawVertexArray();
+            lightingShader->setMat4("model", modelMat);
+            lightingShader->setVec4("uvRect", cubes[i].uvRect);
+
+            if (!bindMaterial(*lightingShader, *cubes[i].material, boundMaterial, boundArray))
+            {
+                continue;
+            }
+
+            // The rotation only moves the sphere centre, so the radius comes from position and scale alone.
+            BoundingSphere worldSphere = transformBoundingSphere(cubeSphere, cubes[i].position, cubes[i].scale);
+            worldSphere.center = glm::vec3(modelMat * glm::vec4(cubeSphere.center, 1.0f));
+            float projectedRadius = camera.getProjectedRadius(worldSphere.center, worldSphere.radius, (float)(WINDOW_HEIGHT));
+
+            unsigned int lod = cubeModel->selectLod(projectedRadius);
+            requestMaterialTextures(textureManager, *cubes[i].material, 2.0f * projectedRadius);
+
+            if (lod == 0)
+            {
+                glm::vec3 localCameraPosition = glm::vec3(glm::inverse(modelMat) * glm::vec4(camera.position, 1.0f));
+                cubeModel->drawMeshlets(projectionMat * viewMat * modelMat, localCameraPosition);
+            }
+            else
+            {
+                cubeModel->drawLod(lod);
+            }
         }
 
-        sourceShader.use();
-        sourceShader.setMat4("view", viewMat);
-        sourceShader.setMat4("projection", projectionMat);
+        sourceShader->use();
+        sourceShader->setMat4("view", viewMat);
+        sourceShader->setMat4("projection", projectionMat);
+        cubeModel->setDequantizationUniforms(*sourceShader);
 
         for (int i = 0; i < 4; ++i)
         {
@@ -232,14 +318,48 @@ int main ()
             modelMat = glm::translate(modelMat, pointLightPositions[i]);
             modelMat = glm::scale(modelMat, glm::vec3(0.2f));
 
-            sourceShader.setMat4("model", modelMat);
-            sourceShader.setVec3("color", pointLights[i].specular);
-            cubeModel.drawVertexArray();
+            sourceShader->setMat4("model", modelMat);
+            sourceShader->setVec3("color", pointLights[i].specular);
+            cubeModel->drawVertexArray();
         }
 
+        textureManager.update();
+
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
+}
+
+int main ()
+{
+    glfwSetErrorCallback(errorCallback);
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "opengl-solitaire", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cerr << "GLFW Error: Failed to create a window." << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+    glfwSetKeyCallback(window, keyCallback);
+
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)(glfwGetProcAddress)))
+    {
+        std::cerr << "GLFW Error: Failed to initialize GLAD.";
+        glfwTerminate();
+        return -1;
+    }
+
+    runScene(window);
 
     glfwTerminate();
     return 0;
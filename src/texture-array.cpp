@@ -0,0 +1,135 @@
+#include "texture-array.hpp"
+#include "texture-cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+/* Allocates every level for every layer. Layers that were never uploaded
+ * have undefined contents, so draws should wait for theirs. */
+TextureArray::TextureArray (int width, int height, unsigned int layerCapacity)
+    : width(width)
+    , height(height)
+    , levelCount(std::min(getMipLevelCount(width, height), (unsigned int) MAX_TEXTURE_LEVELS))
+    , layerCapacity(layerCapacity)
+{
+    glGenTextures(1, &(this->texture));
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->texture);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, this->levelCount - 1);
+
+    int levelWidth = width;
+    int levelHeight = height;
+
+    for (unsigned int level = 0; level < this->levelCount; ++level)
+    {
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, levelWidth, levelHeight, layerCapacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        levelWidth = std::max(levelWidth / 2, 1);
+        levelHeight = std::max(levelHeight / 2, 1);
+    }
+}
+
+TextureArray::~TextureArray ()
+{
+    glDeleteTextures(1, &(this->texture));
+}
+
+/* The chain has to start at the array's size; levels past the array's own
+ * count are ignored. A single texel, which is what constant images are
+ * reduced to, fills the whole layer. Returns false, with the error reported
+ * and the layer untouched, for a chain that does not fit. */
+bool TextureArray::upload (unsigned int layer, const std::vector<ImageLevel>& levels, TextureUploadRing* ring)
+{
+    bool constant = levels.size() == 1 && levels[0].width == 1 && levels[0].height == 1;
+
+    if (layer >= this->layerCapacity || levels.empty()
+        || (!constant && (levels[0].width != this->width || levels[0].height != this->height)))
+    {
+        std::cerr << "Texture Array Error: cannot put " << (levels.empty() ? 0 : levels[0].width) << "x" << (levels.empty() ? 0 : levels[0].height)
+            << " into layer " << layer << " of a " << this->width << "x" << this->height << "x" << this->layerCapacity << " array" << std::endl;
+        return false;
+    }
+
+    if (constant)
+    {
+        this->fillLayer(layer, levels[0].data.data(), ring);
+        return true;
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->texture);
+
+    for (unsigned int i = 0; i < std::min((unsigned int) levels.size(), this->levelCount); ++i)
+    {
+        const void* pixels = ring ? ring->stage(levels[i].data.data(), levels[i].data.size()) : levels[i].data.data();
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, layer, levels[i].width, levels[i].height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+        if (ring)
+        {
+            ring->finish();
+        }
+    }
+
+    return true;
+}
+
+/* Every level of the layer set to one colour. The texels are written once at
+ * the largest level's size and each level uploads the front of them. */
+void TextureArray::fillLayer (unsigned int layer, const unsigned char* color, TextureUploadRing* ring)
+{
+    std::vector<unsigned char> texels ((size_t) this->width * this->height * TEXTURE_IMAGE_CHANNELS);
+
+    for (size_t i = 0; i < texels.size(); i += TEXTURE_IMAGE_CHANNELS)
+    {
+        std::memcpy(texels.data() + i, color, TEXTURE_IMAGE_CHANNELS);
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->texture);
+
+    int levelWidth = this->width;
+    int levelHeight = this->height;
+
+    for (unsigned int i = 0; i < this->levelCount; ++i)
+    {
+        size_t levelSize = (size_t) levelWidth * levelHeight * TEXTURE_IMAGE_CHANNELS;
+        const void* pixels = ring ? ring->stage(texels.data(), levelSize) : texels.data();
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, layer, levelWidth, levelHeight, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+        if (ring)
+        {
+            ring->finish();
+        }
+
+        levelWidth = std::max(levelWidth / 2, 1);
+        levelHeight = std::max(levelHeight / 2, 1);
+    }
+}
+
+const int TextureArray::getWidth () const
+{
+    return this->width;
+}
+
+const int TextureArray::getHeight () const
+{
+    return this->height;
+}
+
+const unsigned int TextureArray::getLevelCount () const
+{
+    return this->levelCount;
+}
+
+const unsigned int TextureArray::getLayerCapacity () const
+{
+    return this->layerCapacity;
+}
+
+GLuint TextureArray::getID () const
+{
+    return this->texture;
+}
@@ -0,0 +1,61 @@
+#include "texture-atlas.hpp"
+
+TextureAtlas::TextureAtlas ()
+    : ready(false)
+    , failed(false)
+{ }
+
+TextureAtlas::TextureAtlas (const std::vector<std::string>& imagePaths, const AtlasOptions& options)
+    : AtlasData(imagePaths, options)
+    , ready(false)
+    , failed(false)
+{
+    this->upload();
+}
+
+/* Takes over data built without a context. Nothing is uploaded until upload()
+ * runs on the GL thread. */
+TextureAtlas::TextureAtlas (AtlasData&& data)
+    : AtlasData(std::move(data))
+    , ready(false)
+    , failed(false)
+{ }
+
+/* Each page becomes a texture of its own. The pixels are dropped once they are
+ * uploaded; the page sizes and regions stay. */
+void TextureAtlas::upload (TextureUploadRing* ring)
+{
+    this->pageTextures.clear();
+
+    for (AtlasPage& page : this->pages)
+    {
+        std::shared_ptr<Texture> texture = std::make_shared<Texture>();
+        texture->upload(page.levels, ring);
+        this->pageTextures.push_back(std::move(texture));
+
+        std::vector<ImageLevel>().swap(page.levels);
+    }
+
+    this->ready = true;
+}
+
+/* An atlas that failed to build has no pages and never becomes ready. */
+void TextureAtlas::markFailed ()
+{
+    this->failed = true;
+}
+
+bool TextureAtlas::isReady () const
+{
+    return this->ready;
+}
+
+bool TextureAtlas::hasFailed () const
+{
+    return this->failed;
+}
+
+std::shared_ptr<Texture> TextureAtlas::getPageTexture (unsigned int page) const
+{
+    return this->pageTextures[page];
+}
@@ -0,0 +1,203 @@
+#include "texture-cache.hpp"
+#include "mesh-cache.hpp"
+
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+static size_t alignOffset (size_t offset)
+{
+    return (offset + TEXTURE_CACHE_ALIGNMENT - 1) & ~(size_t)(TEXTURE_CACHE_ALIGNMENT - 1);
+}
+
+TextureCache::TextureCache (const char* cachePath)
+    : TextureCache(std::make_shared<MappedFile>(cachePath), 0)
+{ }
+
+TextureCache::TextureCache (std::shared_ptr<const MappedFile> file, size_t headerOffset)
+    : file(std::move(file))
+    , header(nullptr)
+{
+    if (headerOffset <= this->file->getSize() && this->file->getSize() - headerOffset >= sizeof(TextureCacheHeader))
+    {
+        this->header = (const TextureCacheHeader*)(this->file->getData() + headerOffset);
+    }
+}
+
+/* Each level has to be exactly the size its format and dimensions call for,
+ * lie inside the file and halve the one before it. */
+bool TextureCache::isWellFormed () const
+{
+    if (!this->header
+        || this->header->magic != TEXTURE_CACHE_MAGIC
+        || this->header->version != TEXTURE_CACHE_VERSION
+        || this->header->levelCount == 0
+        || this->header->levelCount > MAX_TEXTURE_LEVELS)
+    {
+        return false;
+    }
+
+    CompressedFormat format = (CompressedFormat) this->header->format;
+
+    if (format != COMPRESSED_FORMAT_BC1 && format != COMPRESSED_FORMAT_BC3
+        && format != COMPRESSED_FORMAT_BC4 && format != COMPRESSED_FORMAT_BC7
+        && format != COMPRESSED_FORMAT_RGBA8)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < this->header->levelCount; ++i)
+    {
+        const TextureCacheLevel& level = this->header->levels[i];
+
+        if (level.width == 0 || level.height == 0
+            || level.dataSize != getCompressedSize(format, level.width, level.height)
+            || level.dataOffset > this->file->getSize()
+            || level.dataSize > this->file->getSize() - level.dataOffset)
+        {
+            return false;
+        }
+
+        if (i > 0 && (level.width != std::max(this->header->levels[i - 1].width / 2, 1u)
+            || level.height != std::max(this->header->levels[i - 1].height / 2, 1u)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Same rules as the mesh cache: the chain must have been built with the same
+ * mip chain flags, and the source must match by size and either modification
+ * time or contents. A pack may be shipped without the images it was built
+ * from, so it can allow the source to be missing altogether. */
+bool TextureCache::isValidFor (const char* sourcePath, uint32_t processingFlags, bool allowMissingSource) const
+{
+    SourceFileInfo source;
+
+    if (!this->isWellFormed() || this->header->processingFlags != processingFlags)
+    {
+        return false;
+    }
+
+    if (!statSourceFile(sourcePath, source))
+    {
+        return allowMissingSource;
+    }
+
+    if (source.size != this->header->sourceSize)
+    {
+        return false;
+    }
+
+    return source.modifiedTime == this->header->sourceModifiedTime
+        || hashSourceFile(sourcePath) == this->header->sourceHash;
+}
+
+const TextureCacheHeader& TextureCache::getHeader () const
+{
+    return *(this->header);
+}
+
+const CompressedFormat TextureCache::getFormat () const
+{
+    return (CompressedFormat) this->header->format;
+}
+
+const unsigned int TextureCache::getLevelCount () const
+{
+    return this->header->levelCount;
+}
+
+const TextureCacheLevel& TextureCache::getLevel (unsigned int level) const
+{
+    return this->header->levels[level];
+}
+
+const unsigned char* TextureCache::getLevelData (unsigned int level) const
+{
+    return (const unsigned char*) this->file->getData() + this->header->levels[level].dataOffset;
+}
+
+/* Where texture-cook writes the image's cache, whatever options it was cooked with. */
+std::string TextureCache::getCachePath (const char* sourcePath)
+{
+    return std::string(sourcePath) + TEXTURE_CACHE_EXTENSION;
+}
+
+/* Where the loader saves the RGBA8 chain it built for one set of options, so
+ * it never replaces a cooked cache or the chain saved for other options. */
+std::string TextureCache::getCachePath (const char* sourcePath, uint32_t processingFlags)
+{
+    return std::string(sourcePath) + "." + std::to_string(processingFlags) + TEXTURE_CACHE_EXTENSION;
+}
+
+bool TextureCache::exists (const char* cachePath)
+{
+    struct stat fileStat;
+    return stat(cachePath, &fileStat) == 0 && S_ISREG(fileStat.st_mode);
+}
+
+bool TextureCache::write (const char* cachePath, const char* sourcePath, CompressedFormat format, uint32_t processingFlags, const std::vector<ImageLevel>& levels)
+{
+    SourceFileInfo source;
+
+    if (levels.empty() || levels.size() > MAX_TEXTURE_LEVELS || !statSourceFile(sourcePath, source))
+    {
+        return false;
+    }
+
+    TextureCacheHeader header {};
+    header.magic = TEXTURE_CACHE_MAGIC;
+    header.version = TEXTURE_CACHE_VERSION;
+    header.format = format;
+    header.levelCount = levels.size();
+    header.processingFlags = processingFlags;
+    header.sourceSize = source.size;
+    header.sourceModifiedTime = source.modifiedTime;
+    header.sourceHash = hashSourceFile(sourcePath);
+
+    size_t offset = alignOffset(sizeof(TextureCacheHeader));
+
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        header.levels[i] = { (uint32_t) levels[i].width, (uint32_t) levels[i].height, offset, levels[i].data.size() };
+        offset = alignOffset(offset + levels[i].data.size());
+    }
+
+    // Written to a temporary file first so a partially written cache is never picked up.
+    std::string temporaryPath = makeTemporaryPath(cachePath);
+    std::ofstream file (temporaryPath, std::ios::binary | std::ios::trunc);
+
+    if (!file)
+    {
+        std::cerr << "Texture Cache Write Error for '" << cachePath << "': could not open file" << std::endl;
+        return false;
+    }
+
+    const char padding [TEXTURE_CACHE_ALIGNMENT] = {};
+    size_t written = sizeof(header);
+
+    file.write((const char*) &header, sizeof(header));
+
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        file.write(padding, header.levels[i].dataOffset - written);
+        file.write((const char*) levels[i].data.data(), levels[i].data.size());
+        written = header.levels[i].dataOffset + levels[i].data.size();
+    }
+
+    file.close();
+
+    if (!file || std::rename(temporaryPath.c_str(), cachePath) != 0)
+    {
+        std::cerr << "Texture Cache Write Error for '" << cachePath << "': could not write file" << std::endl;
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,245 @@
+#include "texture-cooker.hpp"
+#include "texture-cache.hpp"
+#include "texture-image.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/* Peak signal to noise ratio of the decoded first level against the source,
+ * over the channels the format actually keeps. */
+static double measurePeakSignalToNoise (CompressedFormat format, const unsigned char* pixels, const ImageLevel& level)
+{
+    std::vector<unsigned char> decoded ((size_t) level.width * level.height * TEXTURE_IMAGE_CHANNELS);
+    decompressImage(format, level.data.data(), level.width, level.height, decoded.data());
+
+    int channelCount = format == COMPRESSED_FORMAT_BC4 ? 1 : format == COMPRESSED_FORMAT_BC1 ? 3 : 4;
+    double squaredError = 0.0;
+
+    for (size_t i = 0; i < (size_t) level.width * level.height; ++i)
+    {
+        for (int c = 0; c < channelCount; ++c)
+        {
+            double difference = (double) pixels[i * TEXTURE_IMAGE_CHANNELS + c] - decoded[i * TEXTURE_IMAGE_CHANNELS + c];
+            squaredError += difference * difference;
+        }
+    }
+
+    double meanSquaredError = squaredError / ((double) level.width * level.height * channelCount);
+    return meanSquaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) : INFINITY;
+}
+
+/* A constant image samples the same at every size, so one texel of it stands
+ * in for the whole chain. */
+static std::vector<ImageLevel> getConstantChain (const unsigned char color [TEXTURE_IMAGE_CHANNELS])
+{
+    return { { 1, 1, std::vector<unsigned char>(color, color + TEXTURE_IMAGE_CHANNELS) } };
+}
+
+/* What the chain of a width by height image takes in the given format. */
+static size_t getChainSize (CompressedFormat format, int width, int height)
+{
+    size_t size = 0;
+
+    for (unsigned int i = 0; i < std::min(getMipLevelCount(width, height), (unsigned int) MAX_TEXTURE_LEVELS); ++i)
+    {
+        size += getCompressedSize(format, width, height);
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+
+    return size;
+}
+
+/* Decodes the source image, builds its mip chain, block-compresses every level
+ * and writes the result next to the source as a texture cache. Images of a
+ * single colour are written as that one texel instead. */
+bool cookTexture (const char* sourcePath, const TextureCookOptions& options, TextureCookReport& report)
+{
+    auto start = std::chrono::steady_clock::now();
+    TextureImage image;
+
+    if (!decodeTextureImage(sourcePath, image))
+    {
+        std::cerr << "Texture Cook Error for '" << sourcePath << "': could not decode image" << std::endl;
+        return false;
+    }
+
+    CompressedFormat format = options.format;
+
+    if (format == COMPRESSED_FORMAT_AUTO)
+    {
+        format = chooseCompressedFormat(image.pixels.get(), image.width, image.height, options.highQuality);
+    }
+
+    unsigned char color [TEXTURE_IMAGE_CHANNELS];
+    uint32_t constantChannels = findConstantChannels(image.pixels.get(), image.width, image.height, color);
+
+    if (constantChannels == ALL_IMAGE_CHANNELS)
+    {
+        size_t chainSize = getChainSize(format, image.width, image.height);
+
+        report = { COMPRESSED_FORMAT_RGBA8, image.width, image.height, 1, getChainSize(COMPRESSED_FORMAT_RGBA8, image.width, image.height),
+            TEXTURE_IMAGE_CHANNELS, INFINITY, 0.0, constantChannels, chainSize - TEXTURE_IMAGE_CHANNELS };
+
+        if (!TextureCache::write(TextureCache::getCachePath(sourcePath).c_str(), sourcePath, COMPRESSED_FORMAT_RGBA8, getMipChainFlags(options.mipChain), getConstantChain(color)))
+        {
+            return false;
+        }
+
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return true;
+    }
+
+    std::vector<ImageLevel> mipChain = generateMipChain(image.pixels.get(), image.width, image.height, options.mipChain);
+    std::vector<ImageLevel> levels (std::min(mipChain.size(), (size_t) MAX_TEXTURE_LEVELS));
+
+    report = { format, image.width, image.height, (unsigned int) levels.size(), 0, 0, 0.0, 0.0, constantChannels, 0 };
+
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        report.uncompressedSize += mipChain[i].data.size();
+
+        if (format == COMPRESSED_FORMAT_RGBA8)
+        {
+            levels[i] = std::move(mipChain[i]);
+        }
+        else
+        {
+            levels[i].width = mipChain[i].width;
+            levels[i].height = mipChain[i].height;
+            levels[i].data.resize(getCompressedSize(format, levels[i].width, levels[i].height));
+            compressImage(format, mipChain[i].data.data(), levels[i].width, levels[i].height, levels[i].data.data());
+        }
+
+        report.compressedSize += levels[i].data.size();
+    }
+
+    report.peakSignalToNoise = measurePeakSignalToNoise(format, image.pixels.get(), levels[0]);
+
+    if (!TextureCache::write(TextureCache::getCachePath(sourcePath).c_str(), sourcePath, format, getMipChainFlags(options.mipChain), levels))
+    {
+        return false;
+    }
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+/* A cooked cache built with these options comes first, then the RGBA8 chain an
+ * earlier load saved for them. Null if neither is valid. */
+std::shared_ptr<TextureCache> findTextureCache (const char* sourcePath, uint32_t processingFlags)
+{
+    for (const std::string& cachePath : { TextureCache::getCachePath(sourcePath), TextureCache::getCachePath(sourcePath, processingFlags) })
+    {
+        if (!TextureCache::exists(cachePath.c_str()))
+        {
+            continue;
+        }
+
+        std::shared_ptr<TextureCache> cache = std::make_shared<TextureCache>(cachePath.c_str());
+
+        if (cache->isValidFor(sourcePath, processingFlags))
+        {
+            return cache;
+        }
+    }
+
+    return nullptr;
+}
+
+/* What the loader falls back to without a cooked cache: the decoded image and
+ * its filtered mip chain, or a single texel for an image of one colour. Saving
+ * it as an RGBA8 cache lets the next launch map the levels instead of decoding
+ * and filtering again. A chain starting at firstLevel leaves out the larger
+ * levels, so it is not complete enough to be saved. */
+bool buildMipChain (const char* sourcePath, const MipChainOptions& options, bool writeCache, std::vector<ImageLevel>& levels, unsigned int firstLevel)
+{
+    TextureImage image;
+    unsigned char color [TEXTURE_IMAGE_CHANNELS];
+
+    if (!decodeTextureImage(sourcePath, image))
+    {
+        return false;
+    }
+
+    if (findConstantChannels(image.pixels.get(), image.width, image.height, color) == ALL_IMAGE_CHANNELS)
+    {
+        levels = getConstantChain(color);
+    }
+    else
+    {
+        levels = generateMipChain(image.pixels.get(), image.width, image.height, options, firstLevel);
+        levels.resize(std::min(levels.size(), (size_t) MAX_TEXTURE_LEVELS));
+    }
+
+    if (writeCache && (firstLevel == 0 || levels.size() == 1))
+    {
+        uint32_t processingFlags = getMipChainFlags(options);
+        TextureCache::write(TextureCache::getCachePath(sourcePath, processingFlags).c_str(), sourcePath, COMPRESSED_FORMAT_RGBA8, processingFlags, levels);
+    }
+
+    return true;
+}
+
+/* The chain from firstLevel down as RGBA levels whatever the source: a valid
+ * texture cache is decoded level by level, anything else goes through
+ * buildMipChain(). */
+bool loadMipChain (const char* sourcePath, const MipChainOptions& options, bool useTextureCache, std::vector<ImageLevel>& levels, unsigned int firstLevel)
+{
+    std::shared_ptr<TextureCache> cache = useTextureCache ? findTextureCache(sourcePath, getMipChainFlags(options)) : nullptr;
+
+    if (cache)
+    {
+        firstLevel = std::min(firstLevel, cache->getLevelCount() - 1);
+        levels.resize(cache->getLevelCount() - firstLevel);
+
+        for (unsigned int i = 0; i < levels.size(); ++i)
+        {
+            const TextureCacheLevel& level = cache->getLevel(firstLevel + i);
+            levels[i].width = level.width;
+            levels[i].height = level.height;
+            levels[i].data.resize((size_t) level.width * level.height * TEXTURE_IMAGE_CHANNELS);
+            decompressImage(cache->getFormat(), cache->getLevelData(firstLevel + i), level.width, level.height, levels[i].data.data());
+        }
+
+        return true;
+    }
+
+    return buildMipChain(sourcePath, options, useTextureCache, levels, firstLevel);
+}
+
+std::ostream& operator<<(std::ostream& os, const TextureCookReport& report)
+{
+    if (report.constantChannels == ALL_IMAGE_CHANNELS)
+    {
+        os << "constant " << report.width << "x" << report.height << " -> 1x1, ";
+        os << std::fixed << std::setprecision(2) << report.savedSize / (1024.0 * 1024.0) << " MB saved, ";
+        os << std::setprecision(3) << report.seconds << " s";
+        return os;
+    }
+
+    os << report.format << " " << report.width << "x" << report.height << ", " << report.levelCount << " levels, ";
+    os << std::fixed << std::setprecision(2) << report.uncompressedSize / (1024.0 * 1024.0) << " MB -> ";
+    os << report.compressedSize / (1024.0 * 1024.0) << " MB (" << (double) report.uncompressedSize / report.compressedSize << "x), ";
+    os << "PSNR " << report.peakSignalToNoise << " dB, " << std::setprecision(3) << report.seconds << " s";
+
+    if (report.constantChannels != 0)
+    {
+        os << ", constant ";
+
+        for (int c = 0; c < TEXTURE_IMAGE_CHANNELS; ++c)
+        {
+            if (report.constantChannels & (1u << c))
+            {
+                os << "rgba"[c];
+            }
+        }
+    }
+
+    return os;
+}
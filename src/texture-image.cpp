@@ -0,0 +1,616 @@
+#include "texture-image.hpp"
+#include "mapped-file.hpp"
+#include "png-decoder.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image/stb_image.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#define LINEAR_TO_SRGB_TABLE_SIZE 16384
+#define MAX_MIP_KERNEL_TAPS 6
+#define MIP_SOURCE_ROW_RING_SIZE 8
+
+struct ColourTables
+{
+    float unormToFloat [256];
+    float srgbToLinear [256];
+    unsigned char linearToSrgb [LINEAR_TO_SRGB_TABLE_SIZE];
+};
+
+/* Taps of a separable 2:1 reduction. Output pixel x reads source pixels
+ * 2x + firstTap onwards, clamped to the edge. */
+struct MipKernel
+{
+    int tapCount;
+    int firstTap;
+    float weights [MAX_MIP_KERNEL_TAPS];
+};
+
+uint32_t getMipChainFlags (const MipChainOptions& options)
+{
+    return options.filter | (options.srgb ? 1u << 8 : 0) | (options.premultiplyAlpha ? 1u << 9 : 0);
+}
+
+static TextureQuality parseTextureQuality (const char* tier)
+{
+    if (!tier || !*tier || std::strcmp(tier, "full") == 0)
+    {
+        return TEXTURE_QUALITY_FULL;
+    }
+
+    if (std::strcmp(tier, "half") == 0)
+    {
+        return TEXTURE_QUALITY_HALF;
+    }
+
+    if (std::strcmp(tier, "quarter") == 0)
+    {
+        return TEXTURE_QUALITY_QUARTER;
+    }
+
+    std::cerr << "Texture Quality Error for '" << tier << "': expected full, half or quarter in " << TEXTURE_QUALITY_VARIABLE << std::endl;
+    exit(-1);
+}
+
+/* The tier is shared by every loader and decode thread. Without an explicit
+ * setting it comes from the environment, so a machine can run at a lower tier
+ * from the same assets without rebuilding anything. */
+static std::atomic<uint32_t>& getTextureQualitySetting ()
+{
+    static std::atomic<uint32_t> quality { parseTextureQuality(std::getenv(TEXTURE_QUALITY_VARIABLE)) };
+    return quality;
+}
+
+/* Only textures loaded afterwards are affected. */
+void setTextureQuality (TextureQuality quality)
+{
+    getTextureQualitySetting().store(quality);
+}
+
+const TextureQuality getTextureQuality ()
+{
+    return (TextureQuality) getTextureQualitySetting().load();
+}
+
+/* Safe to call from any thread; the vertical flip is set per thread so
+ * concurrent decodes do not race on stb_image's global flag. Both decoders
+ * give the same pixels for the images the built-in one accepts. */
+bool decodeTextureImage (const char* textureFilePath, TextureImage& image, ImageDecoder decoder)
+{
+    std::filesystem::path path (textureFilePath);
+    std::error_code error;
+    int channelCount;
+
+    if (decoder == IMAGE_DECODER_PNG && std::filesystem::is_regular_file(path, error) && access(path.c_str(), R_OK) == 0)
+    {
+        MappedFile file (path.c_str());
+
+        if (decodePng((const unsigned char*) file.getData(), file.getSize(), image))
+        {
+            return true;
+        }
+    }
+
+    stbi_set_flip_vertically_on_load_thread(true);
+    stbi_uc* imageData = stbi_load(
+        path.c_str(),
+        &(image.width),
+        &(image.height),
+        &channelCount,
+        STBI_rgb_alpha
+    );
+
+    image.pixels = std::unique_ptr<unsigned char, void (*)(void*)>(imageData, stbi_image_free);
+    return imageData != nullptr;
+}
+
+/* Sets bit c of the result for every channel c that holds the same value in
+ * every pixel, and puts that value in values[c]. Pixels are compared whole
+ * against the first one, and the scan stops once every channel has varied. */
+uint32_t findConstantChannels (const unsigned char* pixels, int width, int height, unsigned char values [TEXTURE_IMAGE_CHANNELS])
+{
+    uint32_t first;
+    uint32_t difference = 0;
+
+    std::memcpy(&first, pixels, sizeof(first));
+    std::memcpy(values, pixels, TEXTURE_IMAGE_CHANNELS);
+
+    auto varied = [](uint32_t difference) {
+        return (difference & 0xFF) && (difference & 0xFF00) && (difference & 0xFF0000) && (difference & 0xFF000000);
+    };
+
+    for (int y = 0; y < height && !varied(difference); ++y)
+    {
+        const unsigned char* row = pixels + (size_t) y * width * TEXTURE_IMAGE_CHANNELS;
+        int x = 0;
+
+#ifdef __SSE2__
+        __m128i reference = _mm_set1_epi32((int) first);
+        __m128i rowDifference = _mm_setzero_si128();
+
+        for (; x + 4 <= width; x += 4)
+        {
+            __m128i texels = _mm_loadu_si128((const __m128i*)(row + x * TEXTURE_IMAGE_CHANNELS));
+            rowDifference = _mm_or_si128(rowDifference, _mm_xor_si128(texels, reference));
+        }
+
+        rowDifference = _mm_or_si128(rowDifference, _mm_shuffle_epi32(rowDifference, _MM_SHUFFLE(1, 0, 3, 2)));
+        rowDifference = _mm_or_si128(rowDifference, _mm_shuffle_epi32(rowDifference, _MM_SHUFFLE(2, 3, 0, 1)));
+        difference |= (uint32_t) _mm_cvtsi128_si32(rowDifference);
+#endif
+
+        for (; x < width; ++x)
+        {
+            uint32_t texel;
+            std::memcpy(&texel, row + x * TEXTURE_IMAGE_CHANNELS, sizeof(texel));
+            difference |= texel ^ first;
+        }
+    }
+
+    uint32_t constantChannels = 0;
+
+    for (int c = 0; c < TEXTURE_IMAGE_CHANNELS; ++c)
+    {
+        if (((difference >> (8 * c)) & 0xFF) == 0)
+        {
+            constantChannels |= 1u << c;
+        }
+    }
+
+    return constantChannels;
+}
+
+static const ColourTables& getColourTables ()
+{
+    static const ColourTables tables = []() {
+        ColourTables tables;
+
+        for (int i = 0; i < 256; ++i)
+        {
+            float value = i / 255.0f;
+            tables.unormToFloat[i] = value;
+            tables.srgbToLinear[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+        }
+
+        for (int i = 0; i < LINEAR_TO_SRGB_TABLE_SIZE; ++i)
+        {
+            float value = (float) i / (LINEAR_TO_SRGB_TABLE_SIZE - 1);
+            float encoded = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+            tables.linearToSrgb[i] = (unsigned char) std::lround(encoded * 255.0f);
+        }
+
+        return tables;
+    }();
+
+    return tables;
+}
+
+/* Zeroth order modified Bessel function of the first kind, by its power series. */
+static float besselI0 (float x)
+{
+    float sum = 1.0f;
+    float term = 1.0f;
+
+    for (int k = 1; k < 20; ++k)
+    {
+        term *= (x / (2.0f * k)) * (x / (2.0f * k));
+        sum += term;
+    }
+
+    return sum;
+}
+
+/* The box filter averages each 2x2 block. The Kaiser filter is a windowed sinc
+ * over six source pixels, which keeps far more detail in the smaller levels
+ * without the aliasing of the box. */
+static const MipKernel& getMipKernel (MipFilter filter)
+{
+    static const MipKernel box = { 2, 0, { 0.5f, 0.5f } };
+    static const MipKernel kaiser = []() {
+        MipKernel kernel = { MAX_MIP_KERNEL_TAPS, 1 - MAX_MIP_KERNEL_TAPS / 2, {} };
+        float sum = 0.0f;
+
+        for (int k = 0; k < kernel.tapCount; ++k)
+        {
+            // Distance in source pixels from the centre of the output pixel.
+            float distance = std::fabs(kernel.firstTap + k - 0.5f);
+            float x = distance * 0.5f * (float) M_PI;
+            float sinc = std::sin(x) / x;
+            float window = distance / MIP_KAISER_WIDTH;
+            float kaiserWindow = besselI0(MIP_KAISER_ALPHA * std::sqrt(std::max(1.0f - window * window, 0.0f))) / besselI0(MIP_KAISER_ALPHA);
+
+            kernel.weights[k] = sinc * kaiserWindow;
+            sum += kernel.weights[k];
+        }
+
+        for (int k = 0; k < kernel.tapCount; ++k)
+        {
+            kernel.weights[k] /= sum;
+        }
+
+        return kernel;
+    }();
+
+    return filter == MIP_FILTER_KAISER ? kaiser : box;
+}
+
+const unsigned int getMipLevelCount (int width, int height)
+{
+    unsigned int levelCount = 1;
+
+    while (width > 1 || height > 1)
+    {
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+        ++levelCount;
+    }
+
+    return levelCount;
+}
+
+/* The smallest level still at least size texels on its longer side: the
+ * coarsest one that gives a surface size pixels across a texel per pixel.
+ * Images smaller than that give level 0. */
+const unsigned int getMipLevelForSize (int width, int height, int size)
+{
+    unsigned int level = 0;
+    int longerSide = std::max(width, height);
+
+    while (longerSide / 2 >= std::max(size, 1))
+    {
+        longerSide /= 2;
+        ++level;
+    }
+
+    return level;
+}
+
+/* Halves an RGBA image with a 2x2 box filter. Odd edges reuse their last row
+ * or column, and a side that is already 1 stays 1. */
+void downsampleImage (const unsigned char* source, int width, int height, unsigned char* destination)
+{
+    int targetWidth = std::max(width / 2, 1);
+    int targetHeight = std::max(height / 2, 1);
+
+    for (int y = 0; y < targetHeight; ++y)
+    {
+        const unsigned char* row0 = source + (size_t) std::min(2 * y, height - 1) * width * TEXTURE_IMAGE_CHANNELS;
+        const unsigned char* row1 = source + (size_t) std::min(2 * y + 1, height - 1) * width * TEXTURE_IMAGE_CHANNELS;
+        unsigned char* targetRow = destination + (size_t) y * targetWidth * TEXTURE_IMAGE_CHANNELS;
+        int x = 0;
+
+        // Columns only clamp when the image is a single pixel wide, so the
+        // vector loops can always read whole pixel pairs.
+        if (width > 1)
+        {
+#ifdef __AVX2__
+            for (; x + 4 <= targetWidth; x += 4)
+            {
+                __m256i zero = _mm256_setzero_si256();
+                __m256i top = _mm256_loadu_si256((const __m256i*)(row0 + 2 * x * TEXTURE_IMAGE_CHANNELS));
+                __m256i bottom = _mm256_loadu_si256((const __m256i*)(row1 + 2 * x * TEXTURE_IMAGE_CHANNELS));
+
+                // Per 128 bit lane: left holds pixels 0 and 1, right pixels 2 and 3.
+                __m256i left = _mm256_add_epi16(_mm256_unpacklo_epi8(top, zero), _mm256_unpacklo_epi8(bottom, zero));
+                __m256i right = _mm256_add_epi16(_mm256_unpackhi_epi8(top, zero), _mm256_unpackhi_epi8(bottom, zero));
+                __m256i sum = _mm256_add_epi16(_mm256_unpacklo_epi64(left, right), _mm256_unpackhi_epi64(left, right));
+
+                sum = _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(2)), 2);
+                __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(sum, sum), _MM_SHUFFLE(3, 1, 2, 0));
+                _mm_storeu_si128((__m128i*)(targetRow + x * TEXTURE_IMAGE_CHANNELS), _mm256_castsi256_si128(packed));
+            }
+#endif
+#ifdef __SSE2__
+            for (; x + 2 <= targetWidth; x += 2)
+            {
+                __m128i zero = _mm_setzero_si128();
+                __m128i top = _mm_loadu_si128((const __m128i*)(row0 + 2 * x * TEXTURE_IMAGE_CHANNELS));
+                __m128i bottom = _mm_loadu_si128((const __m128i*)(row1 + 2 * x * TEXTURE_IMAGE_CHANNELS));
+
+                __m128i left = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+                __m128i right = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+                __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(left, right), _mm_unpackhi_epi64(left, right));
+
+                sum = _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+                _mm_storel_epi64((__m128i*)(targetRow + x * TEXTURE_IMAGE_CHANNELS), _mm_packus_epi16(sum, sum));
+            }
+#endif
+        }
+
+        for (; x < targetWidth; ++x)
+        {
+            int x0 = std::min(2 * x, width - 1) * TEXTURE_IMAGE_CHANNELS;
+            int x1 = std::min(2 * x + 1, width - 1) * TEXTURE_IMAGE_CHANNELS;
+            unsigned char* target = targetRow + x * TEXTURE_IMAGE_CHANNELS;
+
+            for (int c = 0; c < TEXTURE_IMAGE_CHANNELS; ++c)
+            {
+                target[c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4;
+            }
+        }
+    }
+}
+
+/* Converts RGBA bytes to floats in linear light, premultiplied when asked. */
+static void expandPixels (const unsigned char* pixels, size_t count, const MipChainOptions& options, float* destination)
+{
+    const ColourTables& tables = getColourTables();
+    const float* colourTable = options.srgb ? tables.srgbToLinear : tables.unormToFloat;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const unsigned char* pixel = pixels + i * TEXTURE_IMAGE_CHANNELS;
+        float* target = destination + i * TEXTURE_IMAGE_CHANNELS;
+        float alpha = tables.unormToFloat[pixel[3]];
+        float weight = options.premultiplyAlpha ? alpha : 1.0f;
+
+        target[0] = colourTable[pixel[0]] * weight;
+        target[1] = colourTable[pixel[1]] * weight;
+        target[2] = colourTable[pixel[2]] * weight;
+        target[3] = alpha;
+    }
+}
+
+/* The inverse of expandPixels(). The Kaiser filter can overshoot, so every
+ * channel is clamped before it is encoded. */
+static void packPixels (const float* source, size_t count, const MipChainOptions& options, unsigned char* destination)
+{
+    const ColourTables& tables = getColourTables();
+    float colourScale = options.srgb ? LINEAR_TO_SRGB_TABLE_SIZE - 1 : 255.0f;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        unsigned char* target = destination + i * TEXTURE_IMAGE_CHANNELS;
+        int32_t index [4];
+
+#ifdef __SSE2__
+        __m128 zero = _mm_setzero_ps();
+        __m128 one = _mm_set1_ps(1.0f);
+        __m128 pixel = _mm_loadu_ps(source + i * TEXTURE_IMAGE_CHANNELS);
+        __m128 alpha = _mm_min_ps(_mm_max_ps(_mm_shuffle_ps(pixel, pixel, _MM_SHUFFLE(3, 3, 3, 3)), zero), one);
+
+        if (options.premultiplyAlpha)
+        {
+            // Fully transparent texels come out black rather than dividing by zero.
+            __m128 covered = _mm_cmpgt_ps(alpha, zero);
+            pixel = _mm_and_ps(covered, _mm_div_ps(pixel, _mm_max_ps(alpha, _mm_set1_ps(FLT_MIN))));
+        }
+
+        __m128 alphaLane = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+        pixel = _mm_or_ps(_mm_andnot_ps(alphaLane, _mm_min_ps(_mm_max_ps(pixel, zero), one)), _mm_and_ps(alphaLane, alpha));
+        _mm_storeu_si128((__m128i*) index, _mm_cvtps_epi32(_mm_mul_ps(pixel, _mm_set_ps(255.0f, colourScale, colourScale, colourScale))));
+#else
+        const float* pixel = source + i * TEXTURE_IMAGE_CHANNELS;
+        float alpha = std::min(std::max(pixel[3], 0.0f), 1.0f);
+        float weight = !options.premultiplyAlpha ? 1.0f : alpha > 0.0f ? 1.0f / alpha : 0.0f;
+
+        for (int c = 0; c < 3; ++c)
+        {
+            index[c] = (int32_t) std::lround(std::min(std::max(pixel[c] * weight, 0.0f), 1.0f) * colourScale);
+        }
+
+        index[3] = (int32_t) std::lround(alpha * 255.0f);
+#endif
+
+        for (int c = 0; c < 3; ++c)
+        {
+            target[c] = options.srgb ? tables.linearToSrgb[index[c]] : (unsigned char) index[c];
+        }
+
+        target[3] = (unsigned char) index[3];
+    }
+}
+
+/* Weighted sum of whole rows, the vertical pass of the filter. */
+static void filterRows (const float* const* rows, const MipKernel& kernel, size_t count, float* destination)
+{
+    size_t i = 0;
+
+#ifdef __AVX2__
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 sum = _mm256_setzero_ps();
+
+        for (int k = 0; k < kernel.tapCount; ++k)
+        {
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(kernel.weights[k]), _mm256_loadu_ps(rows[k] + i)));
+        }
+
+        _mm256_storeu_ps(destination + i, sum);
+    }
+#endif
+#ifdef __SSE2__
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 sum = _mm_setzero_ps();
+
+        for (int k = 0; k < kernel.tapCount; ++k)
+        {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel.weights[k]), _mm_loadu_ps(rows[k] + i)));
+        }
+
+        _mm_storeu_ps(destination + i, sum);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        float sum = 0.0f;
+
+        for (int k = 0; k < kernel.tapCount; ++k)
+        {
+            sum += kernel.weights[k] * rows[k][i];
+        }
+
+        destination[i] = sum;
+    }
+}
+
+/* Horizontal pass of the filter over one row; each pixel is a whole vector. */
+static void filterColumns (const float* source, int width, const MipKernel& kernel, int targetWidth, float* destination)
+{
+#ifdef __SSE2__
+    __m128 weights [MAX_MIP_KERNEL_TAPS];
+
+    for (int k = 0; k < kernel.tapCount; ++k)
+    {
+        weights[k] = _mm_set1_ps(kernel.weights[k]);
+    }
+#endif
+
+    for (int x = 0; x < targetWidth; ++x)
+    {
+#ifdef __SSE2__
+        __m128 sum = _mm_setzero_ps();
+
+        for (int k = 0; k < kernel.tapCount; ++k)
+        {
+            int sourceX = std::min(std::max(2 * x + kernel.firstTap + k, 0), width - 1);
+            sum = _mm_add_ps(sum, _mm_mul_ps(weights[k], _mm_loadu_ps(source + sourceX * TEXTURE_IMAGE_CHANNELS)));
+        }
+
+        _mm_storeu_ps(destination + x * TEXTURE_IMAGE_CHANNELS, sum);
+#else
+        float* target = destination + x * TEXTURE_IMAGE_CHANNELS;
+        std::fill(target, target + TEXTURE_IMAGE_CHANNELS, 0.0f);
+
+        for (int k = 0; k < kernel.tapCount; ++k)
+        {
+            int sourceX = std::min(std::max(2 * x + kernel.firstTap + k, 0), width - 1);
+
+            for (int c = 0; c < TEXTURE_IMAGE_CHANNELS; ++c)
+            {
+                target[c] += kernel.weights[k] * source[sourceX * TEXTURE_IMAGE_CHANNELS + c];
+            }
+        }
+#endif
+    }
+}
+
+/* Every level of the chain, starting with a copy of the image itself and
+ * ending at 1x1. A plain box filter on linear, straight alpha data works on
+ * the bytes directly. Anything else is filtered as floats in linear light,
+ * each level from the full precision one above it, and only rounded back to
+ * bytes for output. */
+/* Levels before firstLevel are still filtered, since the rest are built from
+ * them, but are dropped as soon as the next one exists rather than returned,
+ * so a chain for a lower quality tier never holds the full size levels. */
+std::vector<ImageLevel> generateMipChain (const unsigned char* pixels, int width, int height, const MipChainOptions& options, unsigned int firstLevel)
+{
+    std::vector<ImageLevel> levels (getMipLevelCount(width, height));
+    firstLevel = std::min(firstLevel, (unsigned int) levels.size() - 1);
+
+    levels[0].width = width;
+    levels[0].height = height;
+
+    if (firstLevel == 0)
+    {
+        levels[0].data.assign(pixels, pixels + (size_t) width * height * TEXTURE_IMAGE_CHANNELS);
+    }
+
+    for (size_t i = 1; i < levels.size(); ++i)
+    {
+        levels[i].width = std::max(levels[i - 1].width / 2, 1);
+        levels[i].height = std::max(levels[i - 1].height / 2, 1);
+    }
+
+    if (options.filter == MIP_FILTER_BOX && !options.srgb && !options.premultiplyAlpha)
+    {
+        const unsigned char* previous = pixels;
+
+        for (size_t i = 1; i < levels.size(); ++i)
+        {
+            levels[i].data.resize((size_t) levels[i].width * levels[i].height * TEXTURE_IMAGE_CHANNELS);
+            downsampleImage(previous, levels[i - 1].width, levels[i - 1].height, levels[i].data.data());
+            previous = levels[i].data.data();
+
+            if (i - 1 < firstLevel)
+            {
+                std::vector<unsigned char>().swap(levels[i - 1].data);
+            }
+        }
+
+        levels.erase(levels.begin(), levels.begin() + firstLevel);
+        return levels;
+    }
+
+    const MipKernel& kernel = getMipKernel(options.filter);
+    std::vector<float> current;
+    std::vector<float> filteredRow;
+    std::vector<float> next;
+    const float* tapRows [MAX_MIP_KERNEL_TAPS];
+
+    // The first level is never held as floats in full. Its rows are expanded
+    // into a small ring as the filter reaches them; output rows step down two
+    // source rows at a time, so a row is never needed again once dropped.
+    std::vector<float> sourceRows ((size_t) MIP_SOURCE_ROW_RING_SIZE * width * TEXTURE_IMAGE_CHANNELS);
+    int sourceRowIndices [MIP_SOURCE_ROW_RING_SIZE];
+    std::fill(sourceRowIndices, sourceRowIndices + MIP_SOURCE_ROW_RING_SIZE, -1);
+
+    for (size_t i = 1; i < levels.size(); ++i)
+    {
+        int currentWidth = levels[i - 1].width;
+        int currentHeight = levels[i - 1].height;
+        int targetWidth = levels[i].width;
+        int targetHeight = levels[i].height;
+        size_t rowSize = (size_t) currentWidth * TEXTURE_IMAGE_CHANNELS;
+
+        filteredRow.resize(rowSize);
+        next.resize((size_t) targetWidth * targetHeight * TEXTURE_IMAGE_CHANNELS);
+
+        for (int y = 0; y < targetHeight; ++y)
+        {
+            for (int k = 0; k < kernel.tapCount; ++k)
+            {
+                int row = std::min(std::max(2 * y + kernel.firstTap + k, 0), currentHeight - 1);
+
+                if (i > 1)
+                {
+                    tapRows[k] = current.data() + row * rowSize;
+                    continue;
+                }
+
+                int slot = row % MIP_SOURCE_ROW_RING_SIZE;
+
+                if (sourceRowIndices[slot] != row)
+                {
+                    expandPixels(pixels + row * rowSize, currentWidth, options, sourceRows.data() + slot * rowSize);
+                    sourceRowIndices[slot] = row;
+                }
+
+                tapRows[k] = sourceRows.data() + slot * rowSize;
+            }
+
+            filterRows(tapRows, kernel, rowSize, filteredRow.data());
+            filterColumns(filteredRow.data(), currentWidth, kernel, targetWidth, next.data() + (size_t) y * targetWidth * TEXTURE_IMAGE_CHANNELS);
+        }
+
+        if (i >= firstLevel)
+        {
+            levels[i].data.resize((size_t) targetWidth * targetHeight * TEXTURE_IMAGE_CHANNELS);
+            packPixels(next.data(), (size_t) targetWidth * targetHeight, options, levels[i].data.data());
+        }
+
+        std::swap(current, next);
+    }
+
+    levels.erase(levels.begin(), levels.begin() + firstLevel);
+    return levels;
+}
@@ -0,0 +1,244 @@
+#include "texture-manager.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#define NO_PENDING_LEVEL UINT_MAX
+
+static size_t getLevelRangeSize (const Texture& texture, unsigned int firstLevel, unsigned int endLevel)
+{
+    size_t size = 0;
+
+    for (unsigned int i = firstLevel; i < endLevel; ++i)
+    {
+        size += texture.getLevelSize(i);
+    }
+
+    return size;
+}
+
+TextureManager::TextureManager (AssetLoader& loader, size_t budget, int tailSize)
+    : loader(loader)
+    , budget(budget)
+    , tailSize(tailSize)
+    , frame(1)
+    , statistics {}
+{
+    this->statistics.budgetBytes = budget;
+}
+
+/* The texture comes back as a placeholder, like any other the loader hands
+ * out, and gets its tail once the image is decoded. */
+std::shared_ptr<Texture> TextureManager::loadTexture (const char* textureFilePath, uint32_t placeholderColor, const TextureOptions& options)
+{
+    std::shared_ptr<Texture> texture = std::make_shared<Texture>(placeholderColor);
+
+    this->entries[texture.get()] = { texture, textureFilePath, options, 0, 0.0f, 0, true, NO_PENDING_LEVEL };
+    this->loader.streamTexture(texture, textureFilePath, options, this->tailSize);
+
+    return texture;
+}
+
+unsigned int TextureManager::getTailLevel (const Texture& texture) const
+{
+    return std::min(getMipLevelForSize(texture.getWidth(), texture.getHeight(), this->tailSize), texture.getLevelCount() - 1);
+}
+
+/* Records that the texture is drawn this frame over screenSize pixels, the
+ * longer side of what it covers. Textures the manager did not load are
+ * ignored. */
+void TextureManager::request (const Texture& texture, float screenSize)
+{
+    auto entry = this->entries.find(&texture);
+
+    if (entry == this->entries.end())
+    {
+        return;
+    }
+
+    if (entry->second.lastUsedFrame != this->frame)
+    {
+        entry->second.lastUsedFrame = this->frame;
+        entry->second.screenSize = 0.0f;
+    }
+
+    entry->second.screenSize = std::max(entry->second.screenSize, screenSize);
+}
+
+/* Evicts the finest resident level of the least recently used texture that
+ * has one to spare, preferring the largest level among equally old ones.
+ * Textures used this frame only give up levels finer than they were asked
+ * for, so nothing drawn now is evicted only to be streamed back next frame. */
+bool TextureManager::evictLevel (std::vector<LiveEntry>& live, const Entry* keep, size_t& residentSize)
+{
+    LiveEntry* victim = nullptr;
+
+    for (LiveEntry& candidate : live)
+    {
+        const Entry& entry = *candidate.entry;
+        unsigned int baseLevel = candidate.texture->getBaseLevel();
+
+        if (&entry == keep || entry.pending || !candidate.texture->isReady() || baseLevel >= entry.wantedLevel)
+        {
+            continue;
+        }
+
+        if (!victim
+            || entry.lastUsedFrame < victim->entry->lastUsedFrame
+            || (entry.lastUsedFrame == victim->entry->lastUsedFrame
+                && candidate.texture->getLevelSize(baseLevel) > victim->texture->getLevelSize(victim->texture->getBaseLevel())))
+        {
+            victim = &candidate;
+        }
+    }
+
+    if (!victim)
+    {
+        return false;
+    }
+
+    size_t evictedSize = victim->texture->evict(victim->texture->getBaseLevel() + 1);
+
+    residentSize -= evictedSize;
+    ++this->statistics.evictedLevels;
+    this->statistics.evictedBytes += evictedSize;
+    return true;
+}
+
+/* Call once a frame, after the frame's requests. Finished loads are noted,
+ * textures that were drawn larger than their resident levels allow stream in
+ * what they lack, nearest first, as far as the budget goes, and anything over
+ * budget is evicted. Levels still loading count against the budget. */
+void TextureManager::update ()
+{
+    std::vector<LiveEntry> live;
+    size_t residentSize = 0;
+    size_t pendingSize = 0;
+    size_t pendingCount = 0;
+
+    for (auto entry = this->entries.begin(); entry != this->entries.end();)
+    {
+        std::shared_ptr<Texture> texture = entry->second.texture.lock();
+
+        if (!texture)
+        {
+            entry = this->entries.erase(entry);
+            continue;
+        }
+
+        Entry& current = entry->second;
+
+        if (current.pending && (texture->hasFailed() || (texture->isReady() && texture->getBaseLevel() <= current.pendingLevel)))
+        {
+            current.pending = false;
+        }
+
+        if (current.pending)
+        {
+            ++pendingCount;
+
+            if (texture->isReady())
+            {
+                pendingSize += getLevelRangeSize(*texture, current.pendingLevel, texture->getBaseLevel());
+            }
+        }
+
+        if (texture->isReady())
+        {
+            unsigned int tailLevel = this->getTailLevel(*texture);
+            unsigned int screenLevel = getMipLevelForSize(texture->getWidth(), texture->getHeight(), (int) std::ceil(current.screenSize));
+
+            current.wantedLevel = current.lastUsedFrame == this->frame ? std::min(screenLevel, tailLevel) : tailLevel;
+            residentSize += texture->getResidentSize();
+        }
+
+        live.push_back({ &current, texture });
+        ++entry;
+    }
+
+    std::vector<LiveEntry*> requested;
+
+    for (LiveEntry& candidate : live)
+    {
+        if (candidate.entry->lastUsedFrame == this->frame && !candidate.entry->pending && candidate.texture->isReady()
+            && !candidate.texture->hasFailed() && candidate.entry->wantedLevel < candidate.texture->getBaseLevel())
+        {
+            requested.push_back(&candidate);
+        }
+    }
+
+    std::sort(requested.begin(), requested.end(), [](const LiveEntry* a, const LiveEntry* b) {
+        return a->entry->screenSize > b->entry->screenSize;
+    });
+
+    for (LiveEntry* candidate : requested)
+    {
+        Entry& entry = *candidate->entry;
+        Texture& texture = *candidate->texture;
+        unsigned int baseLevel = texture.getBaseLevel();
+        unsigned int wantedLevel = entry.wantedLevel;
+        size_t neededSize = getLevelRangeSize(texture, wantedLevel, baseLevel);
+
+        while (residentSize + pendingSize + neededSize > this->budget)
+        {
+            if (!this->evictLevel(live, &entry, residentSize))
+            {
+                break;
+            }
+        }
+
+        // Whatever still does not fit is left out, finest level first.
+        while (wantedLevel < baseLevel && residentSize + pendingSize + neededSize > this->budget)
+        {
+            neededSize -= texture.getLevelSize(wantedLevel);
+            ++wantedLevel;
+        }
+
+        if (wantedLevel == baseLevel)
+        {
+            continue;
+        }
+
+        entry.pending = true;
+        entry.pendingLevel = wantedLevel;
+        pendingSize += neededSize;
+        ++pendingCount;
+        this->statistics.streamedLevels += baseLevel - wantedLevel;
+
+        int residentTexels = std::max(std::max(texture.getWidth(), texture.getHeight()) >> wantedLevel, 1);
+        this->loader.streamTexture(candidate->texture, entry.path.c_str(), entry.options, residentTexels);
+    }
+
+    while (residentSize > this->budget)
+    {
+        if (!this->evictLevel(live, nullptr, residentSize))
+        {
+            break;
+        }
+    }
+
+    this->statistics.textureCount = live.size();
+    this->statistics.residentBytes = residentSize;
+    this->statistics.budgetBytes = this->budget;
+    this->statistics.pendingLoads = pendingCount;
+    ++this->frame;
+}
+
+void TextureManager::setBudget (size_t budget)
+{
+    this->budget = budget;
+}
+
+const TextureManagerStatistics TextureManager::getStatistics () const
+{
+    return this->statistics;
+}
+
+std::ostream& operator<<(std::ostream& os, const TextureManagerStatistics& statistics)
+{
+    os << statistics.textureCount << " textures, " << statistics.residentBytes / 1024 << " of " << statistics.budgetBytes / 1024 << " KiB resident, ";
+    os << statistics.pendingLoads << " loads pending, " << statistics.streamedLevels << " levels streamed, ";
+    os << statistics.evictedLevels << " levels (" << statistics.evictedBytes / 1024 << " KiB) evicted";
+    return os;
+}
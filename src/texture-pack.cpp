@@ -0,0 +1,244 @@
+#include "texture-pack.hpp"
+#include "mesh-cache.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+static size_t alignOffset (size_t offset, size_t alignment)
+{
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+TexturePack::TexturePack (const char* packPath)
+    : file(std::make_shared<MappedFile>(packPath))
+{
+    if (!this->isValid())
+    {
+        return;
+    }
+
+    const char* data = this->file->getData();
+    const TexturePackHeader* header = (const TexturePackHeader*) data;
+    const TexturePackEntry* entries = (const TexturePackEntry*)(data + header->entriesOffset);
+
+    for (uint32_t i = 0; i < header->entryCount; ++i)
+    {
+        std::string path (data + header->pathsOffset + entries[i].pathOffset, entries[i].pathSize);
+        this->headerOffsets[path] = header->entriesOffset + i * sizeof(TexturePackEntry) + offsetof(TexturePackEntry, texture);
+    }
+}
+
+/* The table and the paths have to lie inside the file. Each texture's levels
+ * are only checked when it is looked up. */
+bool TexturePack::isValid () const
+{
+    const char* data = this->file->getData();
+    size_t size = this->file->getSize();
+
+    if (size < sizeof(TexturePackHeader))
+    {
+        return false;
+    }
+
+    const TexturePackHeader* header = (const TexturePackHeader*) data;
+
+    if (header->magic != TEXTURE_PACK_MAGIC
+        || header->version != TEXTURE_PACK_VERSION
+        || header->entriesOffset % alignof(TexturePackEntry) != 0
+        || header->entriesOffset > size
+        || header->entryCount > (size - header->entriesOffset) / sizeof(TexturePackEntry)
+        || header->pathsOffset > size
+        || header->pathsSize > size - header->pathsOffset)
+    {
+        return false;
+    }
+
+    const TexturePackEntry* entries = (const TexturePackEntry*)(data + header->entriesOffset);
+
+    for (uint32_t i = 0; i < header->entryCount; ++i)
+    {
+        if (entries[i].pathOffset > header->pathsSize || entries[i].pathSize > header->pathsSize - entries[i].pathOffset)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const size_t TexturePack::getTextureCount () const
+{
+    return this->headerOffsets.size();
+}
+
+/* The packed texture shares the pack's mapping, so it stays readable for as
+ * long as anything holds it. Null if the pack has no such image. */
+std::shared_ptr<TextureCache> TexturePack::find (const char* sourcePath) const
+{
+    auto found = this->headerOffsets.find(getPackKey(sourcePath));
+
+    if (found == this->headerOffsets.end())
+    {
+        return nullptr;
+    }
+
+    return std::make_shared<TextureCache>(this->file, found->second);
+}
+
+/* Images are found by their path as the game names them, so "./a.png" and
+ * "a.png" are the same texture. */
+std::string TexturePack::getPackKey (const char* sourcePath)
+{
+    return std::filesystem::path(sourcePath).lexically_normal().generic_string();
+}
+
+TexturePackWriter::TexturePackWriter (const char* packPath)
+    : packPath(packPath)
+    , temporaryPath(std::string(packPath) + ".tmp")
+    , file(this->temporaryPath, std::ios::binary | std::ios::trunc)
+    , offset(0)
+{
+    if (!this->file)
+    {
+        std::cerr << "Texture Pack Write Error for '" << packPath << "': could not open file" << std::endl;
+        return;
+    }
+
+    // Filled in by finish(), once the table's place is known.
+    TexturePackHeader header {};
+    this->file.write((const char*) &header, sizeof(header));
+    this->offset = sizeof(header);
+}
+
+void TexturePackWriter::padTo (size_t target)
+{
+    const char padding [TEXTURE_PACK_ALIGNMENT] = {};
+
+    this->file.write(padding, target - this->offset);
+    this->offset = target;
+}
+
+/* Each chain starts on a page of its own, so a texture's levels are never
+ * faulted in with another's. Within the chain levels keep the cache's
+ * alignment. */
+bool TexturePackWriter::add (const char* sourcePath, CompressedFormat format, uint32_t processingFlags, const std::vector<ImageLevel>& levels)
+{
+    SourceFileInfo source;
+
+    if (!this->file || levels.empty() || levels.size() > MAX_TEXTURE_LEVELS || !statSourceFile(sourcePath, source))
+    {
+        return false;
+    }
+
+    TexturePackEntry entry {};
+    entry.pathOffset = this->paths.size();
+    entry.texture.magic = TEXTURE_CACHE_MAGIC;
+    entry.texture.version = TEXTURE_CACHE_VERSION;
+    entry.texture.format = format;
+    entry.texture.levelCount = levels.size();
+    entry.texture.processingFlags = processingFlags;
+    entry.texture.sourceSize = source.size;
+    entry.texture.sourceModifiedTime = source.modifiedTime;
+    entry.texture.sourceHash = hashSourceFile(sourcePath);
+
+    this->padTo(alignOffset(this->offset, TEXTURE_PACK_ALIGNMENT));
+
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        this->padTo(alignOffset(this->offset, TEXTURE_CACHE_ALIGNMENT));
+        entry.texture.levels[i] = { (uint32_t) levels[i].width, (uint32_t) levels[i].height, this->offset, levels[i].data.size() };
+
+        this->file.write((const char*) levels[i].data.data(), levels[i].data.size());
+        this->offset += levels[i].data.size();
+    }
+
+    std::string key = TexturePack::getPackKey(sourcePath);
+    entry.pathSize = key.size();
+    this->paths += key;
+    this->entries.push_back(entry);
+
+    return (bool) this->file;
+}
+
+/* Copies a valid cache's levels as they are, keeping the source it was
+ * cooked from and the flags it was built with. */
+bool TexturePackWriter::add (const char* sourcePath, const TextureCache& cache)
+{
+    if (!this->file || !cache.isWellFormed())
+    {
+        return false;
+    }
+
+    TexturePackEntry entry {};
+    entry.pathOffset = this->paths.size();
+    entry.texture = cache.getHeader();
+
+    this->padTo(alignOffset(this->offset, TEXTURE_PACK_ALIGNMENT));
+
+    for (unsigned int i = 0; i < cache.getLevelCount(); ++i)
+    {
+        this->padTo(alignOffset(this->offset, TEXTURE_CACHE_ALIGNMENT));
+        entry.texture.levels[i].dataOffset = this->offset;
+
+        this->file.write((const char*) cache.getLevelData(i), cache.getLevel(i).dataSize);
+        this->offset += cache.getLevel(i).dataSize;
+    }
+
+    std::string key = TexturePack::getPackKey(sourcePath);
+    entry.pathSize = key.size();
+    this->paths += key;
+    this->entries.push_back(entry);
+
+    return (bool) this->file;
+}
+
+/* Writes the table and the paths after the last chain, then the header, and
+ * moves the finished pack into place. */
+bool TexturePackWriter::finish ()
+{
+    if (!this->file)
+    {
+        std::cerr << "Texture Pack Write Error for '" << this->packPath << "': could not write file" << std::endl;
+        std::remove(this->temporaryPath.c_str());
+        return false;
+    }
+
+    TexturePackHeader header {};
+    header.magic = TEXTURE_PACK_MAGIC;
+    header.version = TEXTURE_PACK_VERSION;
+    header.entryCount = this->entries.size();
+
+    this->padTo(alignOffset(this->offset, TEXTURE_CACHE_ALIGNMENT));
+    header.entriesOffset = this->offset;
+    this->file.write((const char*) this->entries.data(), this->entries.size() * sizeof(TexturePackEntry));
+    this->offset += this->entries.size() * sizeof(TexturePackEntry);
+
+    header.pathsOffset = this->offset;
+    header.pathsSize = this->paths.size();
+    this->file.write(this->paths.data(), this->paths.size());
+    this->offset += this->paths.size();
+
+    this->file.seekp(0);
+    this->file.write((const char*) &header, sizeof(header));
+    this->file.close();
+
+    if (!this->file || std::rename(this->temporaryPath.c_str(), this->packPath.c_str()) != 0)
+    {
+        std::cerr << "Texture Pack Write Error for '" << this->packPath << "': could not write file" << std::endl;
+        std::remove(this->temporaryPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+const size_t TexturePackWriter::getTextureCount () const
+{
+    return this->entries.size();
+}
+
+const size_t TexturePackWriter::getSize () const
+{
+    return this->offset;
+}
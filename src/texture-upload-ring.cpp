@@ -0,0 +1,187 @@
+#include "texture-upload-ring.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+
+TextureUploadRing::TextureUploadRing (size_t size)
+    : size(size)
+    , head(0)
+    , staging(false)
+    , current { 0, 0, nullptr }
+    , frameStatistics {}
+    , totalStatistics {}
+{
+    glGenBuffers(1, &(this->buffer));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->buffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, this->size, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+TextureUploadRing::~TextureUploadRing ()
+{
+    for (Region& region : this->pending)
+    {
+        glDeleteSync(region.fence);
+    }
+
+    glDeleteBuffers(1, &(this->buffer));
+}
+
+/* Drops regions the GPU is done with, oldest first, without blocking. */
+void TextureUploadRing::retireSignaledRegions ()
+{
+    while (!this->pending.empty())
+    {
+        GLenum status = glClientWaitSync(this->pending.front().fence, 0, 0);
+
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        {
+            break;
+        }
+
+        glDeleteSync(this->pending.front().fence);
+        this->pending.pop_front();
+    }
+}
+
+/* Blocks until no region in flight overlaps the range. Fences signal in the
+ * order they were issued, so waiting on the newest overlapping region retires
+ * every region before it as well. */
+void TextureUploadRing::waitForRegion (size_t offset, size_t size)
+{
+    size_t overlapCount = 0;
+
+    for (size_t i = 0; i < this->pending.size(); ++i)
+    {
+        const Region& region = this->pending[i];
+
+        if (region.offset < offset + size && offset < region.offset + region.size)
+        {
+            overlapCount = i + 1;
+        }
+    }
+
+    if (overlapCount == 0)
+    {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    GLsync fence = this->pending[overlapCount - 1].fence;
+    GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, UPLOAD_RING_WAIT_TIMEOUT);
+
+    while (status == GL_TIMEOUT_EXPIRED)
+    {
+        status = glClientWaitSync(fence, 0, UPLOAD_RING_WAIT_TIMEOUT);
+    }
+
+    double stallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (size_t i = 0; i < overlapCount; ++i)
+    {
+        glDeleteSync(this->pending.front().fence);
+        this->pending.pop_front();
+    }
+
+    ++this->frameStatistics.stallCount;
+    ++this->totalStatistics.stallCount;
+    this->frameStatistics.stallSeconds += stallSeconds;
+    this->totalStatistics.stallSeconds += stallSeconds;
+}
+
+/* Copies the data into the ring and leaves the ring bound as the pixel unpack
+ * buffer. The returned pointer is what the following glTexImage2D or
+ * glTexSubImage2D call should be given, and finish() must come right after
+ * it. Data larger than the whole ring is returned as is and read straight
+ * from client memory. */
+const void* TextureUploadRing::stage (const void* data, size_t dataSize)
+{
+    ++this->frameStatistics.uploadCount;
+    ++this->totalStatistics.uploadCount;
+    this->frameStatistics.bytesUploaded += dataSize;
+    this->totalStatistics.bytesUploaded += dataSize;
+
+    if (dataSize > this->size)
+    {
+        return data;
+    }
+
+    this->retireSignaledRegions();
+
+    size_t offset = this->head;
+
+    if (offset + dataSize > this->size)
+    {
+        offset = 0;
+    }
+
+    this->waitForRegion(offset, dataSize);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->buffer);
+
+    // Unsynchronized is safe because the fences already keep us off regions the GPU still reads.
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, dataSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+    if (!mapped)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return data;
+    }
+
+    std::memcpy(mapped, data, dataSize);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    this->head = (offset + dataSize + UPLOAD_RING_ALIGNMENT - 1) / UPLOAD_RING_ALIGNMENT * UPLOAD_RING_ALIGNMENT;
+    this->current = { offset, dataSize, nullptr };
+    this->staging = true;
+
+    ++this->frameStatistics.ringUploadCount;
+    ++this->totalStatistics.ringUploadCount;
+
+    return (const void*) offset;
+}
+
+/* Fences the staged region and unbinds the ring so later uploads from client
+ * memory are not taken as offsets into it. */
+void TextureUploadRing::finish ()
+{
+    if (!this->staging)
+    {
+        return;
+    }
+
+    this->current.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    this->pending.push_back(this->current);
+    this->staging = false;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void TextureUploadRing::beginFrame ()
+{
+    this->frameStatistics = {};
+}
+
+const size_t TextureUploadRing::getSize () const
+{
+    return this->size;
+}
+
+const TextureUploadStatistics& TextureUploadRing::getFrameStatistics () const
+{
+    return this->frameStatistics;
+}
+
+const TextureUploadStatistics& TextureUploadRing::getTotalStatistics () const
+{
+    return this->totalStatistics;
+}
+
+std::ostream& operator<<(std::ostream& os, const TextureUploadStatistics& statistics)
+{
+    os << statistics.uploadCount << " uploads (" << statistics.ringUploadCount << " through the ring), ";
+    os << std::fixed << std::setprecision(2) << statistics.bytesUploaded / (1024.0 * 1024.0) << " MB, ";
+    os << statistics.stallCount << " stalls taking " << std::setprecision(3) << statistics.stallSeconds * 1000.0 << " ms";
+    return os;
+}
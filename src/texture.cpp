@@ -1,12 +1,88 @@
 #include "texture.hpp"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image/stb_image.h"
-
-#include <filesystem>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <vector>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+uint32_t getTextureProcessingFlags (const TextureOptions& options)
+{
+    return getMipChainFlags(options.mipChain) | (options.useTextureCache ? 1u << 16 : 0);
+}
+
+static GLenum getCompressedInternalFormat (CompressedFormat format)
+{
+    switch (format)
+    {
+        case COMPRESSED_FORMAT_BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case COMPRESSED_FORMAT_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case COMPRESSED_FORMAT_BC4: return GL_COMPRESSED_RED_RGTC1;
+        default: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+}
+
+static bool hasExtension (const char* name)
+{
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+
+    for (GLint i = 0; i < extensionCount; ++i)
+    {
+        const char* extension = (const char*) glGetStringi(GL_EXTENSIONS, i);
 
-Texture::Texture (const char* textureFilePath)
+        if (extension && std::strcmp(extension, name) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* RGTC is core since 3.0, but S3TC is an extension and BPTC only became core
+ * in 4.2. Answers are looked up once; call this on the GL thread. */
+bool isCompressedFormatSupported (CompressedFormat format)
+{
+    static const bool s3tc = hasExtension("GL_EXT_texture_compression_s3tc");
+    static const bool bptc = hasExtension("GL_ARB_texture_compression_bptc")
+        || (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 2));
+
+    switch (format)
+    {
+        case COMPRESSED_FORMAT_BC1:
+        case COMPRESSED_FORMAT_BC3:
+            return s3tc;
+        case COMPRESSED_FORMAT_BC4:
+            return true;
+        case COMPRESSED_FORMAT_BC7:
+            return bptc;
+        default:
+            return false;
+    }
+}
+
+/* Creates the texture object with a single placeholder texel so it can be
+ * bound straight away; upload() later replaces the image in place, which keeps
+ * the id held by materials valid. */
+Texture::Texture (uint32_t placeholderColor)
+    : ready(false)
+    , failed(false)
+    , levelSizes { sizeof(placeholderColor) }
+    , baseLevel(0)
+    , width(1)
+    , height(1)
 {
     glGenTextures(1, &(this->texture));
     glBindTexture(GL_TEXTURE_2D, this->texture);
@@ -16,28 +92,251 @@ Texture::Texture (const char* textureFilePath)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    int width, height, channelCount;
-
-    stbi_set_flip_vertically_on_load(true);
-    stbi_uc* imageData = stbi_load(
-        std::filesystem::path(textureFilePath).c_str(),
-        &width, 
-        &height,
-        &channelCount,
-        STBI_rgb_alpha
-    );
-
-    if (imageData) {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, imageData);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    } else {
+    unsigned char texel [4] = {
+        (unsigned char)(placeholderColor >> 16),
+        (unsigned char)(placeholderColor >> 8),
+        (unsigned char)(placeholderColor),
+        (unsigned char)(placeholderColor >> 24)
+    };
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+}
+
+/* Prefers a texture cache next to the image when it is still valid. Either
+ * way the levels above the quality tier are never read. */
+Texture::Texture (const char* textureFilePath, const TextureOptions& options)
+    : Texture()
+{
+    unsigned int firstLevel = getTextureQuality();
+    std::shared_ptr<TextureCache> cache = options.useTextureCache ? findTextureCache(textureFilePath, getMipChainFlags(options.mipChain)) : nullptr;
+
+    if (cache)
+    {
+        this->upload(*cache, nullptr, 0, firstLevel);
+        return;
+    }
+
+    std::vector<ImageLevel> levels;
+
+    if (!buildMipChain(textureFilePath, options.mipChain, options.useTextureCache, levels, firstLevel)) {
         std::cerr << "Failed to load texture at '" << textureFilePath << "': Are you sure the path is correct?" << std::endl;
         exit(-1);
     }
 
-    stbi_image_free(imageData);
+    this->upload(levels);
+}
+
+Texture::~Texture ()
+{
+    glDeleteTextures(1, &(this->texture));
+}
+
+/* Says which levels an upload of a levelCount long chain has to send. A
+ * texture already holding that chain only needs those above what is resident;
+ * anything else is replaced from the bottom of the chain. */
+unsigned int Texture::beginUpload (unsigned int levelCount)
+{
+    glBindTexture(GL_TEXTURE_2D, this->texture);
+
+    if (this->ready && this->levelSizes.size() == levelCount)
+    {
+        return this->baseLevel;
+    }
+
+    this->levelSizes.assign(levelCount, 0);
+    this->baseLevel = levelCount;
+    return levelCount;
+}
+
+/* The placeholder and single level images keep sampling the base level, so
+ * the mip filter is only switched on once a whole chain is in place. */
+void Texture::finishUpload (unsigned int baseLevel)
+{
+    this->baseLevel = std::min(baseLevel, this->baseLevel);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, this->baseLevel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, this->levelSizes.size() - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->levelSizes.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    this->ready = true;
+}
+
+/* Uploads a mip chain built on the CPU one level at a time, from baseLevel
+ * down to the smallest. With a ring the pixels reach the driver through its
+ * pixel buffer, so the call does not wait for the driver to copy them. */
+void Texture::upload (const std::vector<ImageLevel>& levels, TextureUploadRing* ring, unsigned int baseLevel)
+{
+    baseLevel = std::min(baseLevel, (unsigned int) levels.size() - 1);
+    unsigned int endLevel = this->beginUpload(levels.size());
+
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        this->levelSizes[i] = levels[i].data.size();
+    }
+
+    this->width = levels[0].width;
+    this->height = levels[0].height;
+
+    for (unsigned int i = baseLevel; i < endLevel; ++i)
+    {
+        const void* pixels = ring ? ring->stage(levels[i].data.data(), levels[i].data.size()) : levels[i].data.data();
+        glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, levels[i].width, levels[i].height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+        if (ring)
+        {
+            ring->finish();
+        }
+    }
+
+    this->finishUpload(baseLevel);
+}
+
+/* Uploads the cached levels from baseLevel down as they are. The first
+ * firstLevel levels of the cache are left out altogether, and the one after
+ * them becomes level 0. BC4 only stores red, so it is swizzled to grey to read
+ * like the RGBA image it came from. Drivers without the format get each level
+ * decoded on the CPU and uploaded uncompressed. */
+void Texture::upload (const TextureCache& cache, TextureUploadRing* ring, unsigned int baseLevel, unsigned int firstLevel)
+{
+    CompressedFormat format = cache.getFormat();
+    bool uncompressed = format == COMPRESSED_FORMAT_RGBA8;
+    bool supported = isCompressedFormatSupported(format);
+    std::vector<unsigned char> decoded;
+
+    firstLevel = std::min(firstLevel, cache.getLevelCount() - 1);
+    unsigned int levelCount = cache.getLevelCount() - firstLevel;
+
+    baseLevel = std::min(baseLevel, levelCount - 1);
+    unsigned int endLevel = this->beginUpload(levelCount);
+
+    for (unsigned int i = 0; i < levelCount; ++i)
+    {
+        const TextureCacheLevel& level = cache.getLevel(firstLevel + i);
+        this->levelSizes[i] = uncompressed || supported ? level.dataSize : (size_t) level.width * level.height * TEXTURE_IMAGE_CHANNELS;
+    }
+
+    this->width = cache.getLevel(firstLevel).width;
+    this->height = cache.getLevel(firstLevel).height;
+
+    for (unsigned int i = baseLevel; i < endLevel; ++i)
+    {
+        const TextureCacheLevel& level = cache.getLevel(firstLevel + i);
+        const unsigned char* levelData = cache.getLevelData(firstLevel + i);
+
+        if (uncompressed)
+        {
+            const void* data = ring ? ring->stage(levelData, level.dataSize) : levelData;
+            glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        }
+        else if (supported)
+        {
+            const void* data = ring ? ring->stage(levelData, level.dataSize) : levelData;
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, getCompressedInternalFormat(format), level.width, level.height, 0, level.dataSize, data);
+        }
+        else
+        {
+            decoded.resize((size_t) level.width * level.height * TEXTURE_IMAGE_CHANNELS);
+            decompressImage(format, levelData, level.width, level.height, decoded.data());
+
+            const void* data = ring ? ring->stage(decoded.data(), decoded.size()) : decoded.data();
+            glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        }
+
+        if (ring)
+        {
+            ring->finish();
+        }
+    }
+
+    bool grey = supported && format == COMPRESSED_FORMAT_BC4;
+    GLint swizzle [4] = { GL_RED, grey ? GL_RED : GL_GREEN, grey ? GL_RED : GL_BLUE, grey ? GL_ONE : GL_ALPHA };
+
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    this->finishUpload(baseLevel);
+}
+
+/* Drops the levels above baseLevel by redefining them as empty images, so the
+ * driver can release their storage while the id stays the same. The base level
+ * moves first, which keeps the texture complete throughout. Returns the bytes
+ * freed. */
+size_t Texture::evict (unsigned int baseLevel)
+{
+    baseLevel = std::min(baseLevel, (unsigned int) this->levelSizes.size() - 1);
+
+    if (!this->ready || baseLevel <= this->baseLevel)
+    {
+        return 0;
+    }
+
+    size_t freedSize = 0;
+
+    glBindTexture(GL_TEXTURE_2D, this->texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, baseLevel);
+
+    for (unsigned int i = this->baseLevel; i < baseLevel; ++i)
+    {
+        glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        freedSize += this->levelSizes[i];
+    }
+
+    this->baseLevel = baseLevel;
+    return freedSize;
+}
+
+/* A load that could not be completed leaves whatever the texture holds, the
+ * placeholder or levels already uploaded, in place. */
+void Texture::markFailed ()
+{
+    this->failed = true;
+}
+
+bool Texture::isReady () const
+{
+    return this->ready;
+}
+
+bool Texture::hasFailed () const
+{
+    return this->failed;
+}
+
+const int Texture::getWidth () const
+{
+    return this->width;
+}
+
+const int Texture::getHeight () const
+{
+    return this->height;
+}
+
+const unsigned int Texture::getLevelCount () const
+{
+    return this->levelSizes.size();
+}
+
+const unsigned int Texture::getBaseLevel () const
+{
+    return this->baseLevel;
+}
+
+const size_t Texture::getLevelSize (unsigned int level) const
+{
+    return this->levelSizes[level];
+}
+
+/* The bytes of the levels resident on the GPU, from the base level down. */
+const size_t Texture::getResidentSize () const
+{
+    size_t residentSize = 0;
+
+    for (size_t i = this->baseLevel; i < this->levelSizes.size(); ++i)
+    {
+        residentSize += this->levelSizes[i];
+    }
+
+    return residentSize;
 }
 
 GLuint Texture::getID () {
     return this->texture;
-}
\ No newline at end of file
+}
@@ -0,0 +1,203 @@
+#include "vertex-format.hpp"
+#include "glm/gtc/packing.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+
+#define COMPACT_VERTEX_SIZE 16
+#define POSITION_QUANTIZATION_LEVELS 65535.0f
+
+static glm::vec2 encodeOctahedral (glm::vec3 normal)
+{
+    float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+
+    if (length == 0.0f)
+    {
+        return glm::vec2(0.0f);
+    }
+
+    glm::vec2 encoded = glm::vec2(normal.x, normal.y) / length;
+
+    if (normal.z < 0.0f)
+    {
+        glm::vec2 folded = 1.0f - glm::abs(glm::vec2(encoded.y, encoded.x));
+        encoded.x = encoded.x >= 0.0f ? folded.x : -folded.x;
+        encoded.y = encoded.y >= 0.0f ? folded.y : -folded.y;
+    }
+
+    return encoded;
+}
+
+static glm::vec3 decodeOctahedral (glm::vec2 encoded)
+{
+    glm::vec3 normal (encoded.x, encoded.y, 1.0f - std::fabs(encoded.x) - std::fabs(encoded.y));
+    float fold = glm::max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -fold : fold;
+    normal.y += normal.y >= 0.0f ? -fold : fold;
+    return glm::normalize(normal);
+}
+
+static float angleBetweenDegrees (glm::vec3 a, glm::vec3 b)
+{
+    float lengths = glm::length(a) * glm::length(b);
+    return lengths > 0.0f ? glm::degrees(std::acos(glm::clamp(glm::dot(a, b) / lengths, -1.0f, 1.0f))) : 0.0f;
+}
+
+const VertexLayout makeVertexLayout (VertexFormat format)
+{
+    if (format == VERTEX_FORMAT_FLOAT)
+    {
+        return makeFloatVertexLayout();
+    }
+
+    VertexLayout layout {};
+    layout.stride = COMPACT_VERTEX_SIZE;
+    layout.attributeCount = 3;
+    layout.attributes[0] = { 0, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0 };
+
+    if (format == VERTEX_FORMAT_COMPACT)
+    {
+        layout.attributes[1] = { 1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, 8 };
+    }
+    else
+    {
+        layout.attributes[1] = { 1, 2, GL_SHORT, GL_TRUE, 8 };
+    }
+
+    layout.attributes[2] = { 2, 2, GL_HALF_FLOAT, GL_FALSE, 12 };
+    return layout;
+}
+
+const PositionDequantization makePositionDequantization (VertexFormat format, glm::vec3 boundsMin, glm::vec3 boundsMax)
+{
+    if (format == VERTEX_FORMAT_FLOAT)
+    {
+        return { glm::vec3(0.0f), glm::vec3(1.0f) };
+    }
+
+    return { boundsMin, boundsMax - boundsMin };
+}
+
+/* Compact layouts (16 bytes per vertex):
+ *   0: position as 3 x 16-bit unorm relative to the mesh bounds, 2 bytes padding
+ *   8: normal as 10:10:10:2 snorm, or octahedral 2 x 16-bit snorm
+ *  12: uv coordinate as 2 x half float */
+void quantizeVertices (const Mesh& mesh, VertexFormat format, std::vector<unsigned char>& packedVertices, QuantizationReport& report)
+{
+    size_t vertexCount = mesh.vertexData.size() / VERTEX_DATA_STRIDE;
+    VertexLayout layout = makeVertexLayout(format);
+    PositionDequantization dequantization = makePositionDequantization(format, mesh.boundsMin, mesh.boundsMax);
+
+    packedVertices.assign(vertexCount * layout.stride, 0);
+    report = { layout.stride, 0.0f, 0.0f, 0.0f, 0.0f };
+
+    if (format == VERTEX_FORMAT_FLOAT)
+    {
+        std::memcpy(packedVertices.data(), mesh.vertexData.data(), packedVertices.size());
+        return;
+    }
+
+    glm::vec3 inverseScale;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        inverseScale[i] = dequantization.scale[i] > 0.0f ? 1.0f / dequantization.scale[i] : 0.0f;
+    }
+
+    double positionErrorSum = 0.0;
+
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const float* vertex = &mesh.vertexData[i * VERTEX_DATA_STRIDE];
+        unsigned char* packed = &packedVertices[i * layout.stride];
+
+        glm::vec3 position (vertex[0], vertex[1], vertex[2]);
+        glm::vec3 surfaceNormal (vertex[3], vertex[4], vertex[5]);
+        glm::vec2 uvCoordinate (vertex[6], vertex[7]);
+
+        glm::vec3 normalized = glm::clamp((position - dequantization.offset) * inverseScale, 0.0f, 1.0f);
+        uint16_t quantizedPosition [3];
+
+        for (int j = 0; j < 3; ++j)
+        {
+            quantizedPosition[j] = (uint16_t) std::lround(normalized[j] * POSITION_QUANTIZATION_LEVELS);
+        }
+
+        std::memcpy(packed, quantizedPosition, sizeof(quantizedPosition));
+
+        float normalLength = glm::length(surfaceNormal);
+        glm::vec3 unitNormal = normalLength > 0.0f ? surfaceNormal / normalLength : surfaceNormal;
+        uint32_t packedNormal = format == VERTEX_FORMAT_COMPACT
+            ? glm::packSnorm3x10_1x2(glm::vec4(unitNormal, 0.0f))
+            : glm::packSnorm2x16(encodeOctahedral(unitNormal));
+
+        std::memcpy(packed + 8, &packedNormal, sizeof(packedNormal));
+
+        uint32_t packedUvCoordinate = glm::packHalf2x16(uvCoordinate);
+        std::memcpy(packed + 12, &packedUvCoordinate, sizeof(packedUvCoordinate));
+
+        float decoded [VERTEX_DATA_STRIDE];
+        decodeVertex(packed, format, dequantization, decoded);
+
+        float positionError = glm::length(glm::vec3(decoded[0], decoded[1], decoded[2]) - position);
+        float normalError = angleBetweenDegrees(glm::vec3(decoded[3], decoded[4], decoded[5]), surfaceNormal);
+        float uvCoordinateError = glm::length(glm::vec2(decoded[6], decoded[7]) - uvCoordinate);
+
+        report.maxPositionError = glm::max(report.maxPositionError, positionError);
+        report.maxNormalErrorDegrees = glm::max(report.maxNormalErrorDegrees, normalError);
+        report.maxUvCoordinateError = glm::max(report.maxUvCoordinateError, uvCoordinateError);
+        positionErrorSum += positionError;
+    }
+
+    report.meanPositionError = vertexCount ? (float)(positionErrorSum / vertexCount) : 0.0f;
+}
+
+/* Mirrors the dequantization done in the vertex shaders. */
+void decodeVertex (const unsigned char* packedVertex, VertexFormat format, const PositionDequantization& dequantization, float* vertex)
+{
+    if (format == VERTEX_FORMAT_FLOAT)
+    {
+        std::memcpy(vertex, packedVertex, VERTEX_DATA_STRIDE * sizeof(float));
+        return;
+    }
+
+    uint16_t quantizedPosition [3];
+    uint32_t packedNormal;
+    uint32_t packedUvCoordinate;
+
+    std::memcpy(quantizedPosition, packedVertex, sizeof(quantizedPosition));
+    std::memcpy(&packedNormal, packedVertex + 8, sizeof(packedNormal));
+    std::memcpy(&packedUvCoordinate, packedVertex + 12, sizeof(packedUvCoordinate));
+
+    glm::vec3 position = dequantization.offset + glm::vec3(
+        quantizedPosition[0] / POSITION_QUANTIZATION_LEVELS,
+        quantizedPosition[1] / POSITION_QUANTIZATION_LEVELS,
+        quantizedPosition[2] / POSITION_QUANTIZATION_LEVELS
+    ) * dequantization.scale;
+
+    glm::vec3 surfaceNormal = format == VERTEX_FORMAT_COMPACT
+        ? glm::vec3(glm::unpackSnorm3x10_1x2(packedNormal))
+        : decodeOctahedral(glm::unpackSnorm2x16(packedNormal));
+
+    glm::vec2 uvCoordinate = glm::unpackHalf2x16(packedUvCoordinate);
+
+    vertex[0] = position.x;
+    vertex[1] = position.y;
+    vertex[2] = position.z;
+    vertex[3] = surfaceNormal.x;
+    vertex[4] = surfaceNormal.y;
+    vertex[5] = surfaceNormal.z;
+    vertex[6] = uvCoordinate.x;
+    vertex[7] = uvCoordinate.y;
+}
+
+std::ostream& operator<<(std::ostream& os, const QuantizationReport& report)
+{
+    os << std::setprecision(6);
+    os << report.vertexSize << " bytes per vertex, ";
+    os << "position error max " << report.maxPositionError << " mean " << report.meanPositionError << ", ";
+    os << "normal error max " << report.maxNormalErrorDegrees << " degrees, ";
+    os << "uv error max " << report.maxUvCoordinateError;
+    return os;
+}
@@ -0,0 +1,106 @@
+#include "vertex-index-map.hpp"
+
+#include <algorithm>
+
+#define EMPTY_SLOT -1
+#define MIN_CAPACITY 64
+
+/* Faces tend to reference positions in roughly file order, so the hash keeps
+ * the position index in the high bits to make consecutive lookups land in
+ * neighbouring slots instead of scattering across the whole table. */
+static inline size_t hashVertexKey (const VertexKey& key)
+{
+    return ((size_t)(uint32_t) key.vertex << 2) + (((uint32_t) key.uvCoordinate * 7u + (uint32_t) key.surfaceNormal * 13u) & 3u);
+}
+
+static inline bool operator== (const VertexKey& a, const VertexKey& b)
+{
+    return a.vertex == b.vertex && a.uvCoordinate == b.uvCoordinate && a.surfaceNormal == b.surfaceNormal;
+}
+
+static size_t roundUpCapacity (size_t expectedCount)
+{
+    size_t capacity = MIN_CAPACITY;
+
+    while (capacity < expectedCount * 2)
+    {
+        capacity <<= 1;
+    }
+
+    return capacity;
+}
+
+VertexIndexMap::VertexIndexMap (size_t expectedCount)
+    : slots(roundUpCapacity(expectedCount), Slot { { EMPTY_SLOT, 0, 0 }, 0 })
+    , count(0)
+{
+    this->mask = this->slots.size() - 1;
+}
+
+/* Open addressing with linear probing, kept at most half full. */
+void VertexIndexMap::grow ()
+{
+    std::vector<Slot> oldSlots (this->slots.size() * 2, Slot { { EMPTY_SLOT, 0, 0 }, 0 });
+    oldSlots.swap(this->slots);
+    this->mask = this->slots.size() - 1;
+
+    for (const Slot& slot : oldSlots)
+    {
+        if (slot.key.vertex == EMPTY_SLOT)
+        {
+            continue;
+        }
+
+        size_t position = hashVertexKey(slot.key) & this->mask;
+
+        while (this->slots[position].key.vertex != EMPTY_SLOT)
+        {
+            position = (position + 1) & this->mask;
+        }
+
+        this->slots[position] = slot;
+    }
+}
+
+uint32_t VertexIndexMap::findOrInsert (const VertexKey& key, uint32_t value, bool& inserted)
+{
+    if ((this->count + 1) * 2 > this->slots.size())
+    {
+        this->grow();
+    }
+
+    size_t position = hashVertexKey(key) & this->mask;
+
+    while (true)
+    {
+        Slot& slot = this->slots[position];
+
+        if (slot.key.vertex == EMPTY_SLOT)
+        {
+            slot.key = key;
+            slot.value = value;
+            ++this->count;
+            inserted = true;
+            return value;
+        }
+
+        if (slot.key == key)
+        {
+            inserted = false;
+            return slot.value;
+        }
+
+        position = (position + 1) & this->mask;
+    }
+}
+
+void VertexIndexMap::clear ()
+{
+    std::fill(this->slots.begin(), this->slots.end(), Slot { { EMPTY_SLOT, 0, 0 }, 0 });
+    this->count = 0;
+}
+
+const size_t VertexIndexMap::getCount () const
+{
+    return this->count;
+}
@@ -0,0 +1,72 @@
+#include "worker-pool.hpp"
+
+#include <algorithm>
+
+/* A thread count of zero starts one worker per core. Tasks still queued when
+ * the pool is destroyed are dropped; the ones already running are joined. */
+WorkerPool::WorkerPool (unsigned int threadCount)
+    : stopping(false)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+        this->workers.emplace_back(&WorkerPool::runWorker, this);
+    }
+}
+
+WorkerPool::~WorkerPool ()
+{
+    {
+        std::lock_guard<std::mutex> lock (this->taskMutex);
+        this->stopping = true;
+    }
+
+    this->taskCondition.notify_all();
+
+    for (std::thread& worker : this->workers)
+    {
+        worker.join();
+    }
+}
+
+void WorkerPool::runWorker ()
+{
+    while (true)
+    {
+        std::function<void ()> task;
+
+        {
+            std::unique_lock<std::mutex> lock (this->taskMutex);
+            this->taskCondition.wait(lock, [this]() { return this->stopping || !this->tasks.empty(); });
+
+            if (this->stopping)
+            {
+                return;
+            }
+
+            task = std::move(this->tasks.front());
+            this->tasks.pop_front();
+        }
+
+        task();
+    }
+}
+
+void WorkerPool::enqueue (std::function<void ()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock (this->taskMutex);
+        this->tasks.push_back(std::move(task));
+    }
+
+    this->taskCondition.notify_one();
+}
+
+const unsigned int WorkerPool::getThreadCount () const
+{
+    return this->workers.size();
+}
@@ -0,0 +1,143 @@
+#include "obj-parser.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <iostream>
+#include <string>
+
+#define TEST_THREAD_COUNT 4
+#define TEST_VERTEX_COUNT 300000
+
+struct ParseResult
+{
+    bool succeeded;
+    std::string errors;
+};
+
+/* Every parse runs in a child of its own, with its error output collected
+ * through a pipe. */
+static ParseResult parseInChild (const std::string& source, unsigned int threadCount)
+{
+    int pipeEnds [2];
+
+    if (pipe(pipeEnds) != 0)
+    {
+        std::cerr << "Test Error: could not create pipe" << std::endl;
+        exit(-1);
+    }
+
+    pid_t child = fork();
+
+    if (child == 0)
+    {
+        close(pipeEnds[0]);
+        dup2(pipeEnds[1], STDERR_FILENO);
+
+        Mesh mesh;
+        _exit(parseObjParallel(source.data(), source.size(), "test.obj", threadCount, mesh) ? 0 : 1);
+    }
+
+    close(pipeEnds[1]);
+
+    ParseResult result;
+    char buffer [256];
+    ssize_t readSize;
+
+    while ((readSize = read(pipeEnds[0], buffer, sizeof(buffer))) > 0)
+    {
+        result.errors.append(buffer, readSize);
+    }
+
+    close(pipeEnds[0]);
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    result.succeeded = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+    return result;
+}
+
+/* Vertices fill the first part of the file and faces the rest, so the serial
+ * and the parallel parser both see the face lines. The vertex after the last
+ * face is only defined once that face has been read. */
+static std::string makeSource (bool forwardReference)
+{
+    std::string source;
+
+    for (int i = 0; i < TEST_VERTEX_COUNT; ++i)
+    {
+        source += "v " + std::to_string(i) + " 0.5 -1\n";
+    }
+
+    for (int i = 1; i + 2 <= TEST_VERTEX_COUNT; ++i)
+    {
+        source += "f " + std::to_string(i) + " " + std::to_string(i + 1) + " " + std::to_string(i + 2) + "\n";
+    }
+
+    if (!forwardReference)
+    {
+        source += "v 1 1 1\n";
+    }
+
+    source += "f 1 2 " + std::to_string(TEST_VERTEX_COUNT + 1) + "\n";
+
+    if (forwardReference)
+    {
+        source += "v 1 1 1\n";
+    }
+
+    return source;
+}
+
+static bool check (const char* name, bool passed)
+{
+    std::cout << (passed ? "PASS " : "FAIL ") << name << std::endl;
+    return passed;
+}
+
+int main ()
+{
+    bool passed = true;
+
+    std::string valid = makeSource(false);
+    ParseResult validSerial = parseInChild(valid, 1);
+    ParseResult validParallel = parseInChild(valid, TEST_THREAD_COUNT);
+
+    passed &= check("valid file parses serially", validSerial.succeeded);
+    passed &= check("valid file parses in parallel", validParallel.succeeded);
+
+    Mesh serialMesh;
+    Mesh parallelMesh;
+    parseObjParallel(valid.data(), valid.size(), "test.obj", 1, serialMesh);
+    parseObjParallel(valid.data(), valid.size(), "test.obj", TEST_THREAD_COUNT, parallelMesh);
+
+    passed &= check("parallel mesh matches serial mesh", serialMesh.vertexData == parallelMesh.vertexData && serialMesh.indices == parallelMesh.indices);
+
+    std::string forward = makeSource(true);
+    ParseResult forwardSerial = parseInChild(forward, 1);
+    ParseResult forwardParallel = parseInChild(forward, TEST_THREAD_COUNT);
+
+    passed &= check("forward reference fails serially", !forwardSerial.succeeded);
+    passed &= check("forward reference fails in parallel", !forwardParallel.succeeded);
+    passed &= check("forward reference reports the same error", forwardSerial.errors == forwardParallel.errors);
+
+    // Bad vertices in two chunks, so the worker that finds the later one may
+    // finish first. Only the earlier one may be reported.
+    std::string malformed = valid;
+    malformed.replace(malformed.find("v 1000 "), 6, "v 10x0");
+    malformed.replace(malformed.find("v 200000 "), 8, "v 2000x0");
+    ParseResult malformedSerial = parseInChild(malformed, 1);
+    ParseResult malformedParallel = parseInChild(malformed, TEST_THREAD_COUNT);
+
+    passed &= check("malformed vertex fails serially", !malformedSerial.succeeded);
+    passed &= check("malformed vertex fails in parallel", !malformedParallel.succeeded);
+    passed &= check("malformed vertex reports the same error", malformedSerial.errors == malformedParallel.errors);
+
+    if (!passed)
+    {
+        std::cout << "serial: " << forwardSerial.errors << "parallel: " << forwardParallel.errors;
+        std::cout << "serial: " << malformedSerial.errors << "parallel: " << malformedParallel.errors;
+    }
+
+    return passed ? 0 : -1;
+}
@@ -0,0 +1,177 @@
+#include "texture-cooker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void printUsage ()
+{
+    std::cout
+        << "usage: texture-cook [options] image...\n"
+        << "  --format F        auto, bc1, bc3, bc4, bc7 or rgba8 (auto)\n"
+        << "  --high-quality    let auto pick BC7 for colour images\n"
+        << "  --mip-filter F    box or kaiser (kaiser)\n"
+        << "  --linear          filter colour as linear data, not sRGB\n"
+        << "  --straight-alpha  filter colour without weighting it by alpha\n"
+        << "  --threads N       images cooked at once, 0 for one per core (0)\n"
+        << "Each image is written next to its source as <image>.texcache.\n";
+}
+
+[[noreturn]] static void reportArgumentError (const std::string& message)
+{
+    std::cerr << "Cook Argument Error: " << message << std::endl;
+    printUsage();
+    exit(-1);
+}
+
+int main (int argc, char** argv)
+{
+    TextureCookOptions options;
+    unsigned int threadCount = 0;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+
+        if (argument == "--format" && i + 1 < argc)
+        {
+            std::string format = argv[++i];
+
+            if (format == "auto")
+            {
+                options.format = COMPRESSED_FORMAT_AUTO;
+            }
+            else if (format == "bc1")
+            {
+                options.format = COMPRESSED_FORMAT_BC1;
+            }
+            else if (format == "bc3")
+            {
+                options.format = COMPRESSED_FORMAT_BC3;
+            }
+            else if (format == "bc4")
+            {
+                options.format = COMPRESSED_FORMAT_BC4;
+            }
+            else if (format == "bc7")
+            {
+                options.format = COMPRESSED_FORMAT_BC7;
+            }
+            else if (format == "rgba8")
+            {
+                options.format = COMPRESSED_FORMAT_RGBA8;
+            }
+            else
+            {
+                reportArgumentError("unknown format '" + format + "'");
+            }
+        }
+        else if (argument == "--high-quality")
+        {
+            options.highQuality = true;
+        }
+        else if (argument == "--mip-filter" && i + 1 < argc)
+        {
+            std::string filter = argv[++i];
+
+            if (filter == "box")
+            {
+                options.mipChain.filter = MIP_FILTER_BOX;
+            }
+            else if (filter == "kaiser")
+            {
+                options.mipChain.filter = MIP_FILTER_KAISER;
+            }
+            else
+            {
+                reportArgumentError("unknown mip filter '" + filter + "'");
+            }
+        }
+        else if (argument == "--linear")
+        {
+            options.mipChain.srgb = false;
+        }
+        else if (argument == "--straight-alpha")
+        {
+            options.mipChain.premultiplyAlpha = false;
+        }
+        else if (argument == "--threads" && i + 1 < argc)
+        {
+            threadCount = std::stoul(argv[++i]);
+        }
+        else if (argument == "--help" || argument == "-h")
+        {
+            printUsage();
+            return 0;
+        }
+        else if (argument.rfind("--", 0) == 0)
+        {
+            reportArgumentError("unknown option '" + argument + "'");
+        }
+        else
+        {
+            paths.push_back(argument);
+        }
+    }
+
+    if (paths.empty())
+    {
+        reportArgumentError("no images given");
+    }
+
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::atomic<size_t> next { 0 };
+    std::atomic<int> failedCount { 0 };
+    std::mutex outputMutex;
+    size_t constantCount = 0;
+    size_t savedSize = 0;
+    std::vector<std::thread> workers;
+
+    for (unsigned int t = 0; t < std::min<size_t>(threadCount, paths.size()); ++t)
+    {
+        workers.emplace_back([&]() {
+            for (size_t i = next++; i < paths.size(); i = next++)
+            {
+                TextureCookReport report;
+                bool cooked = cookTexture(paths[i].c_str(), options, report);
+
+                std::lock_guard<std::mutex> lock (outputMutex);
+
+                if (cooked)
+                {
+                    std::cout << paths[i] << ": " << report << std::endl;
+                    constantCount += report.constantChannels == ALL_IMAGE_CHANNELS ? 1 : 0;
+                    savedSize += report.savedSize;
+                }
+                else
+                {
+                    ++failedCount;
+                }
+            }
+        });
+    }
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    if (constantCount > 0)
+    {
+        std::cout << constantCount << " constant images cooked to a single texel, "
+            << std::fixed << std::setprecision(2) << savedSize / (1024.0 * 1024.0) << " MB saved" << std::endl;
+    }
+
+    return failedCount > 0 ? -1 : 0;
+}
@@ -0,0 +1,148 @@
+#include "texture-cooker.hpp"
+#include "texture-pack.hpp"
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void printUsage ()
+{
+    std::cout
+        << "usage: texture-pack [options] --output FILE image...\n"
+        << "  --output FILE     the pack to write, usually ending in " << TEXTURE_PACK_EXTENSION << "\n"
+        << "  --mip-filter F    box or kaiser (kaiser)\n"
+        << "  --linear          filter colour as linear data, not sRGB\n"
+        << "  --straight-alpha  filter colour without weighting it by alpha\n"
+        << "An image with a valid cooked texture cache is packed as cooked, with the\n"
+        << "options it was cooked with; any other image gets an RGBA8 mip chain built\n"
+        << "with the filter options above. Run texture-cook first to pack block-compressed\n"
+        << "levels. Images are looked up by the path given here, so give them as the game\n"
+        << "names them. The game only uses a packed texture loaded with the same options.\n";
+}
+
+[[noreturn]] static void reportArgumentError (const std::string& message)
+{
+    std::cerr << "Pack Argument Error: " << message << std::endl;
+    printUsage();
+    exit(-1);
+}
+
+int main (int argc, char** argv)
+{
+    MipChainOptions options;
+    std::string outputPath;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+
+        if ((argument == "--output" || argument == "-o") && i + 1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+        else if (argument == "--mip-filter" && i + 1 < argc)
+        {
+            std::string filter = argv[++i];
+
+            if (filter == "box")
+            {
+                options.filter = MIP_FILTER_BOX;
+            }
+            else if (filter == "kaiser")
+            {
+                options.filter = MIP_FILTER_KAISER;
+            }
+            else
+            {
+                reportArgumentError("unknown mip filter '" + filter + "'");
+            }
+        }
+        else if (argument == "--linear")
+        {
+            options.srgb = false;
+        }
+        else if (argument == "--straight-alpha")
+        {
+            options.premultiplyAlpha = false;
+        }
+        else if (argument == "--help" || argument == "-h")
+        {
+            printUsage();
+            return 0;
+        }
+        else if (argument.rfind("-", 0) == 0)
+        {
+            reportArgumentError("unknown option '" + argument + "'");
+        }
+        else
+        {
+            paths.push_back(argument);
+        }
+    }
+
+    if (outputPath.empty())
+    {
+        reportArgumentError("no output given");
+    }
+
+    if (paths.empty())
+    {
+        reportArgumentError("no images given");
+    }
+
+    TexturePackWriter writer (outputPath.c_str());
+    size_t cookedCount = 0;
+
+    for (const std::string& path : paths)
+    {
+        std::string cachePath = TextureCache::getCachePath(path.c_str());
+        bool added = false;
+
+        if (TextureCache::exists(cachePath.c_str()))
+        {
+            TextureCache cache (cachePath.c_str());
+
+            if (cache.isValidFor(path.c_str(), cache.getHeader().processingFlags) && writer.add(path.c_str(), cache))
+            {
+                added = true;
+                ++cookedCount;
+                std::cout << path << ": " << getCompressedFormatName(cache.getFormat()) << ", "
+                    << cache.getLevelCount() << " levels, cooked" << std::endl;
+            }
+        }
+
+        if (!added)
+        {
+            std::vector<ImageLevel> levels;
+
+            if (!buildMipChain(path.c_str(), options, false, levels))
+            {
+                std::cerr << "Texture Pack Error for '" << path << "': could not decode image" << std::endl;
+                return -1;
+            }
+
+            if (!writer.add(path.c_str(), COMPRESSED_FORMAT_RGBA8, getMipChainFlags(options), levels))
+            {
+                std::cerr << "Texture Pack Error for '" << path << "': could not add texture" << std::endl;
+                return -1;
+            }
+
+            std::cout << path << ": " << getCompressedFormatName(COMPRESSED_FORMAT_RGBA8) << ", "
+                << levels.size() << " levels" << std::endl;
+        }
+    }
+
+    size_t textureCount = writer.getTextureCount();
+
+    if (!writer.finish())
+    {
+        return -1;
+    }
+
+    std::cout << outputPath << ": " << textureCount << " textures, " << cookedCount << " cooked, "
+        << std::fixed << std::setprecision(2) << writer.getSize() / (1024.0 * 1024.0) << " MB" << std::endl;
+
+    return 0;
+}